@@ -47,6 +47,9 @@
 /* Exported functions ------------------------------------------------------- */
 
 void SysTick_Handler(void);
+void PendSV_Handler(void);
+void HardFault_Handler(void);
+void USART1_IRQHandler(void);
 
 #ifdef __cplusplus
 }
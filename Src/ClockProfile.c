@@ -0,0 +1,237 @@
+// Runtime clock profile manager, see ClockProfile.h
+
+#include "stm32l1xx_hal.h"
+
+#include "ClockProfile.h"
+#include "Trace.h"
+#include "irq_priority.h"
+
+extern I2C_HandleTypeDef hi2c1;
+extern I2C_HandleTypeDef hi2c2;
+extern SPI_HandleTypeDef hspi1;
+extern SPI_HandleTypeDef hspi2;
+extern UART_HandleTypeDef huart1;
+
+const struct clock_profile clock_profiles[CLOCK_NPROFILES] = {
+    // name          sysclk     vr pll hsi msi range       spi max
+    { "idle",        2097000,   3, 0,  0,  RCC_MSIRANGE_5, 8000000 },
+    { "boot",        16000000,  2, 0,  1,  RCC_MSIRANGE_5, 4000000 },
+    { "interactive", 32000000,  1, 1,  1,  RCC_MSIRANGE_5, 8000000 },
+};
+
+// max sysclk with 0 and 1 flash wait states per voltage range (RM0038 table 13)
+static const uint32_t flash_max_hz[3][2] = {
+    { 16000000, 32000000 }, // range 1
+    { 8000000,  16000000 }, // range 2
+    { 2100000,  4200000  }, // range 3
+};
+
+static const uint32_t vrange_reg[3] = {
+    PWR_REGULATOR_VOLTAGE_SCALE1, PWR_REGULATOR_VOLTAGE_SCALE2, PWR_REGULATOR_VOLTAGE_SCALE3
+};
+
+static uint8_t requests[CLOCK_NPROFILES];
+static enum clock_profile_id current = CLOCK_IDLE;
+
+int clock_flash_latency(uint8_t vrange, uint32_t hz)
+{
+    if(vrange < 1 || vrange > 3) return -1;
+    for (int ws = 0; ws < 2; ++ws) {
+        if(hz <= flash_max_hz[vrange - 1][ws]) return ws;
+    }
+    return -1;
+}
+
+uint32_t clock_spi_prescaler(uint32_t pclk_hz, uint32_t max_hz)
+{
+    // BR field 0..7 divides by 2..256
+    uint32_t br = 0;
+    while(br < 7 && (pclk_hz >> (br + 1)) > max_hz) br++;
+    return br << 3;
+}
+
+static void set_vrange(uint8_t vrange)
+{
+    __HAL_PWR_VOLTAGESCALING_CONFIG(vrange_reg[vrange - 1]);
+    while(__HAL_PWR_GET_FLAG(PWR_FLAG_VOS) != RESET);
+}
+
+// BR can only change with the SPI off, it is left as it was found
+static void spi_set_prescaler(SPI_HandleTypeDef *h, uint32_t pclk, uint32_t max_hz)
+{
+    uint32_t spe = h->Instance->CR1 & SPI_CR1_SPE;
+    h->Init.BaudRatePrescaler = clock_spi_prescaler(pclk, max_hz);
+    __HAL_SPI_DISABLE(h);
+    MODIFY_REG(h->Instance->CR1, SPI_CR1_BR, h->Init.BaudRatePrescaler);
+    if(spe) __HAL_SPI_ENABLE(h);
+}
+
+// the timing part of HAL_I2C_Init, without the MSP init or handle state
+// changes, as it runs with interrupts masked and maybe inside a transfer
+static void i2c_set_timing(I2C_HandleTypeDef *h, uint32_t pclk1)
+{
+    uint32_t pe = h->Instance->CR1 & I2C_CR1_PE;
+    uint32_t freqrange = I2C_FREQRANGE(pclk1);
+    __HAL_I2C_DISABLE(h);
+    MODIFY_REG(h->Instance->CR2, I2C_CR2_FREQ, freqrange);
+    MODIFY_REG(h->Instance->TRISE, I2C_TRISE_TRISE, I2C_RISE_TIME(freqrange, h->Init.ClockSpeed));
+    MODIFY_REG(h->Instance->CCR, (I2C_CCR_FS | I2C_CCR_DUTY | I2C_CCR_CCR), I2C_SPEED(pclk1, h->Init.ClockSpeed, h->Init.DutyCycle));
+    if(pe) __HAL_I2C_ENABLE(h);
+}
+
+// the buses keep the dividers they had, fix them up for the new clocks
+void clock_update_peripherals(void)
+{
+    uint32_t spi_max = clock_profiles[current].spi_max_hz;
+    uint32_t pclk2 = HAL_RCC_GetPCLK2Freq();
+    uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+
+    if(hspi1.State != HAL_SPI_STATE_RESET) spi_set_prescaler(&hspi1, pclk2, spi_max);
+    if(hspi2.State != HAL_SPI_STATE_RESET) spi_set_prescaler(&hspi2, pclk1, spi_max);
+    // I2C timing registers depend on PCLK1
+    if(hi2c1.State != HAL_I2C_STATE_RESET) i2c_set_timing(&hi2c1, pclk1);
+    if(hi2c2.State != HAL_I2C_STATE_RESET) i2c_set_timing(&hi2c2, pclk1);
+    if(huart1.State != HAL_UART_STATE_RESET) {
+        huart1.Instance->BRR = UART_BRR_SAMPLING16(pclk2, huart1.Init.BaudRate);
+    }
+}
+
+// ready flags polled without HAL_GetTick, which stands still with interrupts
+// masked: ample for the PLL to lock even at the 2MHz of MSI range 5
+#define CLOCK_READY_SPINS 20000
+
+static int wait_cr(uint32_t bits, uint32_t want)
+{
+    for (uint32_t n = 0; n < CLOCK_READY_SPINS; ++n) {
+        if((RCC->CR & bits) == want) return 1;
+        __NOP();
+    }
+    return 0;
+}
+
+// oscillators started and waited for here, so the HAL finds them ready and
+// its tick based waits return at once. Returns 0, or -1 with the system clock
+// left on a source that runs and current unchanged
+static int apply(enum clock_profile_id id)
+{
+    const struct clock_profile *p = &clock_profiles[id];
+    RCC_OscInitTypeDef osc;
+    RCC_ClkInitTypeDef clk;
+    int latency = clock_flash_latency(p->vrange, p->sysclk_hz);
+    if(latency < 0) return -1; // bad table entry
+    int ok = 0;
+
+    // also reached from idle_enter with interrupts already masked
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // let the byte on the wire finish before its baud rate changes
+    if(huart1.State != HAL_UART_STATE_RESET) {
+        while((huart1.Instance->SR & USART_SR_TC) == 0);
+    }
+
+    // raise the core voltage before speeding up
+    uint8_t vr_now = ((PWR->CR & PWR_CR_VOS) == PWR_REGULATOR_VOLTAGE_SCALE1) ? 1 :
+                     ((PWR->CR & PWR_CR_VOS) == PWR_REGULATOR_VOLTAGE_SCALE2) ? 2 : 3;
+    if(p->vrange < vr_now) set_vrange(p->vrange);
+
+    // make sure MSI is running so we can always step through it
+    __HAL_RCC_MSI_ENABLE();
+    if(!wait_cr(RCC_CR_MSIRDY, RCC_CR_MSIRDY)) goto done;
+    if(p->use_hsi) {
+        __HAL_RCC_HSI_ENABLE();
+        if(!wait_cr(RCC_CR_HSIRDY, RCC_CR_HSIRDY)) goto done;
+    }
+    osc.OscillatorType = RCC_OSCILLATORTYPE_MSI;
+    osc.MSIState = RCC_MSI_ON;
+    osc.MSICalibrationValue = 0;
+    osc.MSIClockRange = p->msi_range;
+    osc.PLL.PLLState = RCC_PLL_NONE;
+    if(p->use_hsi) {
+        osc.OscillatorType |= RCC_OSCILLATORTYPE_HSI;
+        osc.HSIState = RCC_HSI_ON;
+        osc.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+    }
+    if(HAL_RCC_OscConfig(&osc) != HAL_OK) goto done;
+    if(p->use_pll) {
+        // the PLL can not be changed while it is the system clock
+        if(__HAL_RCC_GET_SYSCLK_SOURCE() == RCC_CFGR_SWS_PLL) {
+            clk.ClockType = RCC_CLOCKTYPE_SYSCLK;
+            clk.SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
+            if(HAL_RCC_ClockConfig(&clk, FLASH->ACR & FLASH_ACR_LATENCY) != HAL_OK) goto done;
+        }
+        __HAL_RCC_PLL_DISABLE();
+        if(!wait_cr(RCC_CR_PLLRDY, 0)) goto done;
+        __HAL_RCC_PLL_CONFIG(RCC_PLLSOURCE_HSI, RCC_PLL_MUL6, RCC_PLL_DIV3);
+        __HAL_RCC_PLL_ENABLE();
+        if(!wait_cr(RCC_CR_PLLRDY, RCC_CR_PLLRDY)) goto done;
+    }
+
+    clk.ClockType = RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+    clk.SYSCLKSource = p->use_pll ? RCC_SYSCLKSOURCE_PLLCLK : p->use_hsi ? RCC_SYSCLKSOURCE_HSI : RCC_SYSCLKSOURCE_MSI;
+    clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+    clk.APB1CLKDivider = RCC_HCLK_DIV1;
+    clk.APB2CLKDivider = RCC_HCLK_DIV1;
+    // orders the wait state change itself, refuses a source that isn't ready
+    if(HAL_RCC_ClockConfig(&clk, latency) != HAL_OK) goto done;
+    if(latency > 0) __HAL_FLASH_PREFETCH_BUFFER_ENABLE();
+
+    // turn off what is no longer used
+    if(!p->use_pll) __HAL_RCC_PLL_DISABLE();
+    if(!p->use_hsi) __HAL_RCC_HSI_DISABLE();
+
+    // and only then drop the core voltage
+    if(p->vrange > vr_now) set_vrange(p->vrange);
+
+    current = id;
+    ok = 1;
+done:
+    // SysTick reload and bus dividers for the clock we are on, also after a
+    // failure part way, the HAL skips the tick when it bails out early
+    HAL_InitTick(IRQ_PRIO_SYSTICK);
+    clock_update_peripherals();
+
+    __set_PRIMASK(primask);
+    TRACE(TRACE_CLOCK, current, SystemCoreClock);
+    return ok ? 0 : -1;
+}
+
+static int reevaluate(void)
+{
+    enum clock_profile_id want = CLOCK_IDLE;
+    for (int i = CLOCK_NPROFILES - 1; i > CLOCK_IDLE; --i) {
+        if(requests[i] > 0) {
+            want = (enum clock_profile_id)i;
+            break;
+        }
+    }
+    return want != current ? apply(want) : 0;
+}
+
+int clock_init(enum clock_profile_id id)
+{
+    __PWR_CLK_ENABLE();
+    return apply(id);
+}
+
+int clock_request(enum clock_profile_id id)
+{
+    requests[id]++;
+    return reevaluate();
+}
+
+int clock_release(enum clock_profile_id id)
+{
+    if(requests[id] > 0) requests[id]--;
+    return reevaluate();
+}
+
+enum clock_profile_id clock_current(void)
+{
+    return current;
+}
+
+int clock_restore(void)
+{
+    return apply(current);
+}
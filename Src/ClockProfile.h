@@ -0,0 +1,57 @@
+#ifndef CLOCKPROFILE_H
+#define CLOCKPROFILE_H
+
+// Runtime clock profiles.
+// The render path requests CLOCK_INTERACTIVE for bursts of drawing and
+// releases it when idle, the highest requested profile wins and with no
+// requests we drop back to CLOCK_IDLE. Switching takes care of the voltage
+// range and flash wait states ordering and recomputes the SPI/I2C/UART
+// prescalers for the new bus clocks.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum clock_profile_id {
+    CLOCK_IDLE,         // MSI 2.097MHz, range 3
+    CLOCK_BOOT,         // HSI 16MHz, range 2, firmware download and panel init
+    CLOCK_INTERACTIVE,  // HSI/PLL 32MHz, range 1
+    CLOCK_NPROFILES
+};
+
+struct clock_profile {
+    const char *name;
+    uint32_t sysclk_hz;
+    uint8_t vrange;     // voltage range 1 (1.8V) .. 3 (1.2V)
+    uint8_t use_pll;    // HSI*6/3 if set
+    uint8_t use_hsi;    // HSI directly if set, otherwise MSI
+    uint32_t msi_range; // RCC_MSIRANGE_x when on MSI
+    uint32_t spi_max_hz; // RA8875 SPI limit, lower before its PLL is running
+};
+
+extern const struct clock_profile clock_profiles[CLOCK_NPROFILES];
+
+// table lookups, no hardware access
+// returns the flash wait states for hz in the voltage range, -1 if hz is too fast for it
+int clock_flash_latency(uint8_t vrange, uint32_t hz);
+// returns the SPI_BAUDRATEPRESCALER_x giving the fastest clock not above max_hz
+uint32_t clock_spi_prescaler(uint32_t pclk_hz, uint32_t max_hz);
+
+// these return 0, or -1 when an oscillator didn't start: the profile stays
+// what it was, the next request or release tries again
+int clock_init(enum clock_profile_id id);
+int clock_request(enum clock_profile_id id);
+int clock_release(enum clock_profile_id id);
+enum clock_profile_id clock_current(void);
+// put back the current profile, eg after Stop which leaves us on MSI
+int clock_restore(void);
+// recompute the bus prescalers, call once the peripherals are initialised
+void clock_update_peripherals(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
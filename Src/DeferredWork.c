@@ -0,0 +1,110 @@
+// Lock free deferred work queue, see DeferredWork.h
+//
+// Single producer/single consumer: all posters run at the same preemption
+// priority (IRQ_PRIO_EXTI) so can never interrupt each other and behave as one
+// producer, which only writes head. The consumer (PendSV or main loop) only
+// writes tail.
+
+#include "stm32l1xx_hal.h"
+
+#include "DeferredWork.h"
+#include "irq_priority.h"
+#include "cycles.h"
+
+struct work_item {
+    work_fn_t fn;
+    uint32_t arg;
+#if WORK_MEASURE_LATENCY
+    uint32_t posted; // cycle stamp
+#endif
+};
+
+static struct work_item queue[WORK_QUEUE_SIZE];
+static volatile uint8_t head, tail;
+static volatile uint32_t dropped;
+
+#if WORK_MEASURE_LATENCY
+static struct work_stats isr_stats, dispatch_stats;
+static uint32_t isr_start;
+
+static void update_stats(struct work_stats *s, uint32_t d)
+{
+    if(s->count == 0 || d < s->min) s->min = d;
+    if(d > s->max) s->max = d;
+    s->total += d;
+    s->count++;
+}
+
+void work_isr_enter(void)
+{
+    isr_start = cycles_now();
+}
+
+void work_isr_exit(void)
+{
+    update_stats(&isr_stats, cycles_now() - isr_start);
+}
+
+void work_get_stats(struct work_stats *isr, struct work_stats *dispatch)
+{
+    __disable_irq();
+    *isr = isr_stats;
+    *dispatch = dispatch_stats;
+    __enable_irq();
+}
+#endif
+
+void work_init(void)
+{
+#if WORK_MEASURE_LATENCY
+    cycles_init();
+#endif
+    HAL_NVIC_SetPriority(PendSV_IRQn, IRQ_PRIO_PENDSV, 0);
+}
+
+int work_post(work_fn_t fn, uint32_t arg)
+{
+    uint8_t h = head;
+    uint8_t next = (h + 1) & (WORK_QUEUE_SIZE - 1);
+    if(next == tail) {
+        dropped++;
+        return 0;
+    }
+
+    queue[h].fn = fn;
+    queue[h].arg = arg;
+#if WORK_MEASURE_LATENCY
+    queue[h].posted = cycles_now();
+#endif
+    __DMB(); // item must be visible before head moves
+    head = next;
+
+#if !WORK_RUN_IN_MAIN
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+    return 1;
+}
+
+void work_run_pending(void)
+{
+    while(tail != head) {
+        uint8_t t = tail;
+        struct work_item w = queue[t];
+        __DMB();
+        tail = (t + 1) & (WORK_QUEUE_SIZE - 1);
+#if WORK_MEASURE_LATENCY
+        update_stats(&dispatch_stats, cycles_now() - w.posted);
+#endif
+        w.fn(w.arg);
+    }
+}
+
+int work_pending(void)
+{
+    return head != tail;
+}
+
+uint32_t work_get_dropped(void)
+{
+    return dropped;
+}
@@ -0,0 +1,60 @@
+#ifndef DEFERREDWORK_H
+#define DEFERREDWORK_H
+
+// Deferred work (bottom half) queue.
+// ISRs capture the minimum of state and post a work item, the work then runs
+// in PendSV at the lowest priority (or from the main loop) where it is free to
+// do blocking HAL I2C/SPI as SysTick and the completion interrupts preempt it.
+// See irq_priority.h for the priority map.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// set to 1 to run the work from the main loop instead of PendSV
+#ifndef WORK_RUN_IN_MAIN
+#define WORK_RUN_IN_MAIN 0
+#endif
+
+// set to 1 to time ISRs and ISR->work dispatch with the DWT cycle counter
+#ifndef WORK_MEASURE_LATENCY
+#define WORK_MEASURE_LATENCY 0
+#endif
+
+#define WORK_QUEUE_SIZE 16 // must be a power of 2
+
+typedef void (*work_fn_t)(uint32_t arg);
+
+struct work_stats {
+    uint32_t count;
+    uint32_t min, max; // cycles
+    uint32_t total;
+};
+
+void work_init(void);
+// post from an ISR at IRQ_PRIO_EXTI, returns 0 if the queue was full
+int work_post(work_fn_t fn, uint32_t arg);
+// runs everything queued, called from PendSV_Handler or the main loop
+void work_run_pending(void);
+int work_pending(void);
+uint32_t work_get_dropped(void);
+
+#if WORK_MEASURE_LATENCY
+void work_isr_enter(void);
+void work_isr_exit(void);
+// isr: time spent in the top half, dispatch: post to start of work
+void work_get_stats(struct work_stats *isr, struct work_stats *dispatch);
+#define WORK_ISR_ENTER() work_isr_enter()
+#define WORK_ISR_EXIT()  work_isr_exit()
+#else
+#define WORK_ISR_ENTER()
+#define WORK_ISR_EXIT()
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
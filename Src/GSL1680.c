@@ -26,6 +26,10 @@ pin | function  | Arduino Uno
 // TODO define for other resolution
 #include "gslX680firmware.h"
 #include "GSL1680.h"
+#include "DeferredWork.h"
+#include "Log.h"
+#include "Latency.h"
+#include "Trace.h"
 
 // Pins
 #define WAKE_PIN      GPIO_PIN_2
@@ -70,7 +74,7 @@ bool i2c_write(uint8_t reg, uint8_t *buf, int cnt)
     memcpy(&pData[1], buf, cnt);
     HAL_StatusTypeDef r = HAL_I2C_Master_Transmit(&hi2c1, GSLX680_I2C_ADDR, pData, cnt + 1, 1000);
     if(r != HAL_OK) {
-        printf("i2c write error: %d %02X\r\n", r, reg);
+        log_printf("i2c write error: %d %02X\r\n", r, reg);
     }
     return r == HAL_OK;
 }
@@ -79,6 +83,7 @@ uint32_t i2c_read_errors= 0;
 int i2c_read(uint8_t reg, uint8_t *buf, int cnt)
 {
     HAL_StatusTypeDef r;
+    TRACE(TRACE_I2C_START, reg, cnt);
     r = HAL_I2C_Master_Transmit(&hi2c1, GSLX680_I2C_ADDR, &reg, 1, 1000);
     if(r != 0) {
         //printf("i2c read1 error: %d %02X\r\n", r, reg);
@@ -90,6 +95,7 @@ int i2c_read(uint8_t reg, uint8_t *buf, int cnt)
         //printf("i2c read2 error: %d %02X\r\n", r, reg);
         i2c_read_errors++;
     }
+    TRACE(TRACE_I2C_DONE, reg, r);
     return cnt;
 }
 
@@ -288,6 +294,24 @@ void loop()
 }
 
 extern void add_touch_event(struct _ts_event*);
+
+// bottom half of the touch interrupt, runs in PendSV so the blocking I2C
+// read can rely on SysTick for its timeouts, arg is the INT time stamp
+static void touch_work(uint32_t arg)
+{
+    HAL_GPIO_TogglePin(LED3_GPIO_PORT, LED3_PIN);
+    int n = read_data();
+    TRACE(TRACE_TOUCH_DECODED, n, 0);
+    // for(int i = 0; i < n; i++) {
+    //     printf("%d %lu %lu\r\n", ts_event.coords[i].finger, ts_event.coords[i].x, ts_event.coords[i].y);
+    // }
+    // printf("---\r\n");
+    if(n > 0) {
+        ts_event.irq_us = arg;
+        add_touch_event(&ts_event);
+    }
+}
+
 /**
   * @brief EXTI line detection callbacks
   * @param GPIO_Pin: Specifies the pins connected EXTI line
@@ -296,17 +320,12 @@ extern void add_touch_event(struct _ts_event*);
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
     if (GPIO_Pin == INTRPT_PIN) {
-        HAL_GPIO_TogglePin(LED3_GPIO_PORT, LED3_PIN);
-        int n = read_data();
-        // for(int i = 0; i < n; i++) {
-        //     printf("%d %lu %lu\r\n", ts_event.coords[i].finger, ts_event.coords[i].x, ts_event.coords[i].y);
-        // }
-        // printf("---\r\n");
-        if(n > 0) {
-            add_touch_event(&ts_event);
-        }
+        TRACE(TRACE_TOUCH_IRQ, 0, 0);
+        work_post(touch_work, latency_now_us());
+    }else if (GPIO_Pin == GPIO_PIN_0) {
+        // user button, only used to wake up from Stop, the main loop polls it
 
     }else{
-        printf("Unknown interrupt pin: %d\r\n", GPIO_Pin);
+        log_printf("Unknown interrupt pin: %d\r\n", GPIO_Pin);
     }
 }
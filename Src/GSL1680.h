@@ -6,4 +6,5 @@ struct _coord {
 struct _ts_event {
     uint8_t  n_fingers;
     struct _coord coords[5];
+    uint32_t irq_us; // latency_now_us() when the INT fired
 };
@@ -0,0 +1,185 @@
+// Low power idle manager, see IdleManager.h
+
+#include "stm32l1xx_hal.h"
+
+#include "IdleManager.h"
+#include "ClockProfile.h"
+#include "Trace.h"
+#include "irq_priority.h"
+
+// RTC clocked from the LSI (~37KHz) as there is no LSE fitted
+#define LSI_HZ          37000
+// wakeup timer runs at RTC/16
+#define WUT_HZ          (LSI_HZ / 16)
+// sub second counter, the asynchronous prescaler at its minimum of 2 for the
+// finest resolution (54us) the synchronous one allows
+#define RTC_SS_HZ       (LSI_HZ / 2)
+#define RTC_DAY_TICKS   (24UL * 3600 * RTC_SS_HZ)
+
+static uint32_t last_activity;
+static uint32_t wake_ticks;
+static uint8_t wake_pending;
+static struct idle_stats stats;
+
+enum idle_mode idle_policy(int work_pending, uint32_t ms_since_activity, uint32_t ms_to_deadline)
+{
+    if(work_pending) return IDLE_NONE;
+    if(ms_to_deadline == 0) return IDLE_NONE;
+    if(ms_to_deadline < IDLE_STOP_MIN_MS) return IDLE_SLEEP;
+    if(ms_since_activity < IDLE_STOP_HOLDOFF_MS) return IDLE_SLEEP;
+    return IDLE_STOP;
+}
+
+// the calendar is only used to measure how long we were in Stop and how long
+// it takes to draw after a wake, independent of what the core clock did since
+static void rtc_init(void)
+{
+    __PWR_CLK_ENABLE();
+    PWR->CR |= PWR_CR_DBP;
+
+    RCC->CSR |= RCC_CSR_LSION;
+    while((RCC->CSR & RCC_CSR_LSIRDY) == 0);
+    RCC->CSR |= RCC_CSR_RTCSEL_LSI | RCC_CSR_RTCEN;
+
+    RTC->WPR = 0xCA;
+    RTC->WPR = 0x53;
+    RTC->ISR |= RTC_ISR_INIT;
+    while((RTC->ISR & RTC_ISR_INITF) == 0);
+    RTC->PRER = ((LSI_HZ / RTC_SS_HZ - 1) << 16);
+    RTC->PRER |= RTC_SS_HZ - 1;
+    RTC->ISR &= ~RTC_ISR_INIT;
+
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUCKSEL); // WUCKSEL 0 is RTC/16
+    RTC->CR |= RTC_CR_WUTIE;
+    RTC->WPR = 0xFF;
+
+    // wakeup timer is routed through EXTI line 20
+    EXTI->IMR |= EXTI_IMR_MR20;
+    EXTI->RTSR |= EXTI_RTSR_TR20;
+    HAL_NVIC_SetPriority(RTC_WKUP_IRQn, IRQ_PRIO_EXTI, 0);
+    HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+}
+
+// time of day in sub second ticks
+static uint32_t rtc_ticks(void)
+{
+    RTC->ISR &= ~RTC_ISR_RSF; // shadow registers are stale after Stop
+    while((RTC->ISR & RTC_ISR_RSF) == 0);
+    uint32_t ss = RTC->SSR; // locks TR until DR is read
+    uint32_t tr = RTC->TR;
+    (void)RTC->DR;
+    uint32_t h = ((tr >> 20) & 0x3) * 10 + ((tr >> 16) & 0xF);
+    uint32_t m = ((tr >> 12) & 0x7) * 10 + ((tr >> 8) & 0xF);
+    uint32_t s = ((tr >> 4) & 0x7) * 10 + (tr & 0xF);
+    return (h * 3600 + m * 60 + s) * RTC_SS_HZ + (RTC_SS_HZ - 1 - ss);
+}
+
+static uint32_t rtc_ticks_since(uint32_t start)
+{
+    uint32_t end = rtc_ticks();
+    if(end < start) end += RTC_DAY_TICKS;
+    return end - start;
+}
+
+static void wakeup_timer_start(uint32_t ms)
+{
+    uint32_t n = ms * WUT_HZ / 1000;
+    if(n > 0xFFFF) n = 0xFFFF;
+    if(n == 0) n = 1;
+    RTC->WPR = 0xCA;
+    RTC->WPR = 0x53;
+    RTC->CR &= ~RTC_CR_WUTE;
+    while((RTC->ISR & RTC_ISR_WUTWF) == 0);
+    RTC->WUTR = n - 1;
+    RTC->ISR &= ~RTC_ISR_WUTF;
+    RTC->CR |= RTC_CR_WUTE;
+    RTC->WPR = 0xFF;
+}
+
+static void wakeup_timer_stop(void)
+{
+    RTC->WPR = 0xCA;
+    RTC->WPR = 0x53;
+    RTC->CR &= ~RTC_CR_WUTE;
+    RTC->ISR &= ~RTC_ISR_WUTF;
+    RTC->WPR = 0xFF;
+    EXTI->PR = EXTI_IMR_MR20;
+}
+
+void RTC_WKUP_IRQHandler(void)
+{
+    // nothing to do, it only wakes us up
+    RTC->ISR &= ~RTC_ISR_WUTF;
+    EXTI->PR = EXTI_IMR_MR20;
+}
+
+void idle_init(void)
+{
+    rtc_init();
+    last_activity = HAL_GetTick();
+}
+
+void idle_activity(void)
+{
+    last_activity = HAL_GetTick();
+}
+
+// Stop gates the core clock and SysTick, bring back the clocks and the buses
+// that were set up for them before anything else runs
+static void restore_after_stop(uint32_t stopped_ms)
+{
+    clock_restore();
+
+    // SysTick did not run, catch the HAL tick up
+    while(stopped_ms--) HAL_IncTick();
+    HAL_ResumeTick();
+}
+
+void idle_enter(int work_pending, uint32_t ms_to_deadline)
+{
+    enum idle_mode m = idle_policy(work_pending, HAL_GetTick() - last_activity, ms_to_deadline);
+    if(m != IDLE_NONE) TRACE(TRACE_IDLE_ENTER, m, HAL_GetTick());
+
+    if(m == IDLE_SLEEP) {
+        stats.sleeps++;
+        // SysTick keeps running and wakes us each ms, WFI wakes with PRIMASK set
+        HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+
+    }else if(m == IDLE_STOP) {
+        stats.stops++;
+        uint32_t start = rtc_ticks();
+        wakeup_timer_start(ms_to_deadline);
+        HAL_SuspendTick();
+        HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+        uint32_t stopped = rtc_ticks_since(start);
+        wake_ticks = (start + stopped) % RTC_DAY_TICKS;
+        // only a touch or the button is expected to lead to a pixel
+        wake_pending = (RTC->ISR & RTC_ISR_WUTF) == 0;
+        wakeup_timer_stop();
+        restore_after_stop((uint64_t)stopped * 1000 / RTC_SS_HZ);
+    }
+
+    if(m != IDLE_NONE) TRACE(TRACE_IDLE_EXIT, m, HAL_GetTick());
+
+    // any pending interrupt that woke us is now taken
+    __enable_irq();
+}
+
+void idle_pixel_drawn(void)
+{
+    if(!wake_pending) return;
+    wake_pending = 0;
+
+    // the clock changes on the way, from MSI to whatever the drawing asked for
+    uint32_t us = (uint64_t)rtc_ticks_since(wake_ticks) * 1000000 / RTC_SS_HZ;
+    if(stats.wakes == 0 || us < stats.wake_min_us) stats.wake_min_us = us;
+    if(us > stats.wake_max_us) stats.wake_max_us = us;
+    stats.wake_total_us += us;
+    stats.wakes++;
+    if(us > IDLE_WAKE_BUDGET_US) stats.over_budget++;
+}
+
+void idle_get_stats(struct idle_stats *s)
+{
+    *s = stats;
+}
@@ -0,0 +1,50 @@
+#ifndef IDLEMANAGER_H
+#define IDLEMANAGER_H
+
+// Low power idle.
+// When nothing is pending the MCU goes into Sleep (short waits) or Stop (long
+// waits). Stop wakes on the GSL1680 INT (EXTI1), the user button (EXTI0) or
+// the RTC wakeup timer standing in for the SysTick based deadlines, which do
+// not run in Stop.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// below this the Stop entry/exit and clock restore costs more than it saves
+#define IDLE_STOP_MIN_MS        10
+// stay out of Stop this long after activity, touches come in bursts and
+// waking from Stop adds latency to every report
+#define IDLE_STOP_HOLDOFF_MS    500
+// budget from wake to the first pixel being drawn
+#define IDLE_WAKE_BUDGET_US     5000
+
+enum idle_mode { IDLE_NONE, IDLE_SLEEP, IDLE_STOP };
+
+struct idle_stats {
+    uint32_t sleeps, stops;
+    uint32_t wakes;             // wakes that led to a pixel being drawn
+    uint32_t wake_min_us, wake_max_us, wake_total_us; // on the RTC, 54us steps
+    uint32_t over_budget;
+};
+
+// pure policy, no hardware access
+enum idle_mode idle_policy(int work_pending, uint32_t ms_since_activity, uint32_t ms_to_deadline);
+
+void idle_init(void);
+// note that something happened, holds off Stop mode
+void idle_activity(void);
+// must be called with interrupts disabled (so nothing can slip in between the
+// pending check and the WFI), returns with them enabled
+void idle_enter(int work_pending, uint32_t ms_to_deadline);
+// call when the first pixel after a wake has been drawn
+void idle_pixel_drawn(void);
+void idle_get_stats(struct idle_stats *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+// Touch-to-photon latency, see Latency.h
+
+#include "stm32l1xx_hal.h"
+
+#include "Latency.h"
+#include "Log.h"
+
+uint32_t latency_now_us(void)
+{
+    uint32_t ms, val, load;
+    do {
+        ms= HAL_GetTick();
+        val= SysTick->VAL;
+        load= SysTick->LOAD;
+    } while(ms != HAL_GetTick());
+    // the counter counts down from LOAD once per ms
+    return ms * 1000 + (load - val) * 1000 / (load + 1);
+}
+
+#if LATENCY_MEASURE
+
+// only touched from the main loop
+static uint32_t hist[LATENCY_BUCKETS];
+static uint32_t count, min_us, max_us, total_us;
+
+void latency_record(uint32_t irq_us)
+{
+    uint32_t d= latency_now_us() - irq_us;
+    uint32_t b= d / LATENCY_BUCKET_US;
+    if(b >= LATENCY_BUCKETS) b= LATENCY_BUCKETS - 1;
+    hist[b]++;
+
+    if(count == 0 || d < min_us) min_us= d;
+    if(d > max_us) max_us= d;
+    total_us += d;
+    count++;
+}
+
+// upper edge of the bucket holding the 99th percentile, capped at the max seen
+static uint32_t p99(void)
+{
+    uint32_t want= count - count / 100;
+    uint32_t n= 0;
+    for(int i = 0; i < LATENCY_BUCKETS; i++) {
+        n += hist[i];
+        if(n >= want) {
+            uint32_t edge= (i + 1) * LATENCY_BUCKET_US;
+            return edge < max_us ? edge : max_us;
+        }
+    }
+    return max_us;
+}
+
+void latency_get(struct latency_stats *s)
+{
+    s->count= count;
+    s->min= min_us;
+    s->max= max_us;
+    s->avg= count ? total_us / count : 0;
+    s->p99= count ? p99() : 0;
+}
+
+// the histogram is more than the log ring holds, let the UART make room
+static void wait_for_log(void)
+{
+    while(log_space() < 64);
+}
+
+void latency_dump(void)
+{
+    if(count == 0) return;
+    struct latency_stats s;
+    latency_get(&s);
+    wait_for_log();
+    log_printf("touch->pixel: n %lu, min %lu, avg %lu, p99 %lu, max %lu us\r\n",
+        s.count, s.min, s.avg, s.p99, s.max);
+    for(int i = 0; i < LATENCY_BUCKETS; i++) {
+        if(hist[i] == 0) continue;
+        wait_for_log();
+        if(i == LATENCY_BUCKETS - 1) {
+            log_printf("  %5u+      us: %lu\r\n", i * LATENCY_BUCKET_US, hist[i]);
+        }else{
+            log_printf("  %5u-%5u us: %lu\r\n", i * LATENCY_BUCKET_US, (i + 1) * LATENCY_BUCKET_US, hist[i]);
+        }
+    }
+}
+
+void latency_reset(void)
+{
+    for(int i = 0; i < LATENCY_BUCKETS; i++) hist[i]= 0;
+    count= min_us= max_us= total_us= 0;
+}
+
+#endif
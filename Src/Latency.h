@@ -0,0 +1,50 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+// Touch-to-photon latency.
+// The touch INT is stamped in the EXTI callback, the stamp travels with the
+// report through the work queue and the touch event ring, and the consumer
+// records the difference once the circles for that report have been drawn,
+// or with strokes once the stroke pieces it caused are (see maincpp.cpp).
+// Stamps are microseconds from the HAL tick plus the SysTick count, so they
+// stay valid across clock profile switches (the DWT cycle count does not).
+// When woken from Stop the stamp is taken after the clock restore, the wake
+// up itself is accounted for by the idle manager stats.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// set to 1 to collect the latency histogram
+#ifndef LATENCY_MEASURE
+#define LATENCY_MEASURE 0
+#endif
+
+#define LATENCY_BUCKET_US   250
+#define LATENCY_BUCKETS     64 // the last bucket also holds everything above
+
+struct latency_stats {
+    uint32_t count;
+    uint32_t min, max, avg, p99; // us
+};
+
+// must not be called with interrupts disabled, a pending SysTick would be missed
+uint32_t latency_now_us(void);
+
+#if LATENCY_MEASURE
+// record a report stamped at irq_us as being on screen now
+void latency_record(uint32_t irq_us);
+void latency_get(struct latency_stats *s);
+// histogram and summary to the UART, nothing if empty, waits for room in
+// the log so needs interrupts on
+void latency_dump(void);
+void latency_reset(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
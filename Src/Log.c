@@ -0,0 +1,202 @@
+// Asynchronous buffered UART logging, see Log.h
+//
+// Writers can preempt each other (thread, PendSV, ISRs) but never run in
+// parallel, so space is reserved with LDREX/STREX and the outermost writer
+// publishes everything once all nested writers are done. The TX interrupt is
+// the only reader and only moves tail.
+
+#include "stm32l1xx_hal.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "Log.h"
+#include "Trace.h"
+#include "irq_priority.h"
+#include "cycles.h"
+
+extern UART_HandleTypeDef huart1;
+
+// bit band alias so TXEIE can be flipped without a read-modify-write race
+#define BITBAND_PERI(reg, bit) (*(volatile uint32_t *)(PERIPH_BB_BASE + (((uint32_t)(reg) - PERIPH_BASE) * 32) + ((bit) * 4)))
+#ifndef USART1_TXEIE
+#define USART1_TXEIE BITBAND_PERI(&USART1->CR1, 7)
+#endif
+
+static char ring[LOG_BUFFER_SIZE];
+// free running indices, only the low bits index the ring
+static volatile uint32_t reserved;  // writers have claimed up to here
+static volatile uint32_t committed; // readable up to here
+static volatile uint32_t tail;      // sent up to here
+static volatile uint32_t nesting;   // writers in progress
+static volatile uint32_t dropped;    // messages
+static volatile uint32_t unreported; // bytes dropped since the last note
+
+#if LOG_MEASURE_COST
+static struct log_cost cost;
+#endif
+
+static void atomic_add(volatile uint32_t *p, int32_t v)
+{
+    uint32_t x;
+    do {
+        x = __LDREXW(p);
+    } while(__STREXW(x + v, p));
+}
+
+static uint32_t atomic_take(volatile uint32_t *p)
+{
+    uint32_t x;
+    do {
+        x = __LDREXW(p);
+    } while(__STREXW(0, p));
+    return x;
+}
+
+// called when leaving a writer, the last one out publishes
+static void publish(void)
+{
+    atomic_add(&nesting, -1);
+    uint32_t c;
+    do {
+        c = __LDREXW(&committed);
+        if(nesting != 0) {
+            // a nested writer interrupted us, it will publish when done
+            __CLREX();
+            return;
+        }
+    } while(__STREXW(reserved, &committed));
+
+    if(c != reserved) USART1_TXEIE = 1;
+}
+
+void log_init(void)
+{
+    HAL_NVIC_SetPriority(USART1_IRQn, IRQ_PRIO_UART, 0);
+    HAL_NVIC_EnableIRQ(USART1_IRQn);
+#if LOG_MEASURE_COST
+    cycles_init();
+#endif
+}
+
+int log_write(const char *buf, int len)
+{
+#if LOG_MEASURE_COST
+    uint32_t start = cycles_now();
+#endif
+    uint32_t h;
+    char note[32];
+    int nlen = 0;
+
+    if(len <= 0) return 0;
+
+    // whoever takes the count reports it, ahead of its own line
+    uint32_t lost = atomic_take(&unreported);
+    if(lost) nlen = snprintf(note, sizeof(note), "<%lu bytes dropped>\r\n", lost);
+
+    atomic_add(&nesting, 1);
+    do {
+        h = __LDREXW(&reserved);
+        if(h - tail + nlen + len > LOG_BUFFER_SIZE) {
+            __CLREX();
+            atomic_add(&dropped, 1);
+            atomic_add(&unreported, lost + len);
+            publish();
+            return 0;
+        }
+    } while(__STREXW(h + nlen + len, &reserved));
+
+    for (int i = 0; i < nlen; ++i) {
+        ring[(h + i) & (LOG_BUFFER_SIZE - 1)] = note[i];
+    }
+    h += nlen;
+    for (int i = 0; i < len; ++i) {
+        ring[(h + i) & (LOG_BUFFER_SIZE - 1)] = buf[i];
+    }
+    publish();
+
+#if LOG_MEASURE_COST
+    uint32_t d = cycles_now() - start;
+    if(d > cost.max) cost.max = d;
+    cost.total += d;
+    cost.count++;
+#endif
+    return len;
+}
+
+int log_printf(const char *fmt, ...)
+{
+    char buf[128];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if(n > (int)sizeof(buf) - 1) n = sizeof(buf) - 1;
+    return log_write(buf, n);
+}
+
+void log_tx_irq(void)
+{
+    if((USART1->SR & USART_SR_TXE) == 0) return;
+
+#if TRACE_ENABLED
+    // text has priority, binary trace fills the idle time, but a frame
+    // once started goes out whole so the decoder can resync on it
+    if(tail == committed || trace_in_frame()) {
+        uint8_t c;
+        if(trace_next_byte(&c)) {
+            USART1->DR = c;
+            return;
+        }
+    }
+#endif
+    if(tail == committed) {
+        USART1_TXEIE = 0;
+        return;
+    }
+    USART1->DR = ring[tail & (LOG_BUFFER_SIZE - 1)];
+    tail = tail + 1;
+}
+
+void log_kick(void)
+{
+    USART1_TXEIE = 1;
+}
+
+void log_flush(void)
+{
+    USART1_TXEIE = 0;
+#if TRACE_ENABLED
+    uint8_t c;
+    while(trace_in_frame()) {
+        while((USART1->SR & USART_SR_TXE) == 0);
+        trace_next_byte(&c);
+        USART1->DR = c;
+    }
+#endif
+    while(tail != committed) {
+        while((USART1->SR & USART_SR_TXE) == 0);
+        USART1->DR = ring[tail & (LOG_BUFFER_SIZE - 1)];
+        tail = tail + 1;
+    }
+    while((USART1->SR & USART_SR_TC) == 0);
+}
+
+uint32_t log_get_dropped(void)
+{
+    return dropped;
+}
+
+int log_space(void)
+{
+    return LOG_BUFFER_SIZE - (reserved - tail);
+}
+
+#if LOG_MEASURE_COST
+void log_get_cost(struct log_cost *c)
+{
+    __disable_irq();
+    *c = cost;
+    __enable_irq();
+}
+#endif
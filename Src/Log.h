@@ -0,0 +1,52 @@
+#ifndef LOG_H
+#define LOG_H
+
+// Asynchronous buffered logging on USART1.
+// Writers copy into a lock free ring and return, the USART1 TX interrupt
+// drains it in the background. Safe to call from any ISR. When the ring is
+// full the whole message is dropped and counted rather than blocking, the
+// next line that fits starts with a note of how many bytes were lost.
+// printf/_write go through here.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOG_BUFFER_SIZE 1024 // must be a power of 2
+
+// set to 1 to measure the cycles each caller spends in log_write
+#ifndef LOG_MEASURE_COST
+#define LOG_MEASURE_COST 0
+#endif
+
+void log_init(void);
+// returns len, or 0 if it was dropped
+int log_write(const char *buf, int len);
+int log_printf(const char *fmt, ...) __attribute__ ((format (printf, 1, 2)));
+// polled drain of everything committed, for fault handlers, irqs may be off
+void log_flush(void);
+// called from USART1_IRQHandler
+void log_tx_irq(void);
+// make sure the TX interrupt is running, eg when trace records are queued
+void log_kick(void);
+// messages dropped so far
+uint32_t log_get_dropped(void);
+// bytes free in the ring, a main loop writer with a lot to say can wait for
+// room with it as the TX interrupt drains
+int log_space(void);
+
+#if LOG_MEASURE_COST
+struct log_cost {
+    uint32_t count;
+    uint32_t max, total; // cycles
+};
+void log_get_cost(struct log_cost *c);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+// Binary event tracing, see Trace.h
+//
+// Each record goes out as a frame of
+//   0xA5 0x5A ts(4) id(2) a(2) b(4) sum(1)
+// little endian, sum is the 8 bit sum of the 12 payload bytes, so the
+// decoder can pick frames out from between the text log output.
+
+#include "stm32l1xx_hal.h"
+
+#include "Trace.h"
+
+#if TRACE_ENABLED
+
+#include "Log.h"
+#include "cycles.h"
+
+#define FRAME_SIZE 15
+
+struct trace_record {
+    uint32_t ts;
+    uint32_t b;
+    uint16_t a;
+    volatile uint16_t id; // written last, TRACE_NONE until the record is complete
+};
+
+static struct trace_record records[TRACE_RECORDS];
+static volatile uint32_t head, tail;
+static volatile uint32_t dropped;
+
+static uint8_t frame[FRAME_SIZE];
+static uint8_t frame_pos = FRAME_SIZE;
+
+void trace_init(void)
+{
+    cycles_init();
+}
+
+void trace_event(uint16_t id, uint16_t a, uint32_t b)
+{
+    uint32_t ts = cycles_now();
+    uint32_t h;
+    do {
+        h = __LDREXW(&head);
+        if(h - tail >= TRACE_RECORDS) {
+            __CLREX();
+            dropped++;
+            return;
+        }
+    } while(__STREXW(h + 1, &head));
+
+    struct trace_record *r = &records[h & (TRACE_RECORDS - 1)];
+    r->ts = ts;
+    r->a = a;
+    r->b = b;
+    __DMB();
+    r->id = id;
+    log_kick();
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+int trace_in_frame(void)
+{
+    return frame_pos != 0 && frame_pos != FRAME_SIZE;
+}
+
+// called from the USART1 TX interrupt
+int trace_next_byte(uint8_t *c)
+{
+    if(frame_pos == FRAME_SIZE) {
+        if(tail == head) return 0;
+        struct trace_record *r = &records[tail & (TRACE_RECORDS - 1)];
+        uint16_t id = r->id;
+        if(id == TRACE_NONE) return 0; // still being written, the writer kicks us again
+
+        frame[0] = 0xA5;
+        frame[1] = 0x5A;
+        put32(&frame[2], r->ts);
+        frame[6] = id; frame[7] = id >> 8;
+        frame[8] = r->a; frame[9] = r->a >> 8;
+        put32(&frame[10], r->b);
+        uint8_t sum = 0;
+        for (int i = 2; i < FRAME_SIZE - 1; ++i) sum += frame[i];
+        frame[FRAME_SIZE - 1] = sum;
+
+        r->id = TRACE_NONE;
+        tail = tail + 1;
+        frame_pos = 0;
+    }
+    *c = frame[frame_pos++];
+    return 1;
+}
+
+uint32_t trace_get_dropped(void)
+{
+    return dropped;
+}
+
+#endif
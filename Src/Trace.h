@@ -0,0 +1,60 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Compact binary event tracing.
+// Fixed size records (cycle timestamp, event id, two args) go into a RAM ring
+// and are streamed out of USART1 by the log TX interrupt whenever there is no
+// text to send. tools/trace_decode.rb turns a capture into a timeline and
+// latency histograms.
+// Timestamps are DWT cycles at the current clock, they pause in Sleep/Stop,
+// TRACE_CLOCK and TRACE_IDLE_EXIT let the decoder keep track.
+// Set TRACE_ENABLED to 0 and TRACE() compiles to nothing.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+#define TRACE_RECORDS   128 // must be a power of 2
+
+// keep in step with EVENTS in tools/trace_decode.rb
+enum trace_event_id {
+    TRACE_NONE,         // marks an empty slot, never emitted
+    TRACE_TOUCH_IRQ,    // GSL1680 INT edge
+    TRACE_TOUCH_DECODED,// a: fingers
+    TRACE_I2C_START,    // a: register, b: length
+    TRACE_I2C_DONE,     // a: register, b: HAL status
+    TRACE_SPI_START,    // b: length
+    TRACE_SPI_DONE,     // b: length
+    TRACE_WAITPOLL,     // a: register, b: spins
+    TRACE_FRAME_START,
+    TRACE_FRAME_END,    // b: events handled
+    TRACE_PIXEL,        // a: finger, first engine draw for a report done
+    TRACE_CLOCK,        // a: profile, b: sysclk Hz
+    TRACE_IDLE_ENTER,   // a: idle mode, b: HAL tick
+    TRACE_IDLE_EXIT,    // b: HAL tick
+};
+
+#if TRACE_ENABLED
+void trace_init(void);
+void trace_event(uint16_t id, uint16_t a, uint32_t b);
+// next byte of the framed stream, returns 0 when there is nothing to send
+int trace_next_byte(uint8_t *c);
+// a frame is part way out, the rest has to follow before any text
+int trace_in_frame(void);
+uint32_t trace_get_dropped(void);
+#define TRACE(id, a, b) trace_event((id), (a), (b))
+#else
+#define TRACE(id, a, b) do {} while(0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
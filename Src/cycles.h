@@ -0,0 +1,22 @@
+#ifndef CYCLES_H
+#define CYCLES_H
+
+// DWT cycle counter, used for latency measurements
+#include "stm32l1xx_hal.h"
+
+// shared by trace, log, work and idle stats, the first caller starts it and
+// it is never zeroed again under the others
+static inline void cycles_init(void)
+{
+    if(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) return;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t cycles_now(void)
+{
+    return DWT->CYCCNT;
+}
+
+#endif
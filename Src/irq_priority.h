@@ -0,0 +1,28 @@
+#ifndef IRQ_PRIORITY_H
+#define IRQ_PRIORITY_H
+
+// NVIC priority map, lower number preempts higher number.
+// Uses NVIC_PRIORITYGROUP_4 so all 4 bits are preemption priority and
+// nothing relies on sub priorities.
+//
+//  prio | source                  | notes
+// ------+-------------------------+------------------------------------------
+//   0   | SysTick                 | HAL_GetTick must advance inside everything
+//   1   | DMA1 channels           | transfer complete, keeps streams fed
+//   2   | SPI1/I2C1 event+error   | transfer completion
+//   3   | USART1                  | log/trace TX drain
+//   4   | EXTI0, EXTI1            | capture minimal state and post work only
+//  15   | PendSV                  | deferred work (bottom half), may block on
+//       |                         | HAL I2C/SPI since all of the above preempt
+//
+// Anything that calls work_post() must run at IRQ_PRIO_EXTI, the work queue
+// relies on posters not preempting each other.
+
+#define IRQ_PRIO_SYSTICK    0
+#define IRQ_PRIO_DMA        1
+#define IRQ_PRIO_SPI_I2C    2
+#define IRQ_PRIO_UART       3
+#define IRQ_PRIO_EXTI       4
+#define IRQ_PRIO_PENDSV     15
+
+#endif
@@ -42,6 +42,13 @@
 #include <sys/stat.h>
 #include <sys/times.h>
 #include <sys/unistd.h>
+
+#include "ClockProfile.h"
+#include "DeferredWork.h"
+#include "IdleManager.h"
+#include "Log.h"
+#include "Trace.h"
+#include "irq_priority.h"
 /* USER CODE END Includes */
 
 /* Private variables ---------------------------------------------------------*/
@@ -79,6 +86,7 @@ static void MX_USART1_UART_Init(void);
 
 extern void abort(void)
 {
+	log_flush();
 	__asm volatile ("bkpt #0");
 	while(1);
 }
@@ -171,7 +179,8 @@ int _write(int file, char *ptr, int len) {
     switch (file) {
     case STDOUT_FILENO: /*stdout*/
     case STDERR_FILENO: /* stderr */
-    	HAL_UART_Transmit(&huart1, (uint8_t *)ptr, len, 10000);
+    	// buffered, drained by the USART1 TX interrupt, see Log.c
+    	log_write(ptr, len);
         break;
     default:
         errno = EBADF;
@@ -213,11 +222,27 @@ int main(void)
     extern void setupcpp();
     extern void loopcpp();
 
+    // the MX inits used fixed dividers, fit them to the boot clock
+    clock_request(CLOCK_BOOT);
+    clock_update_peripherals();
+
+    log_init();
+#if TRACE_ENABLED
+    trace_init();
+#endif
+
+    work_init();
+    idle_init();
 
     setup();
     setupcpp();
 
+    clock_release(CLOCK_BOOT);
+
     while(1) {
+#if WORK_RUN_IN_MAIN
+        work_run_pending();
+#endif
         loop();
         loopcpp();
     }
@@ -239,26 +264,8 @@ int main(void)
 void SystemClock_Config(void)
 {
 
-    RCC_OscInitTypeDef RCC_OscInitStruct;
-    RCC_ClkInitTypeDef RCC_ClkInitStruct;
-
-    __PWR_CLK_ENABLE();
-
-    __HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE3);
-
-    RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_MSI;
-    RCC_OscInitStruct.MSIState = RCC_MSI_ON;
-    RCC_OscInitStruct.MSICalibrationValue = 0;
-    RCC_OscInitStruct.MSIClockRange = RCC_MSIRANGE_5;
-    RCC_OscInitStruct.PLL.PLLState = RCC_PLL_NONE;
-    HAL_RCC_OscConfig(&RCC_OscInitStruct);
-
-    RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_SYSCLK;
-    RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_MSI;
-    RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
-    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
-    RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
-    HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_0);
+    // start fast for the touch firmware download and panel init, see ClockProfile.c
+    clock_init(CLOCK_BOOT);
 
     __SYSCFG_CLK_ENABLE();
 
@@ -370,9 +377,9 @@ void MX_GPIO_Init(void)
     __GPIOA_CLK_ENABLE();
     __GPIOB_CLK_ENABLE();
 
-    /*Configure GPIO pin : PA0 */
+    /*Configure GPIO pin : PA0 , interrupt so the user button can wake from Stop */
     GPIO_InitStruct.Pin = GPIO_PIN_0;
-    GPIO_InitStruct.Mode = GPIO_MODE_EVT_RISING;
+    GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
     GPIO_InitStruct.Pull = GPIO_NOPULL;
     GPIO_InitStruct.Speed = GPIO_SPEED_MEDIUM;
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
@@ -408,10 +415,10 @@ void MX_GPIO_Init(void)
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
     /* EXTI interrupt init*/
-    HAL_NVIC_SetPriority(EXTI1_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(EXTI1_IRQn, IRQ_PRIO_EXTI, 0);
     HAL_NVIC_EnableIRQ(EXTI1_IRQn);
 
-    HAL_NVIC_SetPriority(EXTI0_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(EXTI0_IRQn, IRQ_PRIO_EXTI, 0);
     HAL_NVIC_EnableIRQ(EXTI0_IRQn);
 
 
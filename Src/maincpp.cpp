@@ -1,13 +1,41 @@
 // main.cpp
 
 #include "panel/RA8875.h"
+#include "panel/TextField.h"
+#include "panel/TextConsole.h"
+#include "panel/Stroke.h"
 #include "stm32l1xx_hal.h"
 
 #include "GSL1680.h"
+#include "DeferredWork.h"
+#include "IdleManager.h"
+#include "ClockProfile.h"
+#include "Log.h"
+#include "Latency.h"
+#include "Trace.h"
 
 #include <stdio.h>
 
-static RA8875 *tft;
+// set to 1 to draw into the hidden layer and flip, 800x480 then runs at 8bpp
+#ifndef DOUBLE_BUFFER
+#define DOUBLE_BUFFER 0
+#endif
+
+// 1 joins the samples of each finger into a stroke, 0 draws a dot per sample
+#ifndef STROKES
+#define STROKES 1
+#endif
+
+// 1 shows a hardware cursor over the first finger, moving it is 4 register writes
+#ifndef HW_CURSOR
+#define HW_CURSOR 1
+#endif
+
+// panel fixed at compile time, see RA8875Panels.h
+typedef RA8875T<Panel800x480> Display;
+static Display *tft;
+// scrolling console below the stats, 8 lines at font scale 1
+static TextConsole<Display, 50, 8> console;
 extern "C" void setupcpp();
 extern "C" void loopcpp();
 
@@ -22,26 +50,43 @@ void setupcpp()
 }
 
 void testLcd();
+void idle();
 void loopcpp()
 {
     testLcd();
+    idle();
 }
 
 void setupLcd()
 {
 	delay(500);
     printf("RA8875 start\r\n");
-    tft = new RA8875(&hspi1, GPIOA, GPIO_PIN_4);
+    tft = new Display(&hspi1, GPIOA, GPIO_PIN_4);
     //initialization routine
-    tft->begin(RA8875_800x480);
+    tft->begin();
 
     //following it's already by begin function but
     //if you like another background color....
     tft->fillScreen(RA8875_BLACK);//fill screen black
+#if DOUBLE_BUFFER
+    tft->doubleBuffer(true);
+#endif
+
+#if HW_CURSOR
+    // crosshair, the hot spot is 16,16
+    static const char v[]= "                1", h[]= "1111111111111       111111111111";
+    static const char * const crosshair[]= { v, v, v, v, v, v, v, v, v, v, v, v, v, "", "", "",
+                                              h, "", "", "", v, v, v, v, v, v, v, v, v, v, v, v };
+    uint8_t image[256];
+    Display::encodeGraphicCursor(crosshair, 32, image);
+    tft->uploadGraphicCursor(0, image);
+    tft->setGraphicCursorColors(RA8875_BLACK, RA8875_WHITE);
+#endif
 
     tft->setTextColor(RA8875_GREEN);
     tft->setFontScale(1);//font x2
-    tft->printf("RA8875 is alive with %dx%d\n", 800, 600);
+    console.begin(tft, 7 * tft->lineHeight(), RA8875_GREEN, RA8875_BLACK);
+    console.printf("RA8875 is alive with %dx%d\n", tft->width(), tft->height());
 }
 
 
@@ -59,16 +104,70 @@ extern "C" uint32_t i2c_read_errors;
 
 uint32_t fc= 0, time= 0;
 int max_depth= 0;
+// stats overlay, one line each, 50 characters at font scale 1
+static TextField<Display, 50> stats[7]= { {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}, {0, 5}, {0, 6} };
+
+#if STROKES
+// 40 pixels wide like the dots, samples within 4 pixels are skipped, spline smoothed
+static StrokeRenderer<Display, 16> strokes(40, 4);
+#endif
+
+// the circles of the queued reports, drawn as one batch
+static RA8875circle dots[40];
+static int n_dots= 0;
+#if LATENCY_MEASURE
+static uint32_t dots_irq_us[40];
+static int n_reports= 0;
+#endif
+
+static void flushDots()
+{
+	if(n_dots == 0) return;
+	tft->fillCircles(dots, n_dots);
+	n_dots= 0;
+#if LATENCY_MEASURE
+	// the reports are on screen once the batch is done
+	for(int i = 0; i < n_reports; i++) latency_record(dots_irq_us[i]);
+	n_reports= 0;
+#endif
+}
+
+#if HW_CURSOR
+static bool cursor_shown= false;
+#endif
+
+// run at the fast clock while drawing, until idle for a while
+static bool boosted= false;
+static uint32_t last_draw= 0;
 // 15 lines x 49 characters
 void testLcd()
 {
 	int cnt= 0;
+	if(!touch_events.empty() && !boosted) {
+		clock_request(CLOCK_INTERACTIVE);
+		boosted= true;
+	}
+	if(!touch_events.empty()) {
+		TRACE(TRACE_FRAME_START, 0, 0);
+		// the touches are drawn at screen positions, the console area too
+		console.unscroll();
+	}
 	while(!touch_events.empty()) {
 		touch_event_t tse;
 		touch_events.pop_front(tse);
 
-		// display a circle under each finger
+#if HW_CURSOR
+		// the cursor follows the first finger, nothing to draw or erase
+		if(tse.n_fingers > 0) tft->moveGraphicCursor(tse.coords[0].x - 16, tse.coords[0].y - 16);
+		if((tse.n_fingers > 0) != cursor_shown) {
+			cursor_shown= tse.n_fingers > 0;
+			tft->showGraphicCursor(cursor_shown);
+		}
+#endif
+
+		// display a stroke or a circle under each finger
 		if(tse.n_fingers > 0) {
+			if(!STROKES && n_dots + tse.n_fingers > (int)(sizeof(dots)/sizeof(dots[0]))) flushDots();
 		    for(int i = 0; i < tse.n_fingers; i++) {
 	            uint8_t f= tse.coords[i].finger;
 	            uint32_t x= tse.coords[i].x;
@@ -82,31 +181,120 @@ void testLcd()
 					case 5: col= RA8875_WHITE; break;
 					default: col= RA8875_CYAN;
 				}
-				tft->fillCircle(x, y, 20, col);
+#if STROKES
+				strokes.add(tft, f, x, y, col);
+#else
+				dots[n_dots++]= {(int16_t)x, (int16_t)y, 20, col};
+#endif
+				TRACE(TRACE_PIXEL, f, 0);
+				idle_pixel_drawn();
 	        }
+#if LATENCY_MEASURE && STROKES
+			// report to the end of the drawing it caused: with smoothing the cap
+			// at the new sample and the curve up to the previous one, the curve
+			// joins the new sample with the next report
+			latency_record(tse.irq_us);
+#elif LATENCY_MEASURE
+			dots_irq_us[n_reports++]= tse.irq_us;
+#endif
 	    }
+#if STROKES
+		strokes.endReport(tft);
+#endif
 	    cnt++;
 	}
+	flushDots();
+	if(cnt > 0) TRACE(TRACE_FRAME_END, 0, cnt);
 	if(cnt > max_depth) max_depth= cnt;
+	bool drawn= cnt > 0;
+	if(cnt > 0) {
+		idle_activity();
+		last_draw= HAL_GetTick();
+	}
 
     // User button is clear screen
+	static GPIO_PinState last_button= GPIO_PIN_RESET;
 	GPIO_PinState s= HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_0);
 	if(s == GPIO_PIN_SET) {
+#if LATENCY_MEASURE
+		// dump and start a new measurement run
+		latency_dump();
+		latency_reset();
+#endif
 		tft->fillScreen(RA8875_BLACK);
+		for(auto& f : stats) f.invalidate();
+		console.redraw();
+		drawn= true;
+		if(last_button != GPIO_PIN_SET) console.printf("cleared at %lu secs\n", HAL_GetTick() / 1000);
+		idle_pixel_drawn();
+		idle_activity();
 	}
+	last_button= s;
 
 	// display stats every 2 seconds
 	if(HAL_GetTick() > fc) {
 		// (was 59ms) (20ms with block transfer) 11ms with write multiple registers
+		// now only the characters that changed are sent
 		uint32_t s= HAL_GetTick();
 		fc= s + 2000;
 		time+=2;
+		int line= 0;
 	    tft->setTextColor(RA8875_GREEN, RA8875_BLACK);
-		tft->setCursor(0, 0);
-		tft->printf("overflow: %10d\n", touch_events.get_overflow());
-		tft->printf("max_depth: %10d\n", max_depth);
+		stats[line++].printf(tft, "overflow: %6d, max_depth: %6d", touch_events.get_overflow(), max_depth);
 		uint32_t e= HAL_GetTick();
 		uint32_t d=  e-s;
-		tft->printf("time: %6lu secs, %6lu ms, i2c errors: %6lu\n", time, d, i2c_read_errors);
+		stats[line++].printf(tft, "time: %6lu secs, %6lu ms, i2c errors: %6lu", time, d, i2c_read_errors);
+		struct idle_stats is;
+		idle_get_stats(&is);
+		stats[line++].printf(tft, "idle %6lu/%5lu wake %5lu/%5lu us late %lu",
+			is.sleeps, is.stops, is.wake_max_us, is.wakes ? is.wake_total_us/is.wakes : 0, is.over_budget);
+#if DOUBLE_BUFFER
+		stats[line++].printf(tft, "frame: %5lu ms", tft->frameTime());
+#endif
+#if WORK_MEASURE_LATENCY
+		struct work_stats isr, dispatch;
+		work_get_stats(&isr, &dispatch);
+		stats[line++].printf(tft, "isr %5lu/%5lu disp %5lu/%5lu cyc drop %lu",
+			isr.max, isr.count ? isr.total/isr.count : 0,
+			dispatch.max, dispatch.count ? dispatch.total/dispatch.count : 0,
+			work_get_dropped());
+#endif
+#if LOG_MEASURE_COST
+		struct log_cost lc;
+		log_get_cost(&lc);
+		stats[line++].printf(tft, "log: %5lu/%5lu cyc per line, dropped: %lu",
+			lc.max, lc.count ? lc.total/lc.count : 0, log_get_dropped());
+#endif
+#if LATENCY_MEASURE
+		struct latency_stats ls;
+		latency_get(&ls);
+		stats[line++].printf(tft, "touch: %5lu/%5lu/%5lu/%5lu us n %lu",
+			ls.min, ls.avg, ls.p99, ls.max, ls.count);
+#endif
+		(void)line;
+		drawn= true;
 	}
+
+#if DOUBLE_BUFFER
+	// show the frame, the new back buffer starts as a copy of it
+	if(drawn) tft->flip(true);
+#else
+	(void)drawn;
+#endif
+}
+
+// sleep until the next touch, button press or stats update
+void idle()
+{
+	uint32_t now= HAL_GetTick();
+	uint32_t ms_to_deadline= fc > now ? fc - now : 0;
+
+	if(boosted && now - last_draw > IDLE_STOP_HOLDOFF_MS) {
+		clock_release(CLOCK_INTERACTIVE);
+		boosted= false;
+	}
+
+	__disable_irq();
+	int pending= !touch_events.empty() || work_pending() || HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_0) == GPIO_PIN_SET;
+	idle_enter(pending, ms_to_deadline);
 }
@@ -0,0 +1,217 @@
+/*
+	Anti-aliased proportional fonts rendered in software.
+	The glyphs are 2 or 4 bit coverage maps in flash, made on the host by
+	tools/font_convert.rb from a BDF font. A string is cut into runs of up
+	to ROW pixels; each run is one pixel window (beginPixels) filled row by
+	row: the coverage of the glyphs in the row goes into a line buffer,
+	then out as colors blended between foreground and background, so
+	nothing is read back from the chip and the background must be known.
+	A window reaches as far as the ink of its glyphs, past the advance
+	where a glyph overhangs, and runs are cut only between characters no
+	glyph overhangs, unless a run can't fit the line buffer otherwise.
+	Kerning pairs are applied between characters, the width of the last
+	measured strings is kept (FONT_MEASURED of them, up to
+	FONT_MEASURED_LEN characters).
+*/
+
+#ifndef _FONT_H_
+#define _FONT_H_
+
+#include <stdint.h>
+#include <string.h>
+
+// strings whose width is remembered
+#define FONT_MEASURED	8
+// longest string whose width is remembered
+#define FONT_MEASURED_LEN	24
+// pixels sent per transaction
+#define FONT_CHUNK		64
+
+struct FontGlyph {
+	uint32_t offset;	// into bitmaps, rows packed without padding, first pixel in the high bits
+	uint8_t w, h;
+	int8_t x, y;		// top left from the pen on the baseline
+	uint8_t advance;
+};
+
+struct FontKern { uint8_t left, right; int8_t dx; };
+
+struct FontFace {
+	uint8_t bpp;			// 2 or 4
+	uint8_t first, last;	// character codes of the glyphs
+	uint8_t height, ascent;	// line height, baseline from the top of the line
+	const FontGlyph *glyphs;
+	const uint8_t *bitmaps;
+	const FontKern *kerns;	// sorted by left then right
+	uint16_t nkerns;
+};
+
+// ROW pixels of line buffer, a byte each
+template<class Display, uint16_t ROW>
+class FontRenderer {
+ public:
+	FontRenderer() : _next(0) { memset(_measured, 0, sizeof(_measured)); }
+
+	// advance width of a string with kerning
+	int16_t width(const FontFace *f, const char *s) {
+		uint16_t len = strlen(s);
+		uint32_t h = hash(s, len);
+		for (uint8_t i = 0; i < FONT_MEASURED; i++) {
+			const Measured &m = _measured[i];
+			if (m.face == f && m.hash == h && m.len == len && memcmp(m.text, s, len) == 0) return m.width;
+		}
+		int16_t w = 0;
+		for (uint16_t i = 0; i < len; i++) w += advance(f, s[i], s[i + 1]);
+		if (len > FONT_MEASURED_LEN) return w;
+		Measured &m = _measured[_next];
+		_next = (_next + 1) % FONT_MEASURED;
+		m.face = f;
+		m.hash = h;
+		m.len = len;
+		memcpy(m.text, s, len);
+		m.width = w;
+		return w;
+	}
+
+	// draw with the top of the line at y, returns the pen x after the string
+	int16_t draw(Display *d, const FontFace *f, int16_t x, int16_t y, const char *s, uint16_t fg, uint16_t bg) {
+		uint16_t pal[16];
+		palette(f, fg, bg, pal);
+		uint16_t len = strlen(s);
+		uint16_t i = 0;
+		while (i < len) {
+			// characters whose ink fits in the line buffer, at least one,
+			// up to the last place no glyph overhangs
+			uint16_t j = i, cut = i;
+			int16_t pen = 0, left = 0, right = 0;
+			int16_t cutPen = 0, cutLeft = 0, cutRight = 0;
+			while (j < len) {
+				const FontGlyph *g = glyph(f, s[j]);
+				int16_t a = advance(f, s[j], j + 1 < len ? s[j + 1] : 0);
+				int16_t l = left, r = right > pen + a ? right : pen + a;
+				if (g != 0 && pen + g->x < l) l = pen + g->x;
+				if (g != 0 && pen + g->x + g->w > r) r = pen + g->x + g->w;
+				if (j > i && r - l > ROW) break;
+				left = l;
+				right = r;
+				pen += a;
+				j++;
+				const FontGlyph *n = j < len ? glyph(f, s[j]) : 0;
+				if (j == len || (right <= pen && (n == 0 || n->x >= 0))) {
+					cut = j;
+					cutPen = pen; cutLeft = left; cutRight = right;
+				}
+			}
+			if (cut == i) {//overhangs all the way, cut where it's full
+				cut = j;
+				cutPen = pen; cutLeft = left; cutRight = right;
+			}
+			if (cutRight - cutLeft > ROW) cutRight = cutLeft + ROW;
+			run(d, f, x, y, cutLeft, cutRight - cutLeft, s + i, cut - i, pal);
+			x += cutPen;
+			i = cut;
+		}
+		return x;
+	}
+
+ private:
+	struct Measured {
+		const FontFace *face;
+		uint32_t hash;
+		uint16_t len;
+		int16_t width;
+		char text[FONT_MEASURED_LEN];
+	};
+
+	const FontGlyph *glyph(const FontFace *f, char c) const {
+		uint8_t u = c;
+		if (u < f->first || u > f->last) return 0;
+		return &f->glyphs[u - f->first];
+	}
+
+	int16_t advance(const FontFace *f, char c, char next) const {
+		const FontGlyph *g = glyph(f, c);
+		if (g == 0) return 0;
+		return g->advance + kern(f, c, next);
+	}
+
+	// binary search of the pair
+	static int8_t kern(const FontFace *f, char left, char right) {
+		if (right == 0) return 0;
+		uint16_t key = ((uint8_t)left << 8) | (uint8_t)right;
+		int16_t lo = 0, hi = f->nkerns - 1;
+		while (lo <= hi) {
+			int16_t mid = (lo + hi) / 2;
+			const FontKern &k = f->kerns[mid];
+			uint16_t mk = (k.left << 8) | k.right;
+			if (mk == key) return k.dx;
+			if (mk < key) lo = mid + 1; else hi = mid - 1;
+		}
+		return 0;
+	}
+
+	// color of each coverage level
+	static void palette(const FontFace *f, uint16_t fg, uint16_t bg, uint16_t pal[16]) {
+		uint8_t levels = (1 << f->bpp) - 1;
+		for (uint8_t c = 0; c <= levels; c++) {
+			uint16_t r = blend(bg >> 11, fg >> 11, c, levels);
+			uint16_t g = blend((bg >> 5) & 0x3F, (fg >> 5) & 0x3F, c, levels);
+			uint16_t b = blend(bg & 0x1F, fg & 0x1F, c, levels);
+			pal[c] = (r << 11) | (g << 5) | b;
+		}
+	}
+	static uint16_t blend(int16_t a, int16_t b, uint8_t c, uint8_t levels) {
+		return a + ((b - a) * c + levels / 2) / levels;
+	}
+
+	static uint8_t coverage(const FontFace *f, const FontGlyph *g, uint16_t i) {
+		const uint8_t *p = f->bitmaps + g->offset;
+		if (f->bpp == 4) return (p[i >> 1] >> ((i & 1) ? 0 : 4)) & 0x0F;
+		return (p[i >> 2] >> (6 - 2 * (i & 3))) & 0x03;
+	}
+
+	// n characters from the pen at x,y, in a window w x height from x+ox
+	void run(Display *d, const FontFace *f, int16_t x, int16_t y, int16_t ox, int16_t w, const char *s, uint16_t n, const uint16_t pal[16]) {
+		int16_t vx = x + ox, vy = y, vw = w, vh = f->height;
+		if (!d->beginPixels(vx, vy, vw, vh)) return;
+		uint16_t px[FONT_CHUNK];
+		for (int16_t row = vy - y; row < vy - y + vh; row++) {
+			memset(_line, 0, w);
+			int16_t pen = 0;
+			for (uint16_t k = 0; k < n; k++) {
+				const FontGlyph *g = glyph(f, s[k]);
+				if (g == 0) continue;
+				int16_t gy = row - f->ascent - g->y;
+				if (gy >= 0 && gy < g->h) {
+					for (uint8_t gx = 0; gx < g->w; gx++) {
+						int16_t lx = pen + g->x + gx - ox;
+						if (lx < 0 || lx >= w) continue;
+						uint8_t c = coverage(f, g, gy * g->w + gx);
+						if (c > _line[lx]) _line[lx] = c;//kerned glyphs may overlap
+					}
+				}
+				pen += g->advance + kern(f, s[k], k + 1 < n ? s[k + 1] : 0);
+			}
+			// the visible part of the row
+			for (int16_t c = vx - x - ox; c < vx - x - ox + vw; ) {
+				uint8_t m = 0;
+				while (m < FONT_CHUNK && c < vx - x - ox + vw) px[m++] = pal[_line[c++]];
+				d->pushPixels(px, m);
+			}
+		}
+		d->endPixels();
+	}
+
+	// FNV-1a
+	static uint32_t hash(const char *s, uint16_t len) {
+		uint32_t h = 2166136261UL;
+		for (uint16_t i = 0; i < len; i++) h = (h ^ (uint8_t)s[i]) * 16777619UL;
+		return h;
+	}
+
+	uint8_t _line[ROW];
+	Measured _measured[FONT_MEASURED];
+	uint8_t _next;
+};
+
+#endif
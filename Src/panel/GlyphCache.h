@@ -0,0 +1,120 @@
+/*
+	CGRAM glyph cache.
+	Keeps up to SLOTS 8x16 glyphs in the CGRAM of the chip, keyed by a
+	glyph id, and uploads the ones missing through the source callback,
+	evicting the least recently used. A run of glyphs is made resident
+	first and then printed as user chars in one text transaction, so an
+	icon font or a symbol several cells wide prints at text speed once its
+	glyphs are in CGRAM.
+	The order of the slots is kept most recently used first, a lookup
+	scans it from the front.
+*/
+
+#ifndef _GLYPH_CACHE_H_
+#define _GLYPH_CACHE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+// glyphs printed in one transaction
+#define GLYPH_RUN	32
+
+// SLOTS up to 256 CGRAM chars, starting at first; the ones past CGRAM
+// char 255 are left unused
+template<class Display, uint16_t SLOTS>
+class GlyphCache {
+	static_assert(SLOTS >= 1 && SLOTS <= 256, "the CGRAM holds 256 chars");
+ public:
+	// 16 bytes of a glyph, one per row, 0 if there is no such glyph
+	typedef const uint8_t *(*Source)(uint16_t id);
+
+	GlyphCache(Source source, uint8_t first=0) : _source(source), _first(first),
+		_slots(first + SLOTS > 256 ? 256 - first : SLOTS), _used(0), _uploads(0), _hits(0) {}
+
+	// forget everything, e.g. after something else wrote the CGRAM
+	void clear(void) { _used = 0; }
+
+	// CGRAM address of a glyph, uploaded when it's not there, -1 if unknown
+	int16_t slot(Display *d, uint16_t id) {
+		for (uint16_t i = 0; i < _used; i++) {
+			uint8_t s = _order[i];
+			if (_id[s] != id) continue;
+			touch(i);
+			_hits++;
+			return _first + s;
+		}
+		const uint8_t *bits = _source(id);
+		if (bits == 0) return -1;
+		uint8_t s;
+		if (_used < _slots) {
+			s = _used;
+			memmove(&_order[1], &_order[0], _used);
+			_order[0] = s;
+			_used++;
+		} else {//evict the least recently used
+			s = _order[_slots - 1];
+			touch(_slots - 1);
+		}
+		_id[s] = id;
+		d->uploadUserChar(bits, _first + s);
+		_uploads++;
+		return _first + s;
+	}
+
+	// print glyphs at the text cursor, unknown ids are skipped
+	void print(Display *d, const uint16_t ids[], uint16_t n) {
+		// a run never evicts its own glyphs
+		const uint16_t run = _slots < GLYPH_RUN ? _slots : GLYPH_RUN;
+		uint8_t buf[GLYPH_RUN];
+		while (n > 0) {
+			uint16_t len = n < run ? n : run;
+			uint8_t k = 0;
+			for (uint16_t i = 0; i < len; i++) {
+				int16_t a = slot(d, ids[i]);
+				if (a >= 0) buf[k++] = a;
+			}
+			d->showUserChars(buf, k);
+			ids += len;
+			n -= len;
+		}
+	}
+
+	// a symbol of several cells, ids first...first+cells-1, left to right
+	void printWide(Display *d, uint16_t first, uint8_t cells) {
+		uint16_t ids[GLYPH_RUN];
+		while (cells > 0) {
+			uint8_t len = cells < GLYPH_RUN ? cells : GLYPH_RUN;
+			for (uint8_t i = 0; i < len; i++) ids[i] = first++;
+			print(d, ids, len);
+			cells -= len;
+		}
+	}
+
+	bool resident(uint16_t id) const {
+		for (uint16_t i = 0; i < _used; i++) {
+			if (_id[_order[i]] == id) return true;
+		}
+		return false;
+	}
+
+	uint32_t uploads(void) const { return _uploads; }
+	uint32_t hits(void) const { return _hits; }
+
+ private:
+	// move the slot at position i of the order to the front
+	void touch(uint16_t i) {
+		uint8_t s = _order[i];
+		memmove(&_order[1], &_order[0], i);
+		_order[0] = s;
+	}
+
+	Source _source;
+	uint8_t _first;
+	uint16_t _slots; // SLOTS, fewer when they'd run past char 255
+	uint16_t _used;
+	uint16_t _id[SLOTS];
+	uint8_t _order[SLOTS]; // slots, most recently used first
+	uint32_t _uploads, _hits;
+};
+
+#endif
@@ -0,0 +1,141 @@
+/*
+	Uniform grid hit-test index.
+	The screen is cut into CELL x CELL pixel cells, each one keeps the ids
+	of the targets touching it in ascending order, so a point query only
+	tests the few targets of one cell and a rectangle query only the cells
+	it covers, however many targets there are.
+	A cell holds SLOTS ids, a target that doesn't fit marks the cell
+	overflowed: queries there return HIT_OVERFLOW and the caller scans its
+	targets the slow way. clear() and adding everything again resets it.
+	Ids go up to IDS - 1, a byte each up to 256 ids, two bytes past that.
+	RAM is one byte count plus SLOTS ids per cell, 240 cells of 40 pixels
+	on 800x480.
+*/
+
+#ifndef _HIT_GRID_H_
+#define _HIT_GRID_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define HIT_OVERFLOW	0xFF
+
+// id type holding 0...IDS-1
+template<bool WIDE> struct HitGridId { typedef uint8_t type; };
+template<> struct HitGridId<true> { typedef uint16_t type; };
+
+template<uint16_t WIDTH, uint16_t HEIGHT, uint8_t CELL, uint8_t SLOTS, uint16_t IDS=255>
+class HitGrid {
+ public:
+	typedef typename HitGridId<(IDS > 256)>::type Id;
+	static_assert(SLOTS < HIT_OVERFLOW, "a full cell would read as overflowed");
+
+	HitGrid() { clear(); }
+
+	void clear(void) {
+		memset(_n, 0, sizeof(_n));
+	}
+
+	void add(Id id, int16_t x, int16_t y, int16_t w, int16_t h) {
+		uint8_t c0, r0, c1, r1;
+		if (!cells(x, y, w, h, &c0, &r0, &c1, &r1)) return;
+		for (uint8_t r = r0; r <= r1; r++) {
+			for (uint8_t c = c0; c <= c1; c++) insert(r * COLS + c, id);
+		}
+	}
+
+	// same rectangle as added, overflowed cells stay overflowed
+	void remove(Id id, int16_t x, int16_t y, int16_t w, int16_t h) {
+		uint8_t c0, r0, c1, r1;
+		if (!cells(x, y, w, h, &c0, &r0, &c1, &r1)) return;
+		for (uint8_t r = r0; r <= r1; r++) {
+			for (uint8_t c = c0; c <= c1; c++) erase(r * COLS + c, id);
+		}
+	}
+
+	void move(Id id, int16_t ox, int16_t oy, int16_t ow, int16_t oh, int16_t x, int16_t y, int16_t w, int16_t h) {
+		remove(id, ox, oy, ow, oh);
+		add(id, x, y, w, h);
+	}
+
+	// ids that may contain the point, ascending, HIT_OVERFLOW if unknown
+	uint8_t at(int16_t x, int16_t y, const Id **ids) const {
+		*ids = 0;
+		if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) return 0;
+		uint16_t i = (y / CELL) * COLS + x / CELL;
+		*ids = _id[i];
+		return _n[i];
+	}
+
+	// ids that may overlap the rectangle, ascending and once each,
+	// HIT_OVERFLOW if unknown or more than max; HIT_OVERFLOW is a count
+	// too, so max is held below it and 255 ids are an overflow as well
+	uint8_t query(int16_t x, int16_t y, int16_t w, int16_t h, Id *out, uint8_t max) const {
+		if (max >= HIT_OVERFLOW) max = HIT_OVERFLOW - 1;
+		uint8_t c0, r0, c1, r1;
+		if (!cells(x, y, w, h, &c0, &r0, &c1, &r1)) return 0;
+		uint8_t seen[(IDS + 7) / 8];
+		memset(seen, 0, sizeof(seen));
+		for (uint8_t r = r0; r <= r1; r++) {
+			for (uint8_t c = c0; c <= c1; c++) {
+				uint16_t i = r * COLS + c;
+				if (_n[i] == HIT_OVERFLOW) return HIT_OVERFLOW;
+				for (uint8_t k = 0; k < _n[i]; k++) seen[_id[i][k] >> 3] |= 1 << (_id[i][k] & 7);
+			}
+		}
+		uint8_t n = 0;
+		for (uint16_t id = 0; id < IDS; id++) {
+			if (!(seen[id >> 3] & (1 << (id & 7)))) continue;
+			if (n == max) return HIT_OVERFLOW;
+			out[n++] = id;
+		}
+		return n;
+	}
+
+ private:
+	enum { COLS = (WIDTH + CELL - 1) / CELL, ROWS = (HEIGHT + CELL - 1) / CELL };
+
+	// cell range of a rectangle, false when it's off screen
+	static bool cells(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t *c0, uint8_t *r0, uint8_t *c1, uint8_t *r1) {
+		int16_t r = x + w - 1, b = y + h - 1;
+		if (w <= 0 || h <= 0 || r < 0 || b < 0 || x >= WIDTH || y >= HEIGHT) return false;
+		if (x < 0) x = 0;
+		if (y < 0) y = 0;
+		if (r >= WIDTH) r = WIDTH - 1;
+		if (b >= HEIGHT) b = HEIGHT - 1;
+		*c0 = x / CELL; *r0 = y / CELL;
+		*c1 = r / CELL; *r1 = b / CELL;
+		return true;
+	}
+
+	void insert(uint16_t i, Id id) {
+		uint8_t n = _n[i];
+		if (n == HIT_OVERFLOW) return;
+		uint8_t k = 0;
+		while (k < n && _id[i][k] < id) k++;
+		if (k < n && _id[i][k] == id) return;
+		if (n == SLOTS) {
+			_n[i] = HIT_OVERFLOW;
+			return;
+		}
+		memmove(&_id[i][k + 1], &_id[i][k], (n - k) * sizeof(Id));
+		_id[i][k] = id;
+		_n[i] = n + 1;
+	}
+
+	void erase(uint16_t i, Id id) {
+		uint8_t n = _n[i];
+		if (n == HIT_OVERFLOW) return;
+		for (uint8_t k = 0; k < n; k++) {
+			if (_id[i][k] != id) continue;
+			memmove(&_id[i][k], &_id[i][k + 1], (n - k - 1) * sizeof(Id));
+			_n[i] = n - 1;
+			return;
+		}
+	}
+
+	uint8_t _n[COLS * ROWS];
+	Id _id[COLS * ROWS][SLOTS];
+};
+
+#endif
@@ -1,5 +1,6 @@
 
 #include "RA8875.h"
+#include "Trace.h"
 
 #include "stm32l1xx_hal.h"
 #include "stm32l1xx_hal_gpio.h"
@@ -14,6 +15,13 @@
 #define bitSet(value, bit) ((value) |= (1UL << (bit)))
 #define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
 #define bitWrite(value, bit, bitvalue) (bitvalue ? bitSet(value, bit) : bitClear(value, bit))
+#ifndef min
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#endif
+#define swap(a, b) { int16_t t = a; a = b; b = t; }
 
 #define USESETMULTIPLEREGISTERS 1
 
@@ -24,7 +32,11 @@
 */
 /**************************************************************************/
 
-RA8875::RA8875(SPI_HandleTypeDef *hspi, GPIO_TypeDef* csport, uint16_t cspin)
+template<class Panel>
+RA8875T<Panel>::RA8875T(SPI_HandleTypeDef *hspi, GPIO_TypeDef* csport, uint16_t cspin)
+#if RA8875_FAST_SPI
+	: _fast(hspi->Instance, csport, cspin)
+#endif
 {
 	this->hspi= hspi;
 	this->cs_port= csport;
@@ -45,44 +57,66 @@ RA8875::RA8875(SPI_HandleTypeDef *hspi, GPIO_TypeDef* csport, uint16_t cspin)
 */
 /**************************************************************************/
 
+template<class Panel>
+void RA8875T<Panel>::begin(void) {
+	_size = Panel::size;
+	initState();
+	initialize(Panel::timing);
+}
+
 void RA8875::begin(const enum RA8875sizes s) {
 
 	_size = s;
-	uint8_t initIndex;
+	const uint8_t *timing;
 
 	if (_size == RA8875_320x240) {//still not supported! Wait next version
 		_width = 320;
 		_height = 240;
-		initIndex = 0;
+		timing = Panel320x240::timing;
 		_maxLayers = 2;
 	} else if (_size == RA8875_480x272 || _size == Adafruit_480x272) {
 		_width = 480;
 		_height = 272;
-		initIndex = 1;
+		timing = Panel480x272::timing;
 		_maxLayers = 2;
 	} else if (_size == RA8875_640x480) {//still not supported! Wait next version
 		_width = 640;
 		_height = 480;
-		initIndex = 2;
+		timing = Panel640x480::timing;
 		_maxLayers = 1;
 	} else if (_size == RA8875_800x480 || _size == Adafruit_800x480) {
 		_width = 800;
 		_height = 480;
-		initIndex = 3;
+		timing = Panel800x480::timing;
 		_maxLayers = 1;
 	} else {
 		_width = 480;
 		_height = 272;
-		initIndex = 1;
+		timing = Panel480x272::timing;
 		_maxLayers = 2;
 	}
 
+	initState();
+	initialize(timing);
+}
+
+/**************************************************************************/
+/*!
+	PRIVATE
+      Default state of the library and the register containers
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::initState(void) {
+
 	_currentLayer = 0;
 	_currentMode = GRAPHIC;
 
 	_cursorX = 0; _cursorY = 0;
+	_cursorMoved = true;
 	_textWrap = true;
 	_textSize = X16;
+	_textScale = 0;
 	_fontSpacing = 0;
 	_extFontRom = false;
 	_fontRomType = GT21L16T1W;
@@ -95,6 +129,12 @@ void RA8875::begin(const enum RA8875sizes s) {
 	_textCursorStyle = BLINK;
 	_scrollXL = 0; _scrollXR = 0; _scrollYT = 0; _scrollYB = 0;
 	_useMultiLayers = false;//starts with one layer only
+	_color8 = false;
+	_doubleBuffer = false;
+	_frontLayer = 0;
+	_flipTick = 0; _frameMs = 0;
+	_btePending = false;
+	_gcursorPosValid = false;
 
 /* Display Configuration Register	  [0x20]
 	  7: (Layer Setting Control) 0:one Layer, 1:two Layers
@@ -112,6 +152,13 @@ void RA8875::begin(const enum RA8875sizes s) {
 	1: 0(Auto Increase in write), 1(no)
 	0: 0(Auto Increase in read), 1(no) */
 	_MWCR0Reg = 0b00000000;
+/*	Memory Write Control Register 1 [0x41]
+	7: 0(graphic cursor off), 1(on)
+	6-4: graphic cursor selection 0...7
+	3-2: 00(layer), 01(CGRAM), 10(graphic cursor), 11(pattern)
+	1: na
+	0: 0(layer 1), 1(layer 2) */
+	_MWCR1Reg = 0b00000000;
 
 /*	Font Control Register 0 [0x21]
 	7: 0(CGROM font is selected), 1(CGRAM font is selected)
@@ -182,65 +229,150 @@ void RA8875::begin(const enum RA8875sizes s) {
 	// }
 
 	//	settings = SPISettings(MAXSPISPEED, MSBFIRST, SPI_MODE0);
-
-	initialize(initIndex);
 }
 
 /************************* Initialization *********************************/
 
+constexpr uint8_t Panel320x240::timing[15];
+constexpr uint8_t Panel480x272::timing[15];
+constexpr uint8_t Panel640x480::timing[15];
+constexpr uint8_t Panel800x480::timing[15];
+
+/*
+	The init sequence is a table run by runSequence().
+	Consecutive register writes go out back to back as one burst, waits are
+	explicit steps and a busy poll is used wherever the chip reports completion.
+*/
+enum RA8875initOp {
+	INIT_SET,		// reg = arg
+	INIT_TIMING,	// reg = panel timing[arg]
+	INIT_WINDOW,	// reg = byte arg of (width-1, height-1), lsb first
+	INIT_ADAFRUIT,	// reg = arg, only on Adafruit boards
+	INIT_DELAY,		// wait arg ms
+	INIT_POLL,		// wait for status bits arg to clear
+	INIT_END
+};
+
+struct RA8875initStep {
+	uint8_t op, reg, arg;
+};
+
+// register containers as left by the sequence
+#define INIT_MWCR0		(1 << 5)				// blinking text cursor, hidden
+#define INIT_FNCR0		DEFAULTINTENCODING		// internal CGROM, default coding
+#define INIT_FNCR1		(1 << 6)				// transparent text background
+
+static const RA8875initStep resetSequence[] = {
+	{INIT_SET,		RA8875_PWRR,	RA8875_PWRR_SOFTRESET},
+	{INIT_SET,		RA8875_PWRR,	RA8875_PWRR_NORMAL},
+	{INIT_DELAY,	0,				1},//was 200ms, 1ms is what Adafruit uses
+	{INIT_END,		0,				0}
+};
+
+static const RA8875initStep initSequence[] = {
+	{INIT_TIMING,	RA8875_PLLC1,	0},//PLL Control Register 1
+	{INIT_TIMING,	RA8875_PLLC2,	1},//PLL Control Register 2
+	{INIT_DELAY,	0,				1},//PLL lock
+	{INIT_TIMING,	RA8875_PCSR,	2},//Pixel Clock Setting Register
+	{INIT_SET,		RA8875_SYSR,	0x0C},//we are working ALWAYS at 65K color space!!!!
+	{INIT_TIMING,	RA8875_HDWR,	3},//LCD Horizontal Display Width Register
+	{INIT_TIMING,	RA8875_HNDFTR,	4},//Horizontal Non-Display Period Fine Tuning Option Register
+	{INIT_TIMING,	RA8875_HNDR,	5},//LCD Horizontal Non-Display Period Register
+	{INIT_TIMING,	RA8875_HSTR,	6},//HSYNC Start Position Register
+	{INIT_TIMING,	RA8875_HPWR,	7},//HSYNC Pulse Width Register
+	{INIT_TIMING,	RA8875_VDHR0,	8},//LCD Vertical Display Height Register0
+	{INIT_TIMING,	RA8875_VDHR1,	9},//LCD Vertical Display Height Register1
+	{INIT_TIMING,	RA8875_VNDR0,	10},//LCD Vertical Non-Display Period Register 0
+	{INIT_TIMING,	RA8875_VNDR1,	11},//LCD Vertical Non-Display Period Register 1
+	{INIT_TIMING,	RA8875_VSTR0,	12},//VSYNC Start Position Register 0
+	{INIT_TIMING,	RA8875_VSTR1,	13},//VSYNC Start Position Register 1
+	{INIT_TIMING,	RA8875_VPWR,	14},//VSYNC Pulse Width Register
+	//set the active window to the full screen
+	{INIT_SET,		RA8875_HSAW0,	0},
+	{INIT_SET,		RA8875_HSAW1,	0},
+	{INIT_WINDOW,	RA8875_HEAW0,	0},
+	{INIT_WINDOW,	RA8875_HEAW1,	1},
+	{INIT_SET,		RA8875_VSAW0,	0},
+	{INIT_SET,		RA8875_VSAW1,	0},
+	{INIT_WINDOW,	RA8875_VEAW0,	2},
+	{INIT_WINDOW,	RA8875_VEAW1,	3},
+	//clear FULL memory, replaces the fixed 10ms wait
+	{INIT_SET,		RA8875_MCLR,	0x80},
+	{INIT_POLL,		0,				0x80},
+	//now starts the first time setting up
+	{INIT_SET,		RA8875_PWRR,	RA8875_PWRR_NORMAL | RA8875_PWRR_DISPON},//turn On Display
+	{INIT_ADAFRUIT,	RA8875_GPIOX,	1},//only for adafruit stuff
+	{INIT_SET,		RA8875_P1CR,	RA8875_PxCR_ENABLE | (RA8875_PWM_CLK_DIV1024 & 0xF)},//PWM ch 1 for backlight
+	{INIT_SET,		RA8875_P1DCR,	255},//turn on PWM1
+	{INIT_SET,		RA8875_BTCR,	DEFAULTCURSORBLINKRATE},//set default blink rate
+	{INIT_SET,		RA8875_MWCR0,	INIT_MWCR0},
+	{INIT_SET,		RA8875_FNCR0,	INIT_FNCR0},
+	{INIT_SET,		RA8875_FGCR0,	(RA8875_WHITE & 0xF800) >> 11},//white text since the blackground it's black...
+	{INIT_SET,		RA8875_FGCR1,	(RA8875_WHITE & 0x07E0) >> 5},
+	{INIT_SET,		RA8875_FGCR2,	RA8875_WHITE & 0x001F},
+	{INIT_SET,		RA8875_FNCR1,	INIT_FNCR1},
+	{INIT_END,		0,				0}
+};
+
+/**************************************************************************/
+/*!
+	PRIVATE
+	Run an init sequence, register writes are collected and sent back to
+	back when the next wait step (or the end) is reached. Each still takes
+	its own CS frame: a data cycle runs until CS rises, so the chip takes
+	one register per frame
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::runSequence(const RA8875initStep *seq, const uint8_t timing[15]) {
+	uint8_t reg[16], data[16];
+	uint8_t n = 0;
+	const uint16_t win[2] = {(uint16_t)(W()-1), (uint16_t)(H()-1)};
+	for (;; seq++) {
+		uint8_t op = seq->op;
+		if (op == INIT_ADAFRUIT) {
+			if (_size != Adafruit_480x272 && _size != Adafruit_800x480) continue;
+			op = INIT_SET;
+		}
+		if (op == INIT_SET || op == INIT_TIMING || op == INIT_WINDOW) {
+			uint8_t v = seq->arg;
+			if (op == INIT_TIMING) v = timing[seq->arg];
+			else if (op == INIT_WINDOW) v = win[seq->arg >> 1] >> ((seq->arg & 1) * 8);
+			reg[n] = seq->reg;
+			data[n] = v;
+			if (++n < sizeof(reg)) continue;
+		}
+		if (n > 0) {
+			setMultipleRegisters(reg, data, n);
+			n = 0;
+		}
+		if (op == INIT_DELAY) delay(seq->arg);
+		else if (op == INIT_POLL) waitBusy(seq->arg);
+		else if (op == INIT_END) break;
+	}
+}
+
 /**************************************************************************/
 /*!
 	PRIVATE
       Hardware initialization of RA8875 and turn on
 */
 /**************************************************************************/
-static const uint8_t initStrings[4][15] = { // put in flash
-	{0x0A,0x02,0x03,0x27,0x00,0x05,0x04,0x03,0xEF,0x00,0x05,0x00,0x0E,0x00,0x02},//0 -> 320x240 (to be fixed)
-	{0x10,0x02,0x82,0x3B,0x00,0x01,0x00,0x05,0x0F,0x01,0x02,0x00,0x07,0x00,0x09},//1 -> 480x272 (0x0A)
-	{0x0B,0x02,0x01,0x4F,0x05,0x0F,0x01,0x00,0xDF,0x10,0x0A,0x00,0x0E,0x00,0x01},//2 -> 640x480 (to be fixed)
-	{0x10,0x02,0x81,0x63,0x00,0x03,0x03,0x0B,0xDF,0x01,0x1F,0x00,0x16,0x00,0x01}// 3 -> 800x480 (0x0B)(to be fixed?)
-};
-
-void RA8875::initialize(uint8_t initIndex) {
+template<class Panel>
+void RA8875T<Panel>::initialize(const uint8_t timing[15]) {
 	if (!_rst) {//soft reset
-		softReset();
+		runSequence(resetSequence, timing);
 	}
+	runSequence(initSequence, timing);
 
-	writeReg(RA8875_PLLC1,initStrings[initIndex][0]);////PLL Control Register 1
-	delay(1);
-	writeReg(RA8875_PLLC2,initStrings[initIndex][1]);////PLL Control Register 2
-	delay(1);
-
-	writeReg(RA8875_PCSR,initStrings[initIndex][2]);//Pixel Clock Setting Register
-	delay(1);
-	writeReg(RA8875_SYSR,0x0C);//we are working ALWAYS at 65K color space!!!!
-	writeReg(RA8875_HDWR,initStrings[initIndex][3]);//LCD Horizontal Display Width Register
-	writeReg(RA8875_HNDFTR,initStrings[initIndex][4]);//Horizontal Non-Display Period Fine Tuning Option Register
-	writeReg(RA8875_HNDR,initStrings[initIndex][5]);////LCD Horizontal Non-Display Period Register
-	writeReg(RA8875_HSTR,initStrings[initIndex][6]);////HSYNC Start Position Register
-	writeReg(RA8875_HPWR,initStrings[initIndex][7]);////HSYNC Pulse Width Register
-	writeReg(RA8875_VDHR0,initStrings[initIndex][8]);////LCD Vertical Display Height Register0
-	writeReg(RA8875_VDHR1,initStrings[initIndex][9]);////LCD Vertical Display Height Register1
-	writeReg(RA8875_VNDR0,initStrings[initIndex][10]);////LCD Vertical Non-Display Period Register 0
-	writeReg(RA8875_VNDR1,initStrings[initIndex][11]);////LCD Vertical Non-Display Period Register 1
-	writeReg(RA8875_VSTR0,initStrings[initIndex][12]);////VSYNC Start Position Register 0
-	writeReg(RA8875_VSTR1,initStrings[initIndex][13]);////VSYNC Start Position Register 1
-	writeReg(RA8875_VPWR,initStrings[initIndex][14]);////VSYNC Pulse Width Register
-	setActiveWindow(0,(_width-1),0,(_height-1));//set the active winsow
-	clearMemory(true);//clear FULL memory
-	//end of hardware initialization
-	delay(10);
-
-    //now starts the first time setting up
-	displayOn(true);//turn On Display
-	if (_size == Adafruit_480x272 || _size == Adafruit_800x480) GPIOX(true);//only for adafruit stuff
-	PWMsetup(1,true, RA8875_PWM_CLK_DIV1024);//setup PWM ch 1 for backlight
-	PWMout(1,255);//turn on PWM1
-	setCursorBlinkRate(DEFAULTCURSORBLINKRATE);//set default blink rate
-	if (_textCursorStyle == BLINK) showCursor(false,BLINK); //set default text cursor type and turn off
-	setIntFontCoding(DEFAULTINTENCODING);//set default internal font encoding
-	setFont(INT);	//set internal font use
-	setTextColor(RA8875_WHITE);//since the blackground it's black...
+	_MWCR0Reg = INIT_MWCR0;
+	_FNCR0Reg = INIT_FNCR0;
+	_FNCR1Reg = INIT_FNCR1;
+	_textCursorStyle = BLINK;
+	_fontSource = INT;
+	_clipXL = _clipYT = 0;//the sequence set the active window to the full screen
+	_clipXR = W() - 1;
+	_clipYB = H() - 1;
 	//now tft it's ready to go and in [Graphic mode]
 }
 
@@ -249,7 +381,8 @@ void RA8875::initialize(uint8_t initIndex) {
       Software Reset
 */
 /**************************************************************************/
-void RA8875::softReset(void) {
+template<class Panel>
+void RA8875T<Panel>::softReset(void) {
 	writeCommand(RA8875_PWRR);
 	writeData(RA8875_PWRR_SOFTRESET);
 	writeData(RA8875_PWRR_NORMAL);
@@ -262,10 +395,12 @@ void RA8875::softReset(void) {
 		full: true(clear all memory), false(clear active window only)
 */
 /**************************************************************************/
-void RA8875::clearMemory(bool full){
+template<class Panel>
+void RA8875T<Panel>::clearMemory(bool full){
 	uint8_t temp = 0b00000000;
 	if (!full) temp |= (1 << 6);
 	temp |= (1 << 7);//enable start bit
+	bteWait();
 	writeReg(RA8875_MCLR,temp);
 	//_cursorX = _cursorY = 0;
 	waitBusy(0x80);
@@ -282,9 +417,10 @@ void RA8875::clearMemory(bool full){
 		YB: Vertical Bottom
 */
 /**************************************************************************/
-void RA8875::setActiveWindow(uint16_t XL,uint16_t XR ,uint16_t YT ,uint16_t YB){
-	if (XR >= _width) XR = _width-1;
-	if (YB >= _height) YB = _height-1;
+template<class Panel>
+void RA8875T<Panel>::setActiveWindow(uint16_t XL,uint16_t XR ,uint16_t YT ,uint16_t YB){
+	if (XR >= W()) XR = W()-1;
+	if (YB >= H()) YB = H()-1;
     // X
 	writeReg(RA8875_HSAW0,XL);
 	writeReg(RA8875_HSAW1,XL >> 8);
@@ -297,6 +433,38 @@ void RA8875::setActiveWindow(uint16_t XL,uint16_t XR ,uint16_t YT ,uint16_t YB){
 	writeReg(RA8875_VEAW1,YB >> 8);
 }
 
+/**************************************************************************/
+/*!
+		Drop everything drawn outside a rectangle. Primitives fully outside
+		cost nothing, the others are clipped in software (lines, rects) or by
+		the active window, which is set to the clip rect
+	    Parameters:
+		x,y: top left
+		w,h: size
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::setClipRect(int16_t x, int16_t y, int16_t w, int16_t h){
+	int16_t xr = x + w - 1, yb = y + h - 1;
+	if (x < 0) x = 0;
+	if (y < 0) y = 0;
+	if (xr >= W()) xr = W() - 1;
+	if (yb >= H()) yb = H() - 1;
+	_clipXL = x; _clipYT = y; _clipXR = xr; _clipYB = yb;
+	if (x > xr || y > yb) return;//nothing visible, keep the window
+	setActiveWindow(x,xr,y,yb);
+}
+
+/**************************************************************************/
+/*!
+		Clip to the full screen again
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::clearClipRect(void){
+	setClipRect(0,0,W(),H());
+}
+
 /**************************************************************************/
 /*!
 		Return the max tft width.
@@ -304,7 +472,8 @@ void RA8875::setActiveWindow(uint16_t XL,uint16_t XR ,uint16_t YT ,uint16_t YB){
 		so you need to subtract 1!
 */
 /**************************************************************************/
-uint16_t RA8875::width(void) { return _width; }
+template<class Panel>
+uint16_t RA8875T<Panel>::width(void) { return W(); }
 
 /**************************************************************************/
 /*!
@@ -313,7 +482,8 @@ uint16_t RA8875::width(void) { return _width; }
 		so you need to subtract 1!
 */
 /**************************************************************************/
-uint16_t RA8875::height(void) { return _height; }
+template<class Panel>
+uint16_t RA8875T<Panel>::height(void) { return H(); }
 
 /************************* Text Mode ***********************************/
 
@@ -324,7 +494,9 @@ uint16_t RA8875::height(void) { return _height; }
 		m: can be GRAPHIC or TEXT
 */
 /**************************************************************************/
-void RA8875::changeMode(enum RA8875modes m) {
+template<class Panel>
+void RA8875T<Panel>::changeMode(enum RA8875modes m) {
+	bteWait();//every drawing primitive comes through here
 	if (m == GRAPHIC){
 		if (_currentMode == TEXT){//avoid useless consecutive calls
 			 _MWCR0Reg &= ~(1 << 7);
@@ -342,24 +514,22 @@ void RA8875::changeMode(enum RA8875modes m) {
 
 /**************************************************************************/
 /*!		Upload user custom cahr or symbol to CGRAM, max 255
+		The 16 bytes go out in one transaction and the writes go back to
+		the layer afterwards.
 		Parameters:
 		symbol[]: an 8bit x 16 char in an array. Must be exact 16 bytes
 		address: 0...255 the address of the CGRAM where to store the char
 */
 /**************************************************************************/
-void RA8875::uploadUserChar(const uint8_t symbol[],uint8_t address) {
-	bool modeChanged = false;
-	if (_currentMode != GRAPHIC) {//was in text!
-		changeMode(GRAPHIC);
-		modeChanged = true;
-	}
+template<class Panel>
+void RA8875T<Panel>::uploadUserChar(const uint8_t symbol[],uint8_t address) {
+	changeMode(GRAPHIC);
 	writeReg(RA8875_CGSR,address);
 	writeTo(CGRAM);
 	writeCommand(RA8875_MRWC);
-	for (uint8_t i=0;i<16;i++){
-		writeData(symbol[i]);
-	}
-	if (modeChanged) changeMode(TEXT);
+	uint8_t head[] = {RA8875_DATAWRITE};
+	writeBlock(head,sizeof(head),symbol,16);
+	writeTo(_currentLayer == 0 ? L1 : L2);
 }
 
 /**************************************************************************/
@@ -371,29 +541,37 @@ void RA8875::uploadUserChar(const uint8_t symbol[],uint8_t address) {
 		more than a char slot they can be showed combined (see examples)
 */
 /**************************************************************************/
-void RA8875::showUserChar(uint8_t symbolAddrs,uint8_t wide) {
-	uint8_t oldRegState = _FNCR0Reg;
-	uint8_t i;
-	bitSet(oldRegState,7);//set to CGRAM
-	writeReg(RA8875_FNCR0,oldRegState);
-	//layers?
- 	if (_useMultiLayers){
-		if (_currentLayer == 0){
-			writeTo(L1);
-		} else {
-			writeTo(L2);
-		}
-	} else {
-		writeTo(L1);
+template<class Panel>
+void RA8875T<Panel>::showUserChar(uint8_t symbolAddrs,uint8_t wide) {
+	uint8_t buf[16];
+	uint16_t n = wide + 1;
+	while (n > 0) {
+		uint8_t len = n > sizeof(buf) ? sizeof(buf) : n;
+		for (uint8_t i=0;i<len;i++) buf[i] = symbolAddrs++;
+		showUserChars(buf,len);
+		n -= len;
 	}
-	writeCommand(RA8875_MRWC);
-	writeData(symbolAddrs);
-	if (wide > 0){
-		for (i=1;i<=wide;i++){
-			writeData(symbolAddrs+i);
-		}
-	}
-	if (oldRegState != _FNCR0Reg) writeReg(RA8875_FNCR0,_FNCR0Reg);
+}
+
+/**************************************************************************/
+/*!		Print a run of CGRAM chars at the text cursor in one transaction,
+		like textSend there is no wrapping
+		Parameters:
+		addrs: CGRAM addresses
+		len: how many
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::showUserChars(const uint8_t addrs[],uint8_t len) {
+	static const uint8_t header[3]= {RA8875_CMDWRITE, RA8875_MRWC, RA8875_DATAWRITE};
+	if (len == 0) return;
+	if (_cursorMoved) setCursor(_cursorX, _cursorY);
+	changeMode(TEXT);
+	writeReg(RA8875_FNCR0,_FNCR0Reg | (1 << 7));//CGRAM
+	writeBlock(header, sizeof(header), addrs, len);
+	waitBusy(0x80);
+	writeReg(RA8875_FNCR0,_FNCR0Reg);
+	_cursorX += len * charWidth();
 }
 
 /**************************************************************************/
@@ -404,7 +582,8 @@ void RA8875::showUserChar(uint8_t symbolAddrs,uint8_t wide) {
 		default:ISO_IEC_8859_1
 */
 /**************************************************************************/
-void RA8875::setIntFontCoding(enum RA8875fontCoding f) {
+template<class Panel>
+void RA8875T<Panel>::setIntFontCoding(enum RA8875fontCoding f) {
 	uint8_t temp = _FNCR0Reg;
 	temp &= ~((1<<1) | (1<<0));// Clear bits 1 and 0
 	switch (f){
@@ -427,6 +606,17 @@ void RA8875::setIntFontCoding(enum RA8875fontCoding f) {
 	writeReg(RA8875_FNCR0,_FNCR0Reg);
 }
 
+/**************************************************************************/
+/*!
+		Give back the internal Font Encoding from the register shadow,
+		no SPI reads
+*/
+/**************************************************************************/
+template<class Panel>
+enum RA8875fontCoding RA8875T<Panel>::getIntFontCoding(void) {
+	return (enum RA8875fontCoding)(_FNCR0Reg & ((1<<1) | (1<<0)));
+}
+
 /**************************************************************************/
 /*!
 		External Font Rom setup
@@ -438,7 +628,8 @@ void RA8875::setIntFontCoding(enum RA8875fontCoding f) {
 		erf:ROM Font Family   (STANDARD, ARIAL, ROMAN, BOLD)
 */
 /**************************************************************************/
-void RA8875::setExternalFontRom(enum RA8875extRomType ert, enum RA8875extRomCoding erc, enum RA8875extRomFamily erf){
+template<class Panel>
+void RA8875T<Panel>::setExternalFontRom(enum RA8875extRomType ert, enum RA8875extRomCoding erc, enum RA8875extRomFamily erf){
 	uint8_t temp = _SFRSETReg;//just to preserve the reg in case something wrong
 	switch(ert){ //type of rom
 		case GT21L16T1W:
@@ -514,7 +705,8 @@ void RA8875::setExternalFontRom(enum RA8875extRomType ert, enum RA8875extRomCodi
 		false:(change only the register container, useful during config)
 */
 /**************************************************************************/
-void RA8875::setExtFontFamily(enum RA8875extRomFamily erf,bool setReg) {
+template<class Panel>
+void RA8875T<Panel>::setExtFontFamily(enum RA8875extRomFamily erf,bool setReg) {
 	_fontFamily = erf;
 	switch(erf){	//check rom font family
 		case STANDARD:
@@ -543,7 +735,8 @@ void RA8875::setExtFontFamily(enum RA8875extRomFamily erf,bool setReg) {
 		s: Font source (INT,EXT)
 */
 /**************************************************************************/
-void RA8875::setFont(enum RA8875fontSource s) {
+template<class Panel>
+void RA8875T<Panel>::setFont(enum RA8875fontSource s) {
 	//enum RA8875fontCoding c
 	if (s == INT){
 		//check the font coding
@@ -581,7 +774,8 @@ void RA8875::setFont(enum RA8875fontSource s) {
 		align: true,false
 */
 /**************************************************************************/
-void RA8875::setFontFullAlign(bool align) {
+template<class Panel>
+void RA8875T<Panel>::setFontFullAlign(bool align) {
 	align == true ? _FNCR1Reg |= (1 << 7) : _FNCR1Reg &= ~(1 << 7);
 	writeReg(RA8875_FNCR1,_FNCR1Reg);
 }
@@ -593,7 +787,8 @@ void RA8875::setFontFullAlign(bool align) {
 		rot: true,false
 */
 /**************************************************************************/
-void RA8875::setFontRotate(bool rot) {
+template<class Panel>
+void RA8875T<Panel>::setFontRotate(bool rot) {
 	rot == true ? _FNCR1Reg |= (1 << 4) : _FNCR1Reg &= ~(1 << 4);
 	writeReg(RA8875_FNCR1,_FNCR1Reg);
 }
@@ -605,7 +800,8 @@ void RA8875::setFontRotate(bool rot) {
 		pix: 0...63 pixels
 */
 /**************************************************************************/
-void RA8875::setFontInterline(uint8_t pix){
+template<class Panel>
+void RA8875T<Panel>::setFontInterline(uint8_t pix){
 	if (pix > 0x3F) pix = 0x3F;
 	_fontInterline = pix;
 	//_FWTSETReg &= 0xC0;
@@ -620,13 +816,15 @@ void RA8875::setFontInterline(uint8_t pix){
 		y:vertical in pixels
 */
 /**************************************************************************/
-void RA8875::setCursor(uint16_t x, uint16_t y) {
+template<class Panel>
+void RA8875T<Panel>::setCursor(uint16_t x, uint16_t y) {
 	if (!_textWrap){
-		if (x >= _width) x = _width-1;
-		if (y >= _height) y = _height-1;
+		if (x >= W()) x = W()-1;
+		if (y >= H()) y = H()-1;
 	}
 	_cursorX = x;
 	_cursorY = y;
+	_cursorMoved = false;
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_F_CURXL,RA8875_F_CURXH,RA8875_F_CURYL,RA8875_F_CURYH};
 	uint8_t data[] = {(uint8_t)(x & 0xFF),(uint8_t)(x >> 8),(uint8_t)(y & 0xFF),(uint8_t)(y >> 8)};
@@ -641,14 +839,27 @@ void RA8875::setCursor(uint16_t x, uint16_t y) {
 
 /**************************************************************************/
 /*!
-		Update the library tracked  _cursorX,_cursorX and give back
+		Give back the library tracked text cursor, no SPI reads
 		Parameters:
 		x*:horizontal pos in pixels
 		y*:vertical pos in pixels
 		USE: xxx.getCursor(&myX,&myY);
 */
 /**************************************************************************/
-void RA8875::getCursor(uint16_t *x, uint16_t *y) {
+template<class Panel>
+void RA8875T<Panel>::getCursor(uint16_t *x, uint16_t *y) {
+	*x = _cursorX;
+	*y = _cursorY;
+}
+
+/**************************************************************************/
+/*!
+		Resync the tracked _cursorX,_cursorY from the chip, only needed if
+		something other than this library moved the text cursor
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::syncCursor(void) {
 	uint8_t t1,t2;
 	t1 = readReg(RA8875_F_CURXL);
 	t2 = readReg(RA8875_F_CURXH);
@@ -656,8 +867,7 @@ void RA8875::getCursor(uint16_t *x, uint16_t *y) {
 	t1 = readReg(RA8875_F_CURYL);
 	t2 = readReg(RA8875_F_CURYH);
 	_cursorY = (t2 << 8) | (t1 & 0xFF);
-	*x = _cursorX;
-	*y = _cursorY;
+	_cursorMoved = false;
 }
 /**************************************************************************/
 /*!     Show/Hide text cursor
@@ -666,7 +876,8 @@ void RA8875::getCursor(uint16_t *x, uint16_t *y) {
 		c: cursor type (NORMAL, BLINK)
 */
 /**************************************************************************/
-void RA8875::showCursor(bool cur,enum RA8875tcursor c){
+template<class Panel>
+void RA8875T<Panel>::showCursor(bool cur,enum RA8875tcursor c){
 	if (c == BLINK){
 		_textCursorStyle = c;
 		_MWCR0Reg |= (1 << 5);
@@ -684,7 +895,8 @@ void RA8875::showCursor(bool cur,enum RA8875tcursor c){
 		rate:blink speed (fast 0...255 slow)
 */
 /**************************************************************************/
-void RA8875::setCursorBlinkRate(uint8_t rate){
+template<class Panel>
+void RA8875T<Panel>::setCursorBlinkRate(uint8_t rate){
 	writeReg(RA8875_BTCR,rate);//set blink rate
 }
 
@@ -696,7 +908,8 @@ void RA8875::setCursorBlinkRate(uint8_t rate){
 		bColor:16bit background color RGB565
 */
 /**************************************************************************/
-void RA8875::setTextColor(uint16_t fColor, uint16_t bColor){
+template<class Panel>
+void RA8875T<Panel>::setTextColor(uint16_t fColor, uint16_t bColor){
 	setForegroundColor(fColor);
 	setBackgroundColor(bColor);
 	_FNCR1Reg &= ~(1 << 6);
@@ -711,7 +924,8 @@ void RA8875::setTextColor(uint16_t fColor, uint16_t bColor){
 */
 /**************************************************************************/
 
-void RA8875::setTextColor(uint16_t fColor){
+template<class Panel>
+void RA8875T<Panel>::setTextColor(uint16_t fColor){
 	setForegroundColor(fColor);
 	_FNCR1Reg |= (1 << 6);
 	writeReg(RA8875_FNCR1,_FNCR1Reg);
@@ -724,7 +938,8 @@ void RA8875::setTextColor(uint16_t fColor){
 		scale:0..3  -> 0:normal, 1:x2, 2:x3, 3:x4
 */
 /**************************************************************************/
-void RA8875::setFontScale(uint8_t scale){
+template<class Panel>
+void RA8875T<Panel>::setFontScale(uint8_t scale){
 	if (scale > 3) scale = 3;
  	_FNCR1Reg &= ~(0xF); // clear bits from 0 to 3
 	_FNCR1Reg |= scale << 2;
@@ -742,7 +957,8 @@ void RA8875::setFontScale(uint8_t scale){
 		halfSize:true/false (16x16 -> 8x16 and so on...)
 */
 /**************************************************************************/
-void RA8875::setFontSize(enum RA8875tsize ts,bool halfSize){
+template<class Panel>
+void RA8875T<Panel>::setFontSize(enum RA8875tsize ts,bool halfSize){
 	switch(ts){
 		case X16:
 			_FWTSETReg &= 0x3F;
@@ -767,7 +983,8 @@ void RA8875::setFontSize(enum RA8875tsize ts,bool halfSize){
 		spc:0...63pix (default 0=off)
 */
 /**************************************************************************/
-void RA8875::setFontSpacing(uint8_t spc){//ok
+template<class Panel>
+void RA8875T<Panel>::setFontSpacing(uint8_t spc){//ok
 	if (spc > 0x3F) spc = 0x3F;
 	_fontSpacing = spc;
 	_FWTSETReg &= 0xC0;
@@ -777,30 +994,143 @@ void RA8875::setFontSpacing(uint8_t spc){//ok
 }
 /**************************************************************************/
 /*!	PRIVATE
-		This is the function that write text. Optimized to do block SPI transfers
+		Character cell of the current font in pixels, the internal font is 8x16,
+		the external ROM ASCII set is half width
 */
 /**************************************************************************/
-void RA8875::textWrite(const char* buffer, uint16_t len) {
-	bool goBack = false;
+template<class Panel>
+uint16_t RA8875T<Panel>::charWidth(void) {
+	uint8_t w = 8;
+	if (_fontSource == EXT) w = _textSize == X32 ? 16 : (_textSize == X24 ? 12 : 8);
+	return w * (_textScale + 1) + _fontSpacing;
+}
 
-	if (_currentMode == GRAPHIC){
-		changeMode(TEXT);
-		goBack = true;
-	}
+template<class Panel>
+uint16_t RA8875T<Panel>::lineHeight(void) {
+	uint8_t h = 16;
+	if (_fontSource == EXT) h = _textSize == X32 ? 32 : (_textSize == X24 ? 24 : 16);
+	return h * (_textScale + 1) + _fontInterline;
+}
 
+// start of the next line, back to the top when off the bottom; the chip
+// wraps text within the active window, which is the clip rect
+template<class Panel>
+void RA8875T<Panel>::newLine(void) {
+	_cursorX = _clipXL;
+	_cursorY += lineHeight();
+	if (_cursorY + lineHeight() > _clipYB + 1) _cursorY = _clipYT;
+	_cursorMoved = true;
+}
+
+/**************************************************************************/
+/*!	PRIVATE
+		Text layout, the cursor is tracked locally from the font metrics so
+		\n, \r, \t and wrapping at word boundaries need no reads from the chip.
+		Lines run between the edges of the clip rect, as the chip's do
+		between those of the active window. The chip cursor is only written
+		when the layout moved it.
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::textWrite(const char* buffer, uint16_t len) {
 	if (len == 0) len = strlen(buffer);
+	if (_clipXL > _clipXR || _clipYT > _clipYB) return;//nothing visible
+	const uint16_t cw = charWidth();
+	const int16_t right = _clipXR + 1;
+
+	uint16_t i = 0;
+	while (i < len) {
+		char c = buffer[i];
+		if (c == '\n') {// always do \r\n
+			newLine();
+			i++;
+			continue;
+		}
+		if (c == '\r') {
+			_cursorX = _clipXL;
+			_cursorMoved = true;
+			i++;
+			continue;
+		}
+		if (c == '\t') {
+			uint16_t tab = cw * RA8875_TABSIZE;
+			_cursorX = _clipXL + ((_cursorX - _clipXL) / tab + 1) * tab;
+			if (_cursorX >= right) newLine();
+			_cursorMoved = true;
+			i++;
+			continue;
+		}
 
-	uint8_t buf[len+3];
-	buf[0]= RA8875_CMDWRITE;
-	buf[1]= RA8875_MRWC;
-	buf[2]= RA8875_DATAWRITE;
-	memcpy(&buf[3], buffer, len);
+		// run of printable characters up to the next control character
+		uint16_t j = i;
+		while (j < len && buffer[j] != '\n' && buffer[j] != '\r' && buffer[j] != '\t') j++;
+		uint16_t n = j - i;
+		uint16_t fit = _cursorX < right ? (right - _cursorX) / cw : 0;
+
+		if (n <= fit) {
+			textSend(&buffer[i], n);
+			i = j;
+			continue;
+		}
+		if (!_textWrap) {// clip at the right edge
+			if (fit > 0) textSend(&buffer[i], fit);
+			_cursorX = right;
+			i = j;
+			continue;
+		}
 
-	// we do a block SPI transfer of the text data
-	writeBlock(buf, len+3);
+		// break at the last space that fits, a word longer than a line is split
+		uint16_t brk = fit;
+		while (brk > 0 && buffer[i + brk] != ' ') brk--;
+		if (brk == 0) {
+			if (_cursorX > _clipXL) {// try the word on a fresh line
+				newLine();
+				continue;
+			}
+			brk = fit > 0 ? fit : 1;
+		}
+		if (brk > 0) textSend(&buffer[i], brk);
+		newLine();
+		i += brk;
+		while (i < len && buffer[i] == ' ') i++;
+	}
+}
+
+/**************************************************************************/
+/*!	PRIVATE
+		Send a run of characters that fits on the current line
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::textSend(const char* buffer, uint16_t len) {
+	static const uint8_t header[3]= {RA8875_CMDWRITE, RA8875_MRWC, RA8875_DATAWRITE};
+
+	if (_cursorMoved) setCursor(_cursorX, _cursorY);
+
+	// stays in text mode until the next graphic operation switches back
+	changeMode(TEXT);
+
+	// header and text go out under one CS, no copy
+	writeBlock(header, sizeof(header), (const uint8_t *)buffer, len);
 	waitBusy(0x80);
+	_cursorX += len * charWidth();
+}
 
-	if (goBack) changeMode(GRAPHIC);
+/**************************************************************************/
+/*!	PRIVATE
+      RGB565 to the values of the color registers, 3:3:2 at 8bpp
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::colorRegs(uint16_t color, uint8_t data[3]){
+	data[0] = (color & 0xF800) >> 11;
+	data[1] = (color & 0x07E0) >> 5;
+	data[2] = color & 0x001F;
+	if (_color8) {
+		data[0] >>= 2;
+		data[1] >>= 3;
+		data[2] >>= 3;
+	}
 }
 
 /**************************************************************************/
@@ -810,15 +1140,18 @@ void RA8875::textWrite(const char* buffer, uint16_t len) {
 	  color:16bit color RGB565
 */
 /**************************************************************************/
-void RA8875::setForegroundColor(uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::setForegroundColor(uint16_t color){
+	bteWait();//solid fill and transparent BTE read these
+	uint8_t data[3];
+	colorRegs(color, data);
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_FGCR0,RA8875_FGCR1,RA8875_FGCR2};
-	uint8_t data[] = {(uint8_t)((color & 0xF800) >> 11),(uint8_t)((color & 0x07E0) >> 5),(uint8_t)(color & 0x001F)};
 	setMultipleRegisters(reg,data,3);
 #else
-	writeReg(RA8875_FGCR0,((color & 0xF800) >> 11));
-	writeReg(RA8875_FGCR1,((color & 0x07E0) >> 5));
-	writeReg(RA8875_FGCR2,(color & 0x001F));
+	writeReg(RA8875_FGCR0,data[0]);
+	writeReg(RA8875_FGCR1,data[1]);
+	writeReg(RA8875_FGCR2,data[2]);
 #endif
 }
 /**************************************************************************/
@@ -830,7 +1163,9 @@ void RA8875::setForegroundColor(uint16_t color){
 	  B:8bit BLUE
 */
 /**************************************************************************/
-void RA8875::setForegroundColor(uint8_t R,uint8_t G,uint8_t B){
+template<class Panel>
+void RA8875T<Panel>::setForegroundColor(uint8_t R,uint8_t G,uint8_t B){
+	bteWait();
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_FGCR0,RA8875_FGCR1,RA8875_FGCR2};
 	uint8_t data[] = {R,G,B};
@@ -848,15 +1183,17 @@ void RA8875::setForegroundColor(uint8_t R,uint8_t G,uint8_t B){
 	  color:16bit color RGB565
 */
 /**************************************************************************/
-void RA8875::setBackgroundColor(uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::setBackgroundColor(uint16_t color){
+	uint8_t data[3];
+	colorRegs(color, data);
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_BGCR0,RA8875_BGCR1,RA8875_BGCR2};
-	uint8_t data[] = {(uint8_t)((color & 0xF800) >> 11),(uint8_t)((color & 0x07E0) >> 5),(uint8_t)(color & 0x001F)};
 	setMultipleRegisters(reg,data,3);
 #else
-	writeReg(RA8875_BGCR0,((color & 0xF800) >> 11));
-	writeReg(RA8875_BGCR1,((color & 0x07E0) >> 5));
-	writeReg(RA8875_BGCR2,(color & 0x001F));
+	writeReg(RA8875_BGCR0,data[0]);
+	writeReg(RA8875_BGCR1,data[1]);
+	writeReg(RA8875_BGCR2,data[2]);
 #endif
 }
 /**************************************************************************/
@@ -868,7 +1205,8 @@ void RA8875::setBackgroundColor(uint16_t color){
 	  B:8bit BLUE
 */
 /**************************************************************************/
-void RA8875::setBackgroundColor(uint8_t R,uint8_t G,uint8_t B){
+template<class Panel>
+void RA8875T<Panel>::setBackgroundColor(uint8_t R,uint8_t G,uint8_t B){
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_BGCR0,RA8875_BGCR1,RA8875_BGCR2};
 	uint8_t data[] = {R,G,B};
@@ -886,15 +1224,18 @@ void RA8875::setBackgroundColor(uint8_t R,uint8_t G,uint8_t B){
 	  color:16bit color RGB565
 */
 /**************************************************************************/
-void RA8875::setTrasparentColor(uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::setTrasparentColor(uint16_t color){
+	bteWait();//solid fill and transparent BTE read these
+	uint8_t data[3];
+	colorRegs(color, data);
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_BGTR0,RA8875_BGTR1,RA8875_BGTR2};
-	uint8_t data[] = {(uint8_t)((color & 0xF800) >> 11),(uint8_t)((color & 0x07E0) >> 5),(uint8_t)(color & 0x001F)};
 	setMultipleRegisters(reg,data,3);
 #else
-	writeReg(RA8875_BGTR0,((color & 0xF800) >> 11));
-	writeReg(RA8875_BGTR1,((color & 0x07E0) >> 5));
-	writeReg(RA8875_BGTR2,(color & 0x001F));
+	writeReg(RA8875_BGTR0,data[0]);
+	writeReg(RA8875_BGTR1,data[1]);
+	writeReg(RA8875_BGTR2,data[2]);
 #endif
 }
 /**************************************************************************/
@@ -906,7 +1247,9 @@ void RA8875::setTrasparentColor(uint16_t color){
 	  B:8bit BLUE
 */
 /**************************************************************************/
-void RA8875::setTrasparentColor(uint8_t R,uint8_t G,uint8_t B){
+template<class Panel>
+void RA8875T<Panel>::setTrasparentColor(uint8_t R,uint8_t G,uint8_t B){
+	bteWait();
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_BGTR0,RA8875_BGTR1,RA8875_BGTR2};
 	uint8_t data[] = {R,G,B};
@@ -926,18 +1269,19 @@ void RA8875::setTrasparentColor(uint8_t R,uint8_t G,uint8_t B){
 		cur: 0...7
 */
 /**************************************************************************/
-void RA8875::setGraphicCursor(uint8_t cur) {
+template<class Panel>
+void RA8875T<Panel>::setGraphicCursor(uint8_t cur) {
 	if (cur > 7) cur = 7;
-	uint8_t temp = readReg(RA8875_MWCR1);
+	uint8_t temp = _MWCR1Reg;
 	temp &= ~(0x70);//clear bit 6,5,4
 	temp |= cur << 4;
-	temp |= cur;
 	if (_useMultiLayers){
 		_currentLayer == 1 ? temp |= (1 << 0) : temp &= ~(1 << 0);
 	} else {
 		temp &= ~(1 << 0);//
 	}
-	writeData(temp);
+	_MWCR1Reg = temp;
+	writeReg(RA8875_MWCR1,temp);
 }
 
 /**************************************************************************/
@@ -947,15 +1291,96 @@ void RA8875::setGraphicCursor(uint8_t cur) {
 		cur: true,false
 */
 /**************************************************************************/
-void RA8875::showGraphicCursor(bool cur) {
-	uint8_t temp = readReg(RA8875_MWCR1);
+template<class Panel>
+void RA8875T<Panel>::showGraphicCursor(bool cur) {
+	uint8_t temp = _MWCR1Reg;
 	cur == true ? temp |= (1 << 7) : temp &= ~(1 << 7);
 	if (_useMultiLayers){
 		_currentLayer == 1 ? temp |= (1 << 0) : temp &= ~(1 << 0);
 	} else {
 		temp &= ~(1 << 0);//
 	}
-	writeData(temp);
+	_MWCR1Reg = temp;
+	writeReg(RA8875_MWCR1,temp);
+}
+
+/**************************************************************************/
+/*!		Store a graphic cursor image and select it
+		Parameters:
+		cur: 0...7
+		image: 32x32 pixels, 2 bits each, 4 pixels a byte, first pixel in
+		the high bits (see encodeGraphicCursor)
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::uploadGraphicCursor(uint8_t cur, const uint8_t image[256]) {
+	changeMode(GRAPHIC);
+	setGraphicCursor(cur);
+	writeTo(CURSOR);
+	writeCommand(RA8875_MRWC);
+	uint8_t head[] = {RA8875_DATAWRITE};
+	writeBlock(head,sizeof(head),image,256);
+	writeTo(_currentLayer == 0 ? L1 : L2);
+}
+
+/**************************************************************************/
+/*!		Pack a cursor drawn as text for uploadGraphicCursor
+		Parameters:
+		rows: n lines of up to 32 characters, '0' and '1' the cursor colors,
+		'x' the inverted background, anything else (and what's missing)
+		shows the background
+		image: 256 bytes
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::encodeGraphicCursor(const char * const rows[], uint8_t n, uint8_t image[256]) {
+	for (uint16_t i=0;i<256;i++) image[i] = 0xAA;//background
+	for (uint8_t y=0;y<n && y<32;y++){
+		const char *row = rows[y];
+		for (uint8_t x=0;x<32 && row[x] != 0;x++){
+			uint8_t code;
+			switch (row[x]){
+				case '0': code = 0; break;
+				case '1': code = 1; break;
+				case 'x': code = 3; break;
+				default: continue;
+			}
+			uint8_t shift = 6 - 2 * (x & 3);
+			uint8_t &b = image[y * 8 + x / 4];
+			b = (b & ~(3 << shift)) | (code << shift);
+		}
+	}
+}
+
+/**************************************************************************/
+/*!		Graphic cursor colors
+		Parameters:
+		color0,color1: RGB565, the cursor keeps 8 bits (RGB332)
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::setGraphicCursorColors(uint16_t color0, uint16_t color1) {
+	writeReg(RA8875_GCC0,((color0 >> 8) & 0xE0) | ((color0 >> 6) & 0x1C) | ((color0 >> 3) & 0x03));
+	writeReg(RA8875_GCC1,((color1 >> 8) & 0xE0) | ((color1 >> 6) & 0x1C) | ((color1 >> 3) & 0x03));
+}
+
+/**************************************************************************/
+/*!		Move the graphic cursor, nothing is redrawn: at most the four
+		position registers are written, usually only the low bytes
+		Parameters:
+		x,y: top left of the 32x32 image
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::moveGraphicCursor(int16_t x, int16_t y) {
+	static const uint8_t reg[] = {RA8875_GCHP0,RA8875_GCHP1,RA8875_GCVP0,RA8875_GCVP1};
+	if (x < 0) x = 0;
+	if (y < 0) y = 0;
+	if (x >= W()) x = W()-1;
+	if (y >= H()) y = H()-1;
+	uint8_t data[] = {(uint8_t)x,(uint8_t)(x >> 8),(uint8_t)y,(uint8_t)(y >> 8)};
+	changedRegisters(reg,data,_gcursorPos,4,_gcursorPosValid);
+	_gcursorPosValid = true;
 }
 
 /**************************************************************************/
@@ -963,10 +1388,16 @@ void RA8875::showGraphicCursor(bool cur) {
 	From Adafruit_RA8875, need to be fixed!!!!!!!!!
 */
 /**************************************************************************/
-bool RA8875::waitPoll(uint8_t regname, uint8_t waitflag) {
+template<class Panel>
+bool RA8875T<Panel>::waitPoll(uint8_t regname, uint8_t waitflag) {
+	uint32_t spins = 0;
 	while (1) {
 		uint8_t temp = readReg(regname);
-		if (!(temp & waitflag)) return true;
+		if (!(temp & waitflag)) {
+			TRACE(TRACE_WAITPOLL, regname, spins);
+			return true;
+		}
+		spins++;
 	}
 	return false; // MEMEFIX: yeah i know, unreached! - add timeout?
 }
@@ -978,7 +1409,8 @@ bool RA8875::waitPoll(uint8_t regname, uint8_t waitflag) {
 	res:0x80(for most operations),0x40(BTE wait), 0x01(DMA wait)
 */
 /**************************************************************************/
-void RA8875::waitBusy(uint8_t res) {
+template<class Panel>
+void RA8875T<Panel>::waitBusy(uint8_t res) {
 	uint8_t w;
 	do {
 	if (res == 0x01) writeCommand(RA8875_DMACR);//dma
@@ -995,7 +1427,8 @@ void RA8875::waitBusy(uint8_t res) {
 		y:vertical position
 */
 /**************************************************************************/
-void RA8875::setXY(int16_t x, int16_t y) {
+template<class Panel>
+void RA8875T<Panel>::setXY(int16_t x, int16_t y) {
 	if (x < 0) x = 0;
 	if (y < 0) y = 0;
 
@@ -1003,8 +1436,9 @@ void RA8875::setXY(int16_t x, int16_t y) {
 	setY(y);
 }
 
-void RA8875::setX(uint16_t x) {
-	if (x >= _width) x = _width-1;
+template<class Panel>
+void RA8875T<Panel>::setX(uint16_t x) {
+	if (x >= W()) x = W()-1;
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_CURH0,RA8875_CURH1};
 	uint8_t data[] = {(uint8_t)x,(uint8_t)(x >> 8)};
@@ -1016,8 +1450,9 @@ void RA8875::setX(uint16_t x) {
 
 }
 
-void RA8875::setY(uint16_t y) {
-	if (y >= _height) y = _height-1;
+template<class Panel>
+void RA8875T<Panel>::setY(uint16_t y) {
+	if (y >= H()) y = H()-1;
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_CURV0,RA8875_CURV1};
 	uint8_t data[] = {(uint8_t)y,(uint8_t)(y >> 8)};
@@ -1059,7 +1494,8 @@ void RA8875::setY(uint16_t y) {
 
 */
 /**************************************************************************/
-void RA8875::setScrollWindow(int16_t XL,int16_t XR ,int16_t YT ,int16_t YB){
+template<class Panel>
+void RA8875T<Panel>::setScrollWindow(int16_t XL,int16_t XR ,int16_t YT ,int16_t YB){
 	checkLimitsHelper(XL,YT);
 	checkLimitsHelper(XR,YB);
 
@@ -1089,7 +1525,8 @@ void RA8875::setScrollWindow(int16_t XL,int16_t XR ,int16_t YT ,int16_t YB){
 
 */
 /**************************************************************************/
-void RA8875::scroll(uint16_t x,uint16_t y){
+template<class Panel>
+void RA8875T<Panel>::scroll(uint16_t x,uint16_t y){
 	if (y > _scrollYB) y = _scrollYB;//??? mmmm... not sure
 	if (_scrollXL == 0 && _scrollXR == 0 && _scrollYT == 0 && _scrollYB == 0){
 		//do nothing, scroll window inactive
@@ -1113,7 +1550,8 @@ void RA8875::scroll(uint16_t x,uint16_t y){
 
 */
 /**************************************************************************/
-void RA8875::DMA_blockModeSize(int16_t BWR,int16_t BHR,int16_t SPWR){
+template<class Panel>
+void RA8875T<Panel>::DMA_blockModeSize(int16_t BWR,int16_t BHR,int16_t SPWR){
   	writeReg(RA8875_DTNR0,BWR);
   	writeReg(RA8875_BWR1,BWR >> 8);
 
@@ -1129,7 +1567,8 @@ void RA8875::DMA_blockModeSize(int16_t BWR,int16_t BHR,int16_t SPWR){
 
 */
 /**************************************************************************/
-void RA8875::DMA_startAddress(unsigned long adrs){
+template<class Panel>
+void RA8875T<Panel>::DMA_startAddress(unsigned long adrs){
   	writeReg(RA8875_SSAR0,adrs);
   	writeReg(RA8875_SSAR1,adrs >> 8);
 	writeReg(RA8875_SSAR2,adrs >> 16);
@@ -1144,14 +1583,16 @@ void RA8875::DMA_startAddress(unsigned long adrs){
 
 */
 /**************************************************************************/
-void RA8875::drawFlashImage(int16_t x,int16_t y,int16_t w,int16_t h,uint8_t picnum){
+template<class Panel>
+void RA8875T<Panel>::drawFlashImage(int16_t x,int16_t y,int16_t w,int16_t h,uint8_t picnum){
+	changeMode(GRAPHIC);
 	checkLimitsHelper(x,y);
 	checkLimitsHelper(w,h);
 
 	writeReg(RA8875_SFCLR,0x00);
 	writeReg(RA8875_SROC,0x87);
 	writeReg(RA8875_DMACR,0x02);
-	//setActiveWindow(0,_width-1,0,_height-1);
+	//setActiveWindow(0,W()-1,0,H()-1);
 
 	setXY(x,y);
 
@@ -1162,77 +1603,232 @@ void RA8875::drawFlashImage(int16_t x,int16_t y,int16_t w,int16_t h,uint8_t picn
 }
 
 /**************************************************************************/
-/*!
+/*! PRIVATE
+		Program and start the Block Transfer Engine, it runs while we return.
+		The next BTE, mode change, color or layer change waits for it (bteWait)
+		Parameters:
+		srcLayer,sx,sy: source layer (0,1) and point
+		dstLayer,dx,dy: destination layer (0,1) and point
+		w,h: size
+		becr1: ROP << 4 | operation
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::bteStart(uint8_t srcLayer, int16_t sx, int16_t sy, uint8_t dstLayer, int16_t dx, int16_t dy, int16_t w, int16_t h, uint8_t becr1){
+	bteWait();
+	// the layers are bit 7 of VSBE1/VDBE1
+	uint8_t reg[] = {RA8875_HSBE0,RA8875_HSBE1,RA8875_VSBE0,RA8875_VSBE1,RA8875_HDBE0,RA8875_HDBE1,RA8875_VDBE0,RA8875_VDBE1,
+					 RA8875_BEWR0,RA8875_BEWR1,RA8875_BEHR0,RA8875_BEHR1,RA8875_BECR1};
+	uint8_t data[] = {(uint8_t)sx,(uint8_t)(sx >> 8),(uint8_t)sy,(uint8_t)((sy >> 8) | (srcLayer << 7)),
+					  (uint8_t)dx,(uint8_t)(dx >> 8),(uint8_t)dy,(uint8_t)((dy >> 8) | (dstLayer << 7)),
+					  (uint8_t)w,(uint8_t)(w >> 8),(uint8_t)h,(uint8_t)(h >> 8),becr1};
+	setMultipleRegisters(reg,data,sizeof(reg));
+	writeReg(RA8875_BECR0,0x80);//block to block, start
+	_btePending = true;
+}
 
+/**************************************************************************/
+/*! PRIVATE
+		Shrink a BTE block so the source stays on screen and the
+		destination inside the clip rect, the chip is prone to freeze
+		with values out of range. Returns false if nothing is left
 */
 /**************************************************************************/
-void RA8875::BTE_size(uint16_t w, uint16_t h){
-    writeReg(RA8875_BEWR0,w);//BET area width literacy
-    writeReg(RA8875_BEWR1,w >> 8);//BET area width literacy
-    writeReg(RA8875_BEHR0,h);//BET area height literacy
-    writeReg(RA8875_BEHR1,h >> 8);//BET area height literacy
+template<class Panel>
+bool RA8875T<Panel>::bteClip(int16_t &sx, int16_t &sy, int16_t &dx, int16_t &dy, int16_t &w, int16_t &h){
+	int16_t d;
+	// source on screen, destination in the clip rect, both move together
+	d = max(-sx, _clipXL - dx);
+	if (d > 0) { sx += d; dx += d; w -= d; }
+	d = max(-sy, _clipYT - dy);
+	if (d > 0) { sy += d; dy += d; h -= d; }
+	if (w > (int16_t)W() - sx) w = W() - sx;
+	if (w > _clipXR + 1 - dx) w = _clipXR + 1 - dx;
+	if (h > (int16_t)H() - sy) h = H() - sy;
+	if (h > _clipYB + 1 - dy) h = _clipYB + 1 - dy;
+	return w > 0 && h > 0;
 }
 
 /**************************************************************************/
 /*!
-
+		Copy a rectangle inside the layer we write to, overlapping
+		areas are fine (panning, scrolling charts)
+		Parameters:
+		sx,sy: source top left
+		dx,dy: destination top left
+		w,h: size
+		rop: how source and destination combine, ROP_S is a plain copy
 */
 /**************************************************************************/
-void RA8875::BTE_source(uint16_t SX,uint16_t DX ,uint16_t SY ,uint16_t DY){
-	uint8_t temp0,temp1;
-    writeReg(RA8875_HSBE0,SX);//BTE horizontal position of read/write data
-    writeReg(RA8875_HSBE1,SX >> 8);//BTE horizontal position of read/write data
-
-    writeReg(RA8875_HDBE0,DX);//BET written to the target horizontal position
-    writeReg(RA8875_HDBE1,DX >> 8);//BET written to the target horizontal position
-
-    writeReg(RA8875_VSBE0,SY);//BTE vertical position of read/write data
-
-	temp0 = SY >> 8;
-	temp1 = readReg(RA8875_VSBE1);
-	temp1 &= 0x80;
-    temp0 = temp0 | temp1;
-	writeReg(RA8875_VSBE1,temp0);//BTE vertical position of read/write data
+template<class Panel>
+void RA8875T<Panel>::copyRect(int16_t sx, int16_t sy, int16_t dx, int16_t dy, int16_t w, int16_t h, enum RA8875rop rop){
+	copyRect(_currentLayer,sx,sy,_currentLayer,dx,dy,w,h,rop);
+}
 
-    writeReg(RA8875_VDBE0,DY);//BET written to the target  vertical  position
+/**************************************************************************/
+/*!
+		Copy a rectangle from a layer to a layer (0:layer 1, 1:layer 2)
+		Parameters:
+		srcLayer,sx,sy: source layer and top left
+		dstLayer,dx,dy: destination layer and top left
+		w,h: size
+		rop: how source and destination combine, ROP_S is a plain copy
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::copyRect(uint8_t srcLayer, int16_t sx, int16_t sy, uint8_t dstLayer, int16_t dx, int16_t dy, int16_t w, int16_t h, enum RA8875rop rop){
+	if (!bteClip(sx,sy,dx,dy,w,h)) return;
+	if (srcLayer == dstLayer && (dy > sy || (dy == sy && dx > sx))) {
+		// destination after the source, copy backwards from the bottom right corner
+		bteStart(srcLayer,sx + w - 1,sy + h - 1,dstLayer,dx + w - 1,dy + h - 1,w,h,(rop << 4) | 0x03);
+	} else {
+		bteStart(srcLayer,sx,sy,dstLayer,dx,dy,w,h,(rop << 4) | 0x02);
+	}
+}
 
-	temp0 = DY >> 8;
-	temp1 = readReg(RA8875_VDBE1);
-	temp1 &= 0x80;
-	temp0 = temp0 | temp1;
-	writeReg(RA8875_VDBE1,temp0);//BET written to the target  vertical  position
+/**************************************************************************/
+/*!
+		Copy a rectangle leaving out the pixels of the setTrasparentColor color,
+		e.g. stamp UI chrome kept on the hidden layer. Source and destination
+		must not overlap on the same layer
+		Parameters:
+		srcLayer,sx,sy: source layer and top left
+		dstLayer,dx,dy: destination layer and top left
+		w,h: size
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::stampRect(uint8_t srcLayer, int16_t sx, int16_t sy, uint8_t dstLayer, int16_t dx, int16_t dy, int16_t w, int16_t h){
+	if (!bteClip(sx,sy,dx,dy,w,h)) return;
+	bteStart(srcLayer,sx,sy,dstLayer,dx,dy,w,h,(ROP_S << 4) | 0x05);
 }
 
 /**************************************************************************/
-/*! TESTING
+/*!
+		Move a rectangle inside the layer we write to, the part of
+		the source the destination doesn't cover is filled
+		Parameters:
+		sx,sy: source top left
+		dx,dy: destination top left
+		w,h: size
+		fill: RGB565 color for the uncovered area
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::moveRect(int16_t sx, int16_t sy, int16_t dx, int16_t dy, int16_t w, int16_t h, uint16_t fill){
+	copyRect(sx,sy,dx,dy,w,h);
+	int16_t mx = dx - sx, my = dy - sy;
+	int16_t ax = mx < 0 ? -mx : mx, ay = my < 0 ? -my : my;
+	if (ax >= w || ay >= h) {//no overlap
+		solidFill(sx,sy,w,h,fill);
+		return;
+	}
+	if (my > 0) solidFill(sx,sy,w,my,fill);
+	else if (my < 0) solidFill(sx,sy + h + my,w,-my,fill);
+	// the rows source and destination share
+	int16_t oy = my > 0 ? dy : sy;
+	int16_t oh = h - ay;
+	if (mx > 0) solidFill(sx,oy,mx,oh,fill);
+	else if (mx < 0) solidFill(sx + w + mx,oy,-mx,oh,fill);
+}
 
+/**************************************************************************/
+/*!
+		Fill a rectangle of the layer we write to with the BTE, unlike
+		fillRect it doesn't wait for the fill to end
+		Parameters:
+		x,y: top left
+		w,h: size
+		color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::BTE_ROP_code(unsigned char setx){//
-    writeReg(RA8875_BECR1,setx);//BECR1
+template<class Panel>
+void RA8875T<Panel>::solidFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color){
+	int16_t sx = 0, sy = 0;
+	if (!bteClip(sx,sy,x,y,w,h)) return;
+	setForegroundColor(color);
+	bteStart(_currentLayer,0,0,_currentLayer,x,y,w,h,(ROP_S << 4) | 0x0C);
 }
 
 /**************************************************************************/
-/*! TESTING
+/*!
+		Store an 8x8 pattern in the pattern RAM
+		Parameters:
+		n: pattern number 0...15
+		pixels: 64 RGB565 colors, row by row
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::uploadPattern(uint8_t n, const uint16_t pixels[64]){
+	changeMode(GRAPHIC);
+	writeReg(RA8875_PTNO,n & 0x0F);//8x8
+	writeTo(PATTERN);
+	writeCommand(RA8875_MRWC);
+	uint8_t head[] = {RA8875_DATAWRITE};
+	uint8_t buf[128];
+	uint8_t len = 0;
+	for (uint8_t i=0;i<64;i++){
+		if (_color8) {
+			uint8_t d[3];
+			colorRegs(pixels[i], d);
+			buf[len++] = (d[0] << 5) | (d[1] << 2) | d[2];
+		} else {
+			buf[len++] = pixels[i] >> 8;
+			buf[len++] = pixels[i];
+		}
+	}
+	writeBlock(head,sizeof(head),buf,len);
+	writeTo(_currentLayer == 0 ? L1 : L2);
+}
 
+/**************************************************************************/
+/*!
+		Tile a rectangle of the layer we write to with a stored pattern
+		Parameters:
+		x,y: top left
+		w,h: size
+		n: pattern number 0...15 (see uploadPattern)
+		rop: how pattern and destination combine, ROP_S is a plain fill
 */
 /**************************************************************************/
-void RA8875::BTE_enable(void) {
-	uint8_t temp = readReg(RA8875_BECR0);
-	temp |= (1 << 7); //bit set 7
-	writeReg(RA8875_BECR0,temp);
+template<class Panel>
+void RA8875T<Panel>::patternFill(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t n, enum RA8875rop rop){
+	int16_t sx = 0, sy = 0;
+	if (!bteClip(sx,sy,x,y,w,h)) return;
+	bteWait();
+	writeReg(RA8875_PTNO,n & 0x0F);
+	bteStart(_currentLayer,0,0,_currentLayer,x,y,w,h,(rop << 4) | 0x06);
 }
 
+/**************************************************************************/
+/*!
+		Tile a rectangle with a stored pattern leaving out the pixels of
+		the setTrasparentColor color
+		Parameters:
+		x,y: top left
+		w,h: size
+		n: pattern number 0...15 (see uploadPattern)
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::patternStamp(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t n){
+	int16_t sx = 0, sy = 0;
+	if (!bteClip(sx,sy,x,y,w,h)) return;
+	bteWait();
+	writeReg(RA8875_PTNO,n & 0x0F);
+	bteStart(_currentLayer,0,0,_currentLayer,x,y,w,h,(ROP_S << 4) | 0x07);
+}
 
 /**************************************************************************/
 /*! TESTING
 
 */
 /**************************************************************************/
-void RA8875::writeTo(enum RA8875writes d){
-	uint8_t temp = readReg(RA8875_MWCR1);
+template<class Panel>
+void RA8875T<Panel>::writeTo(enum RA8875writes d){
+	bteWait();
+	uint8_t temp = _MWCR1Reg;//no readback, the library is the only writer
 	switch(d){
-		if (_useMultiLayers){
 		case L1:
 			temp &= ~((1<<3) | (1<<2));// Clear bits 3 and 2
 			temp &= ~(1 << 0); //clear bit 0
@@ -1243,7 +1839,6 @@ void RA8875::writeTo(enum RA8875writes d){
 			temp |= (1 << 0); //bit set 0
 			_currentLayer = 1;
 		break;
-		}
 		case CGRAM:
 			temp &= ~(1 << 3); //clear bit 3
 			temp |= (1 << 2); //bit set 2
@@ -1263,6 +1858,7 @@ void RA8875::writeTo(enum RA8875writes d){
 		default:
 		break;
 	}
+	_MWCR1Reg = temp;
 	writeReg(RA8875_MWCR1,temp);
 }
 
@@ -1286,8 +1882,10 @@ void RA8875::writeTo(enum RA8875writes d){
 	  color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::drawPixel(int16_t x, int16_t y, uint16_t color){
-	//checkLimitsHelper(x,y);
+template<class Panel>
+void RA8875T<Panel>::drawPixel(int16_t x, int16_t y, uint16_t color){
+	if (x < _clipXL || x > _clipXR || y < _clipYT || y > _clipYB) return;
+	changeMode(GRAPHIC);
 	setXY(x,y);
 #if defined _SPI_HYPERDRIVE && (defined(__MK20DX128__) || defined(__MK20DX256__))
 	SPI.beginTransaction(settings);
@@ -1299,10 +1897,78 @@ void RA8875::drawPixel(int16_t x, int16_t y, uint16_t color){
 	SPI.endTransaction();
 #else
 	writeCommand(RA8875_MRWC);
-	writeData16(color);
+	if (_color8) {
+		uint8_t d[3];
+		colorRegs(color, d);
+		writeData((d[0] << 5) | (d[1] << 2) | d[2]);
+	} else {
+		writeData16(color);
+	}
 #endif
 }
 
+/**************************************************************************/
+/*!
+		Start a pixel stream: the box becomes the active window and the
+		pixels pushed fill it row by row
+		Parameters:
+		x,y,w,h: the box, cut down to the clip rect on return
+		Returns false when nothing of it is visible
+*/
+/**************************************************************************/
+template<class Panel>
+bool RA8875T<Panel>::beginPixels(int16_t &x, int16_t &y, int16_t &w, int16_t &h){
+	int16_t xr = min(x + w - 1,_clipXR), yb = min(y + h - 1,_clipYB);
+	x = max(x,_clipXL); y = max(y,_clipYT);
+	if (x > xr || y > yb) return false;
+	w = xr - x + 1; h = yb - y + 1;
+	changeMode(GRAPHIC);
+	setActiveWindow(x,xr,y,yb);
+	setXY(x,y);
+	writeCommand(RA8875_MRWC);
+	return true;
+}
+
+/**************************************************************************/
+/*!
+		Send pixels of the stream started by beginPixels
+		Parameters:
+		p: RGB565 colors
+		n: how many
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::pushPixels(const uint16_t p[], uint16_t n){
+	uint8_t head[] = {RA8875_DATAWRITE};
+	uint8_t buf[128];
+	while (n > 0) {
+		uint8_t len = 0;
+		while (n > 0 && len < sizeof(buf)) {
+			if (_color8) {
+				uint8_t d[3];
+				colorRegs(*p, d);
+				buf[len++] = (d[0] << 5) | (d[1] << 2) | d[2];
+			} else {
+				buf[len++] = *p >> 8;
+				buf[len++] = *p;
+			}
+			p++;
+			n--;
+		}
+		writeBlock(head,sizeof(head),buf,len);
+	}
+}
+
+/**************************************************************************/
+/*!
+		End a pixel stream, the active window is the clip rect again
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::endPixels(void){
+	setActiveWindow(_clipXL,_clipXR,_clipYT,_clipYB);
+}
+
 /**************************************************************************/
 /*!
       Basic line draw
@@ -1314,10 +1980,10 @@ void RA8875::drawPixel(int16_t x, int16_t y, uint16_t color){
 	  color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
-	checkLimitsHelper(x0,y0);
-	if (x1 >= _width) x1 = _width-1;
-	if (y1 >= _height) y1 = _height-1;
+template<class Panel>
+void RA8875T<Panel>::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color){
+	if (!clipLine(x0,y0,x1,y1)) return;
+	changeMode(GRAPHIC);
 
 	lineAddressing(x0,y0,x1,y1);
 
@@ -1338,7 +2004,8 @@ void RA8875::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t c
 	  color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color){
 	if (h < 1) h = 1;
 	drawLine(x, y, x, y+h, color);
 }
@@ -1354,7 +2021,8 @@ void RA8875::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color){
 	  color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color){
 	if (w < 1) w = 1;
 	drawLine(x, y, x+w, y, color);
 }
@@ -1370,7 +2038,8 @@ void RA8875::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color){
 	  color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color){
 	rectHelper(x, y, x+w, y+h, color, false);
 }
 
@@ -1385,7 +2054,8 @@ void RA8875::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color
 	  color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color){
 	rectHelper(x, y, x+w, y+h, color, true);
 }
 
@@ -1396,8 +2066,9 @@ void RA8875::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color
 	  color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::fillScreen(uint16_t color){
-	rectHelper(0, 0, _width-1, _height-1, color, true);
+template<class Panel>
+void RA8875T<Panel>::fillScreen(uint16_t color){
+	rectHelper(0, 0, W()-1, H()-1, color, true);
 }
 
 /**************************************************************************/
@@ -1410,7 +2081,8 @@ void RA8875::fillScreen(uint16_t color){
       color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
 	if (r <= 0) return;
 	circleHelper(x0, y0, r, color, false);
 }
@@ -1425,11 +2097,95 @@ void RA8875::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
       color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
 	if (r <= 0) return;
 	circleHelper(x0, y0, r, color, true);
 }
 
+/**************************************************************************/
+/*!
+      Draw many filled circles. Circles of the same color are drawn
+	  together in their order, so differently colored circles that
+	  overlap may stack differently than with single calls
+	  Parameters:
+	  c: the circles
+	  n: how many
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::fillCircles(const RA8875circle c[], uint16_t n){
+	uint8_t shadow[5];
+	bool valid = false;
+	changeMode(GRAPHIC);
+	for (uint16_t i=0;i<n;i++){
+		uint16_t j = 0;
+		while (j < i && c[j].color != c[i].color) j++;
+		if (j < i) continue;//color already done
+		setForegroundColor(c[i].color);
+		circleRun(c + i, n - i, c[i].color, false, shadow, valid);
+	}
+}
+
+/**************************************************************************/
+/*!
+      Draw many filled circles of one color (their color is ignored)
+	  Parameters:
+	  c: the circles
+	  n: how many
+	  color: RGB565 color
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::fillCircles(const RA8875circle c[], uint16_t n, uint16_t color){
+	uint8_t shadow[5];
+	bool valid = false;
+	changeMode(GRAPHIC);
+	setForegroundColor(color);
+	circleRun(c, n, color, true, shadow, valid);
+}
+
+/**************************************************************************/
+/*!
+      Draw many filled rects, same color ones are drawn together
+	  as with fillCircles
+	  Parameters:
+	  r: the rects
+	  n: how many
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::fillRects(const RA8875rect r[], uint16_t n){
+	uint8_t shadow[8];
+	bool valid = false;
+	changeMode(GRAPHIC);
+	for (uint16_t i=0;i<n;i++){
+		uint16_t j = 0;
+		while (j < i && r[j].color != r[i].color) j++;
+		if (j < i) continue;//color already done
+		setForegroundColor(r[i].color);
+		rectRun(r + i, n - i, r[i].color, false, shadow, valid);
+	}
+}
+
+/**************************************************************************/
+/*!
+      Draw many filled rects of one color (their color is ignored)
+	  Parameters:
+	  r: the rects
+	  n: how many
+	  color: RGB565 color
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::fillRects(const RA8875rect r[], uint16_t n, uint16_t color){
+	uint8_t shadow[8];
+	bool valid = false;
+	changeMode(GRAPHIC);
+	setForegroundColor(color);
+	rectRun(r, n, color, true, shadow, valid);
+}
+
 /**************************************************************************/
 /*!
       Draw Triangle
@@ -1443,7 +2199,8 @@ void RA8875::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color){
       color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color){
 	triangleHelper(x0, y0, x1, y1, x2, y2, color, false);
 }
 
@@ -1460,7 +2217,8 @@ void RA8875::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_
       color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color){
 	triangleHelper(x0, y0, x1, y1, x2, y2, color, true);
 }
 
@@ -1475,7 +2233,8 @@ void RA8875::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_
       color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::drawEllipse(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::drawEllipse(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint16_t color){
 	ellipseHelper(xCenter, yCenter, longAxis, shortAxis, color, false);
 }
 
@@ -1490,7 +2249,8 @@ void RA8875::drawEllipse(int16_t xCenter, int16_t yCenter, int16_t longAxis, int
       color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::fillEllipse(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::fillEllipse(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint16_t color){
 	ellipseHelper(xCenter, yCenter, longAxis, shortAxis, color, true);
 }
 
@@ -1506,7 +2266,8 @@ void RA8875::fillEllipse(int16_t xCenter, int16_t yCenter, int16_t longAxis, int
       color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::drawCurve(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint8_t curvePart, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::drawCurve(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint8_t curvePart, uint16_t color){
 	curveHelper(xCenter, yCenter, longAxis, shortAxis, curvePart, color, false);
 }
 
@@ -1522,7 +2283,8 @@ void RA8875::drawCurve(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16
       color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::fillCurve(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint8_t curvePart, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::fillCurve(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint8_t curvePart, uint16_t color){
 	curveHelper(xCenter, yCenter, longAxis, shortAxis, curvePart, color, true);
 }
 
@@ -1538,7 +2300,8 @@ void RA8875::fillCurve(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16
       color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color){
 	roundRectHelper(x, y, x+w, y+h, r, color, false);
 }
 
@@ -1555,7 +2318,8 @@ void RA8875::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r
       color: RGB565 color
 */
 /**************************************************************************/
-void RA8875::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color){
+template<class Panel>
+void RA8875T<Panel>::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color){
 	roundRectHelper(x, y, x+w, y+h, r, color, true);
 }
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -1566,9 +2330,15 @@ void RA8875::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r
       helper function for circles
 */
 /**************************************************************************/
-void RA8875::circleHelper(int16_t x0, int16_t y0, int16_t r, uint16_t color, bool filled){
-	checkLimitsHelper(x0,y0);
+template<class Panel>
+void RA8875T<Panel>::circleHelper(int16_t x0, int16_t y0, int16_t r, uint16_t color, bool filled){
 	if (r < 1) r = 1;
+	if (clipOut(x0 - r,y0 - r,x0 + r,y0 + r)) return;
+	if (!engineFits(x0,y0) || r > 255) {
+		softEllipse(x0,y0,r,r,0x0F,filled,color);
+		return;
+	}
+	changeMode(GRAPHIC);
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_DCHR0,RA8875_DCHR1,RA8875_DCVR0,RA8875_DCVR1,RA8875_DCRR};
 	uint8_t data[] = {(uint8_t)x0,(uint8_t)(x0 >> 8),(uint8_t)y0,(uint8_t)(y0 >> 8),(uint8_t)r};
@@ -1589,15 +2359,106 @@ void RA8875::circleHelper(int16_t x0, int16_t y0, int16_t r, uint16_t color, boo
 	waitPoll(RA8875_DCR, RA8875_DCR_CIRCLE_STATUS);//ZzZzz
 }
 
+/**************************************************************************/
+/*!
+		write the registers whose value is not already in shadow
+		(all of them if the shadow isn't valid yet)
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::changedRegisters(const uint8_t reg[], const uint8_t data[], uint8_t shadow[], uint8_t len, bool valid){
+	for (uint8_t i=0;i<len;i++){
+		if (valid && shadow[i] == data[i]) continue;
+		writeReg(reg[i],data[i]);
+		shadow[i] = data[i];
+	}
+}
+
+/**************************************************************************/
+/*!
+		batch helper for filled circles, the foreground color is set.
+		Draws the circles of that color (or all of them), usually only
+		the low bytes of the center change from one to the next. The
+		engine reads its registers while it draws, so the next circle's
+		are written after the wait; only clipping and packing it overlap
+		the drawing, the bus traffic does not
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::circleRun(const RA8875circle c[], uint16_t n, uint16_t color, bool all, uint8_t shadow[5], bool &valid){
+	static const uint8_t reg[] = {RA8875_DCHR0,RA8875_DCHR1,RA8875_DCVR0,RA8875_DCVR1,RA8875_DCRR};
+	bool busy = false;
+	for (uint16_t i=0;i<n;i++){
+		if (!all && c[i].color != color) continue;
+		int16_t x0 = c[i].x, y0 = c[i].y, r = c[i].r;
+		if (r <= 0) continue;
+		if (clipOut(x0 - r,y0 - r,x0 + r,y0 + r)) continue;
+		if (!engineFits(x0,y0) || r > 255) {
+			if (busy) waitPoll(RA8875_DCR, RA8875_DCR_CIRCLE_STATUS);
+			busy = false;
+			softEllipse(x0,y0,r,r,0x0F,true,color);//the foreground stays color
+			continue;
+		}
+		uint8_t data[] = {(uint8_t)x0,(uint8_t)(x0 >> 8),(uint8_t)y0,(uint8_t)(y0 >> 8),(uint8_t)r};
+		// clipped and packed while the engine drew, its registers wait
+		if (busy) waitPoll(RA8875_DCR, RA8875_DCR_CIRCLE_STATUS);
+		changedRegisters(reg,data,shadow,5,valid);
+		valid = true;
+		writeCommandData(RA8875_DCR, RA8875_DCR_CIRCLE_START | RA8875_DCR_FILL);
+		busy = true;
+	}
+	if (busy) waitPoll(RA8875_DCR, RA8875_DCR_CIRCLE_STATUS);
+}
+
+/**************************************************************************/
+/*!
+		batch helper for filled rects, as circleRun
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::rectRun(const RA8875rect r[], uint16_t n, uint16_t color, bool all, uint8_t shadow[8], bool &valid){
+	static const uint8_t reg[] = {RA8875_DLHSR0,RA8875_DLHSR1,RA8875_DLVSR0,RA8875_DLVSR1,RA8875_DLHER0,RA8875_DLHER1,RA8875_DLVER0,RA8875_DLVER1};
+	bool busy = false;
+	for (uint16_t i=0;i<n;i++){
+		if (!all && r[i].color != color) continue;
+		int16_t x = r[i].x, y = r[i].y, w = r[i].w, h = r[i].h;
+		if (w < 1) w = 1;
+		if (h < 1) h = 1;
+		int16_t x1 = x + w, y1 = y + h;//as fillRect
+		if (clipOut(x,y,x1,y1)) continue;
+		x = max(x,_clipXL); y = max(y,_clipYT);
+		x1 = min(x1,_clipXR); y1 = min(y1,_clipYB);
+		uint8_t data[] = {(uint8_t)x,(uint8_t)(x >> 8),(uint8_t)y,(uint8_t)(y >> 8),(uint8_t)x1,(uint8_t)(x1 >> 8),(uint8_t)y1,(uint8_t)(y1 >> 8)};
+		if (busy) waitPoll(RA8875_DCR, RA8875_DCR_LINESQUTRI_STATUS);
+		changedRegisters(reg,data,shadow,8,valid);
+		valid = true;
+		writeCommandData(RA8875_DCR, 0xB0);//filled square, start
+		busy = true;
+	}
+	if (busy) waitPoll(RA8875_DCR, RA8875_DCR_LINESQUTRI_STATUS);
+}
+
 /**************************************************************************/
 /*!
 		helper function for rects
 */
 /**************************************************************************/
-void RA8875::rectHelper(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, bool filled){
-	checkLimitsHelper(x,y);
-	if (w < 1) w = 1;
-	if (h < 1) h = 1;
+template<class Panel>
+void RA8875T<Panel>::rectHelper(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, bool filled){
+	// w,h are the opposite corner
+	if (w < x) swap(x,w);
+	if (h < y) swap(y,h);
+	if (clipOut(x,y,w,h)) return;
+	if (!filled && !clipInside(x,y,w,h)) {//only the visible sides
+		drawLine(x,y,w,y,color);
+		drawLine(x,h,w,h,color);
+		drawLine(x,y,x,h,color);
+		drawLine(w,y,w,h,color);
+		return;
+	}
+	x = max(x,_clipXL); y = max(y,_clipYT);
+	w = min(w,_clipXR); h = min(h,_clipYB);
+	changeMode(GRAPHIC);
 
 	lineAddressing(x,y,w,h);
 
@@ -1613,23 +2474,201 @@ void RA8875::rectHelper(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t col
 		common helper for check value limiter
 */
 /**************************************************************************/
-void RA8875::checkLimitsHelper(int16_t &x,int16_t &y){
+template<class Panel>
+void RA8875T<Panel>::checkLimitsHelper(int16_t &x,int16_t &y){
 	if (x < 0) x = 0;
 	if (y < 0) y = 0;
-	if (x >= _width) x = _width - 1;
-	if (y >= _height) y = _height -1;
+	if (x >= W()) x = W() - 1;
+	if (y >= H()) y = H() -1;
 	x = x;
 	y = y;
 }
+/**************************************************************************/
+/*!
+		clip helpers, true if the box is completely outside the clip rect
+*/
+/**************************************************************************/
+template<class Panel>
+bool RA8875T<Panel>::clipOut(int16_t xl, int16_t yt, int16_t xr, int16_t yb) const {
+	return xr < _clipXL || xl > _clipXR || yb < _clipYT || yt > _clipYB;
+}
+
+template<class Panel>
+bool RA8875T<Panel>::clipInside(int16_t xl, int16_t yt, int16_t xr, int16_t yb) const {
+	return xl >= _clipXL && xr <= _clipXR && yt >= _clipYT && yb <= _clipYB;
+}
+
+// Cohen-Sutherland outcode: 1 left, 2 right, 4 above, 8 below
+template<class Panel>
+uint8_t RA8875T<Panel>::clipCode(int16_t x, int16_t y) const {
+	uint8_t code = 0;
+	if (x < _clipXL) code |= 1;
+	else if (x > _clipXR) code |= 2;
+	if (y < _clipYT) code |= 4;
+	else if (y > _clipYB) code |= 8;
+	return code;
+}
+
+// n / d rounded to the nearest
+static int32_t divRound(int64_t n, int64_t d){
+	if (d < 0) { n = -n; d = -d; }
+	return n >= 0 ? (n + d / 2) / d : -((d / 2 - n) / d);
+}
+
+/**************************************************************************/
+/*!
+		Cohen-Sutherland line clipping against the clip rect
+		Returns false if the line is not visible, otherwise the end
+		points are moved inside. The crossings are taken on the original
+		line and rounded, so clipping both ends doesn't bend it
+*/
+/**************************************************************************/
+template<class Panel>
+bool RA8875T<Panel>::clipLine(int16_t &x0, int16_t &y0, int16_t &x1, int16_t &y1){
+	const int32_t ox = x0, oy = y0, dx = x1 - x0, dy = y1 - y0;
+	uint8_t c0 = clipCode(x0,y0), c1 = clipCode(x1,y1);
+	for (uint8_t i = 0; c0 | c1; i++) {
+		if (c0 & c1) return false;//both on the same outer side
+		if (i == 4) {//a crossing rounded just outside a corner, pull it in
+			x0 = max(_clipXL,min(x0,_clipXR)); y0 = max(_clipYT,min(y0,_clipYB));
+			x1 = max(_clipXL,min(x1,_clipXR)); y1 = max(_clipYT,min(y1,_clipYB));
+			break;
+		}
+		uint8_t c = c0 ? c0 : c1;
+		int32_t x, y;
+		if (c & 8) {
+			y = _clipYB; x = ox + divRound((int64_t)dx * (y - oy), dy);
+		} else if (c & 4) {
+			y = _clipYT; x = ox + divRound((int64_t)dx * (y - oy), dy);
+		} else if (c & 2) {
+			x = _clipXR; y = oy + divRound((int64_t)dy * (x - ox), dx);
+		} else {
+			x = _clipXL; y = oy + divRound((int64_t)dy * (x - ox), dx);
+		}
+		if (c == c0) {
+			x0 = x; y0 = y; c0 = clipCode(x0,y0);
+		} else {
+			x1 = x; y1 = y; c1 = clipCode(x1,y1);
+		}
+	}
+	return true;
+}
+
+// a coordinate past the int16_t range held at its edge, off every screen
+static int16_t to16(int32_t v){
+	return v < INT16_MIN ? INT16_MIN : (v > INT16_MAX ? INT16_MAX : v);
+}
+
+/**************************************************************************/
+/*!
+		Software ellipse for centers the drawing engine can't take
+		(negative or too far), drawn as clipped lines or pixels
+		Parameters:
+		quadrants: 1 lower left, 2 upper left, 4 upper right, 8 lower right
+		(the drawCurve parts as bits)
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::softEllipse(int16_t xc, int16_t yc, int16_t a, int16_t b, uint8_t quadrants, bool filled, uint16_t color){
+	if (a < 1) a = 1;
+	if (b < 1) b = 1;
+	// 64 bit: 2*a2*b passes 32 bits from radii of about 1030
+	int64_t a2 = (int64_t)a * a, b2 = (int64_t)b * b;
+	int32_t x = 0, y = b;
+	int64_t px = 0, py = 2 * a2 * y;
+	int64_t p = b2 - a2 * b + a2 / 4;
+	bool region1 = true;
+	while (y >= 0) {
+		// region 1 visits a row several times, fill it on the last one
+		bool last = !region1 || p >= 0 || px + 2 * b2 >= py;
+		if (filled && last) {
+			int16_t l = (quadrants & 0x02) ? to16(xc - x) : xc, r = (quadrants & 0x04) ? to16(xc + x) : xc;
+			if (quadrants & 0x06) drawLine(l,to16(yc - y),r,to16(yc - y),color);
+			l = (quadrants & 0x01) ? to16(xc - x) : xc; r = (quadrants & 0x08) ? to16(xc + x) : xc;
+			if (y > 0 && (quadrants & 0x09)) drawLine(l,to16(yc + y),r,to16(yc + y),color);
+		} else if (!filled) {
+			if (quadrants & 0x02) drawPixel(to16(xc - x),to16(yc - y),color);
+			if (quadrants & 0x04) drawPixel(to16(xc + x),to16(yc - y),color);
+			if (quadrants & 0x01) drawPixel(to16(xc - x),to16(yc + y),color);
+			if (quadrants & 0x08) drawPixel(to16(xc + x),to16(yc + y),color);
+		}
+		if (region1) {
+			x++;
+			px += 2 * b2;
+			if (p < 0) {
+				p += b2 + px;
+			} else {
+				y--;
+				py -= 2 * a2;
+				p += b2 + px - py;
+			}
+			if (px >= py) {
+				region1 = false;
+				p = b2 * (2 * x + 1) * (2 * x + 1) / 4 + a2 * (y - 1) * (y - 1) - a2 * b2;
+			}
+		} else {
+			y--;
+			py -= 2 * a2;
+			if (p > 0) {
+				p += a2 - py;
+			} else {
+				x++;
+				px += 2 * b2;
+				p += a2 - py + px;
+			}
+		}
+	}
+}
+
+// x of the edge a-b at row y (ya < yb), rounded; 64 bit, both differences
+// can take 16 bits
+static int16_t edgeX(int16_t xa, int16_t ya, int16_t xb, int16_t yb, int16_t y){
+	int64_t n = (int64_t)(xb - xa) * (y - ya), d = yb - ya;
+	return xa + (n >= 0 ? (n + d / 2) / d : -((d / 2 - n) / d));
+}
+
+/**************************************************************************/
+/*!
+		Software filled triangle for corners the drawing engine can't
+		take, one clipped line per row
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::softTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color){
+	// sort by y
+	if (y0 > y1) { swap(y0,y1); swap(x0,x1); }
+	if (y1 > y2) { swap(y2,y1); swap(x2,x1); }
+	if (y0 > y1) { swap(y0,y1); swap(x0,x1); }
+	int16_t ya = max(y0,_clipYT), yb = min(y2,_clipYB);
+	for (int16_t y=ya;y<=yb;y++){
+		// long edge 0-2 against 0-1 or 1-2
+		int16_t xa = y2 == y0 ? x0 : edgeX(x0,y0,x2,y2,y);
+		int16_t xb;
+		if (y < y1) xb = edgeX(x0,y0,x1,y1,y);
+		else xb = y2 == y1 ? x1 : edgeX(x1,y1,x2,y2,y);
+		drawLine(xa,y,xb,y,color);
+	}
+}
+
 /**************************************************************************/
 /*!
       helper function for triangles
 */
 /**************************************************************************/
-void RA8875::triangleHelper(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color, bool filled){
-	checkLimitsHelper(x0,y0);
-	checkLimitsHelper(x1,y1);
-	checkLimitsHelper(x2,y2);
+template<class Panel>
+void RA8875T<Panel>::triangleHelper(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color, bool filled){
+	if (clipOut(min(x0,min(x1,x2)),min(y0,min(y1,y2)),max(x0,max(x1,x2)),max(y0,max(y1,y2)))) return;
+	if (!engineFits(x0,y0) || !engineFits(x1,y1) || !engineFits(x2,y2)) {
+		if (filled) {
+			softTriangle(x0,y0,x1,y1,x2,y2,color);
+		} else {
+			drawLine(x0,y0,x1,y1,color);
+			drawLine(x1,y1,x2,y2,color);
+			drawLine(x2,y2,x0,y0,color);
+		}
+		return;
+	}
+	changeMode(GRAPHIC);
 
 	lineAddressing(x0,y0,x1,y1);
 	//p2
@@ -1655,8 +2694,14 @@ void RA8875::triangleHelper(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int1
       helper function for ellipse
 */
 /**************************************************************************/
-void RA8875::ellipseHelper(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint16_t color, bool filled){
-	//TODO:limits!
+template<class Panel>
+void RA8875T<Panel>::ellipseHelper(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint16_t color, bool filled){
+	if (clipOut(xCenter - longAxis,yCenter - shortAxis,xCenter + longAxis,yCenter + shortAxis)) return;
+	if (!engineFits(xCenter,yCenter)) {
+		softEllipse(xCenter,yCenter,longAxis,shortAxis,0x0F,filled,color);
+		return;
+	}
+	changeMode(GRAPHIC);
 	curveAddressing(xCenter,yCenter,longAxis,shortAxis);
 
 	setForegroundColor(color);
@@ -1671,8 +2716,14 @@ void RA8875::ellipseHelper(int16_t xCenter, int16_t yCenter, int16_t longAxis, i
       helper function for curve
 */
 /**************************************************************************/
-void RA8875::curveHelper(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint8_t curvePart, uint16_t color, bool filled){
-	//TODO:limits!
+template<class Panel>
+void RA8875T<Panel>::curveHelper(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint8_t curvePart, uint16_t color, bool filled){
+	if (clipOut(xCenter - longAxis,yCenter - shortAxis,xCenter + longAxis,yCenter + shortAxis)) return;
+	if (!engineFits(xCenter,yCenter)) {
+		softEllipse(xCenter,yCenter,longAxis,shortAxis,1 << (curvePart & 0x03),filled,color);
+		return;
+	}
+	changeMode(GRAPHIC);
 	curveAddressing(xCenter,yCenter,longAxis,shortAxis);
 
 	setForegroundColor(color);
@@ -1687,11 +2738,33 @@ void RA8875::curveHelper(int16_t xCenter, int16_t yCenter, int16_t longAxis, int
 	  helper function for rounded Rects
 */
 /**************************************************************************/
-void RA8875::roundRectHelper(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color, bool filled){
-	if (r < 1) rectHelper(x,y,w,h,color,filled);//??? reason?
-
-	checkLimitsHelper(x,y);
-	checkLimitsHelper(w,h);
+template<class Panel>
+void RA8875T<Panel>::roundRectHelper(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color, bool filled){
+	if (r < 1) {
+		rectHelper(x,y,w,h,color,filled);
+		return;
+	}
+	if (w < x) swap(x,w);
+	if (h < y) swap(y,h);
+	if (clipOut(x,y,w,h)) return;
+	if (!engineFits(x,y) || !engineFits(w,h)) {
+		// straight parts, then the corners (curveHelper quadrants)
+		if (filled) {
+			rectHelper(x + r,y,w - r,h,color,true);
+			rectHelper(x,y + r,w,h - r,color,true);
+		} else {
+			drawLine(x + r,y,w - r,y,color);
+			drawLine(x + r,h,w - r,h,color);
+			drawLine(x,y + r,x,h - r,color);
+			drawLine(w,y + r,w,h - r,color);
+		}
+		softEllipse(x + r,h - r,r,r,0x01,filled,color);
+		softEllipse(x + r,y + r,r,r,0x02,filled,color);
+		softEllipse(w - r,y + r,r,r,0x04,filled,color);
+		softEllipse(w - r,h - r,r,r,0x08,filled,color);
+		return;
+	}
+	changeMode(GRAPHIC);
 
 	lineAddressing(x,y,w,h);
 #if USESETMULTIPLEREGISTERS
@@ -1716,7 +2789,8 @@ void RA8875::roundRectHelper(int16_t x, int16_t y, int16_t w, int16_t h, int16_t
 		Graphic line addressing helper
 */
 /**************************************************************************/
-void RA8875::lineAddressing(int16_t x0, int16_t y0, int16_t x1, int16_t y1){
+template<class Panel>
+void RA8875T<Panel>::lineAddressing(int16_t x0, int16_t y0, int16_t x1, int16_t y1){
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_DLHSR0,RA8875_DLHSR1,RA8875_DLVSR0,RA8875_DLVSR1,RA8875_DLHER0,RA8875_DLHER1,RA8875_DLVER0,RA8875_DLVER1};
 	uint8_t data[] = {(uint8_t)x0,(uint8_t)(x0 >> 8),(uint8_t)y0,(uint8_t)(y0 >> 8),(uint8_t)x1,(uint8_t)(x1 >> 8),(uint8_t)y1,(uint8_t)(y1 >> 8)};
@@ -1742,7 +2816,8 @@ void RA8875::lineAddressing(int16_t x0, int16_t y0, int16_t x1, int16_t y1){
 		curve addressing
 */
 /**************************************************************************/
-void RA8875::curveAddressing(int16_t x0, int16_t y0, int16_t x1, int16_t y1){
+template<class Panel>
+void RA8875T<Panel>::curveAddressing(int16_t x0, int16_t y0, int16_t x1, int16_t y1){
 #if USESETMULTIPLEREGISTERS
 	uint8_t reg[] = {RA8875_DEHR0,RA8875_DEHR1,RA8875_DEVR0,RA8875_DEVR1,RA8875_ELL_A0,RA8875_ELL_A1,RA8875_ELL_B0,RA8875_ELL_B1};
 	uint8_t data[] = {(uint8_t)x0,(uint8_t)(x0 >> 8),(uint8_t)y0,(uint8_t)(y0 >> 8),(uint8_t)x1,(uint8_t)(x1 >> 8),(uint8_t)y1,(uint8_t)(y1 >> 8)};
@@ -1768,7 +2843,8 @@ void RA8875::curveAddressing(int16_t x0, int16_t y0, int16_t x1, int16_t y1){
 		on/off GPIO (basic for Adafruit module
 */
 /**************************************************************************/
-void RA8875::GPIOX(bool on) {
+template<class Panel>
+void RA8875T<Panel>::GPIOX(bool on) {
     writeReg(RA8875_GPIOX, on);
 }
 
@@ -1780,7 +2856,8 @@ void RA8875::GPIOX(bool on) {
 		p:0...255 rate
 */
 /**************************************************************************/
-void RA8875::PWMout(uint8_t pw,uint8_t p) {
+template<class Panel>
+void RA8875T<Panel>::PWMout(uint8_t pw,uint8_t p) {
 	uint8_t reg;
 	if (pw > 1){
 		reg = RA8875_P2DCR;
@@ -1798,7 +2875,8 @@ void RA8875::PWMout(uint8_t pw,uint8_t p) {
 		val:0...255
 */
 /**************************************************************************/
-void RA8875::brightness(uint8_t val) {
+template<class Panel>
+void RA8875T<Panel>::brightness(uint8_t val) {
 	PWMout(1,val);
 }
 
@@ -1811,7 +2889,8 @@ void RA8875::brightness(uint8_t val) {
 		clock: the clock setting
 */
 /**************************************************************************/
-void RA8875::PWMsetup(uint8_t pw,bool on, uint8_t clock) {
+template<class Panel>
+void RA8875T<Panel>::PWMsetup(uint8_t pw,bool on, uint8_t clock) {
 	uint8_t reg;
 	uint8_t set;
 	if (pw > 1){
@@ -1842,9 +2921,10 @@ void RA8875::PWMsetup(uint8_t pw,bool on, uint8_t clock) {
 
 */
 /**************************************************************************/
-bool RA8875::useLayers(bool on) {
+template<class Panel>
+bool RA8875T<Panel>::useLayers(bool on) {
 	bool clearBuffer = false;
-	if (_maxLayers > 1){
+	if (layers() > 1){
 		if (on){
 			_useMultiLayers = true;
 			_DPCRReg |= (1 << 7);
@@ -1874,7 +2954,8 @@ bool RA8875::useLayers(bool on) {
 
 */
 /**************************************************************************/
-void RA8875::layerEffect(enum RA8875boolean efx){
+template<class Panel>
+void RA8875T<Panel>::layerEffect(enum RA8875boolean efx){
 	uint8_t	reg = 0b00000000;
 	//reg &= ~(0x07);//clear bit 2,1,0
 	switch(efx){//                       bit 2,1,0 of LTPR0
@@ -1912,7 +2993,8 @@ void RA8875::layerEffect(enum RA8875boolean efx){
 
 */
 /**************************************************************************/
-void RA8875::layerTransparency(uint8_t layer1,uint8_t layer2){
+template<class Panel>
+void RA8875T<Panel>::layerTransparency(uint8_t layer1,uint8_t layer2){
 	if (layer1 > 8) layer1 = 8;
 	if (layer2 > 8) layer2 = 8;
 
@@ -1974,6 +3056,68 @@ void RA8875::layerTransparency(uint8_t layer1,uint8_t layer2){
 	if (_useMultiLayers) writeReg(RA8875_LTPR1,res);
 }
 
+/**************************************************************************/
+/*!
+		Double buffering with the two layers, drawing goes to the hidden
+		layer and flip() shows it. Panels that only have one layer at 16bpp
+		(800x480) are switched to 8bpp, colors are then reduced to 3:3:2
+		Both layers start cleared
+		Return false if not possible
+		Parameters:
+		on: enable/disable
+*/
+/**************************************************************************/
+template<class Panel>
+bool RA8875T<Panel>::doubleBuffer(bool on) {
+	if (on == _doubleBuffer) return true;
+	if (on) {
+		if (layers() < 2) {
+			_color8 = true;
+			writeReg(RA8875_SYSR,0x00);//8bpp, two layers fit
+		}
+		if (!useLayers(true)) return false;
+		writeTo(L1);
+		clearMemory(false);
+		_doubleBuffer = true;
+		_frontLayer = 0;
+		_flipTick = HAL_GetTick();
+		layerEffect(LAYER1);
+		writeTo(L2);//back buffer
+	} else {
+		_doubleBuffer = false;
+		layerEffect(LAYER1);
+		writeTo(L1);
+		useLayers(false);
+		if (_color8) {
+			_color8 = false;
+			writeReg(RA8875_SYSR,0x0C);//back to 65K
+		}
+	}
+	return true;
+}
+
+/**************************************************************************/
+/*!
+		Show the back buffer with a single LTPR0 write, further drawing goes
+		to the layer that was shown
+		Parameters:
+		copyFront: start the new back buffer as a copy of the shown frame (BTE)
+*/
+/**************************************************************************/
+template<class Panel>
+void RA8875T<Panel>::flip(bool copyFront) {
+	if (!_doubleBuffer) return;
+	bteWait();//the frame must be complete
+	uint8_t back = _frontLayer ^ 1;
+	writeReg(RA8875_LTPR0, back);//000: layer 1, 001: layer 2 visible
+	uint32_t now = HAL_GetTick();
+	_frameMs = now - _flipTick;
+	_flipTick = now;
+	writeTo(_frontLayer == 0 ? L1 : L2);
+	if (copyFront) copyRect(back,0,0,_frontLayer,0,0,W(),H());//runs while the caller goes on
+	_frontLayer = back;
+}
+
 /**************************************************************************/
 /*!
       Change the beam scan direction on display
@@ -1982,7 +3126,8 @@ void RA8875::layerTransparency(uint8_t layer1,uint8_t layer2){
 	  invertV:true(inverted),false(normal) vertical
 */
 /**************************************************************************/
-void RA8875::scanDirection(bool invertH,bool invertV){
+template<class Panel>
+void RA8875T<Panel>::scanDirection(bool invertH,bool invertV){
 	invertH == true ? _DPCRReg |= (1 << 3) : _DPCRReg &= ~(1 << 3);
 	invertV == true ? _DPCRReg |= (1 << 2) : _DPCRReg &= ~(1 << 2);
 	writeReg(RA8875_DPCR,_DPCRReg);
@@ -1993,7 +3138,8 @@ void RA8875::scanDirection(bool invertH,bool invertV){
       turn display on/off
 */
 /**************************************************************************/
-void RA8875::displayOn(bool on) {
+template<class Panel>
+void RA8875T<Panel>::displayOn(bool on) {
 	on == true ? writeReg(RA8875_PWRR, RA8875_PWRR_NORMAL | RA8875_PWRR_DISPON) : writeReg(RA8875_PWRR, RA8875_PWRR_NORMAL | RA8875_PWRR_DISPOFF);
 }
 
@@ -2003,7 +3149,8 @@ void RA8875::displayOn(bool on) {
     Sleep mode on/off (caution! in SPI this need some more code!)
 */
 /**************************************************************************/
-void RA8875::sleep(bool sleep) {
+template<class Panel>
+void RA8875T<Panel>::sleep(bool sleep) {
 	sleep == true ? writeReg(RA8875_PWRR, RA8875_PWRR_DISPOFF | RA8875_PWRR_SLEEP) : writeReg(RA8875_PWRR, RA8875_PWRR_DISPOFF);
 }
 
@@ -2017,22 +3164,32 @@ void RA8875::sleep(bool sleep) {
 		val: the data
 */
 /**************************************************************************/
-void  RA8875::writeReg(uint8_t reg, uint8_t val) {
+template<class Panel>
+void  RA8875T<Panel>::writeReg(uint8_t reg, uint8_t val) {
 	uint8_t buf[4];
 	buf[0]= RA8875_CMDWRITE;
 	buf[1]= reg;
 	buf[2]= RA8875_DATAWRITE;
 	buf[3]= val;
 
+#if RA8875_FAST_SPI
+	_fast.select();
+	_fast.write(buf, 4);
+	_fast.deselect();
+#else
 	startSend();
 	HAL_StatusTypeDef s= HAL_SPI_Transmit(hspi, buf, 4, 100);
 	if(s != HAL_OK) {
 		printf("SPI transfer failed: %d\r\n", s);
 	}
 	endSend();
+#endif
 }
 
-void RA8875::setMultipleRegisters(uint8_t reg[], uint8_t data[], uint8_t len) {
+// one CS frame per register, as writeReg; the bus cost is the same, only
+// the calls are fewer
+template<class Panel>
+void RA8875T<Panel>::setMultipleRegisters(const uint8_t reg[], const uint8_t data[], uint8_t len) {
 	uint8_t buf[4];
 	for (uint8_t i=0;i<len;i++){
 		buf[0]= RA8875_CMDWRITE;
@@ -2050,19 +3207,26 @@ void RA8875::setMultipleRegisters(uint8_t reg[], uint8_t data[], uint8_t len) {
 		reg: the register
 */
 /**************************************************************************/
-uint8_t  RA8875::readReg(uint8_t reg) {
+template<class Panel>
+uint8_t  RA8875T<Panel>::readReg(uint8_t reg) {
 	uint8_t buf[4], rbuf[4];
 	buf[0]= RA8875_CMDWRITE;
 	buf[1]= reg;
 	buf[2]= RA8875_DATAREAD;
 	buf[3]= 0;
 
+#if RA8875_FAST_SPI
+	_fast.select();
+	_fast.transfer(buf, rbuf, 4);
+	_fast.deselect();
+#else
 	startSend();
 	HAL_StatusTypeDef s= HAL_SPI_TransmitReceive(hspi, buf, rbuf, 4, 100);
 	if(s != HAL_OK) {
 		printf("SPI transfer failed: %d\r\n", s);
 	}
 	endSend();
+#endif
 	return rbuf[3];
 }
 
@@ -2073,18 +3237,45 @@ uint8_t  RA8875::readReg(uint8_t reg) {
 		d: the data
 */
 /**************************************************************************/
-void  RA8875::writeData(uint8_t data) {
+template<class Panel>
+void  RA8875T<Panel>::writeData(uint8_t data) {
 	uint8_t buf[]= {RA8875_DATAWRITE, data};
 	writeBlock(buf, sizeof(buf));
 }
 
-void  RA8875::writeBlock(uint8_t *data, int len) {
+template<class Panel>
+void  RA8875T<Panel>::writeBlock(const uint8_t *data, int len) {
+	TRACE(TRACE_SPI_START, 0, len);
+	startSend();
+	spiSend(data, len);
+	endSend();
+	TRACE(TRACE_SPI_DONE, 0, len);
+}
+
+// gather write, both parts are sent in one transaction
+template<class Panel>
+void  RA8875T<Panel>::writeBlock(const uint8_t *head, int hlen, const uint8_t *data, int len) {
+	TRACE(TRACE_SPI_START, 0, hlen+len);
 	startSend();
-	HAL_StatusTypeDef s= HAL_SPI_Transmit(hspi, data, len, 100);
+	spiSend(head, hlen);
+	spiSend(data, len);
+	endSend();
+	TRACE(TRACE_SPI_DONE, 0, hlen+len);
+}
+
+// CS must already be low
+template<class Panel>
+void  RA8875T<Panel>::spiSend(const uint8_t *data, int len) {
+#if RA8875_FAST_SPI
+	if(len <= RA8875_FAST_SPI_MAX) {
+		_fast.write(data, len);
+		return;
+	}
+#endif
+	HAL_StatusTypeDef s= HAL_SPI_Transmit(hspi, (uint8_t *)data, len, 100);
 	if(s != HAL_OK) {
 		printf("SPI transfer failed: %d\r\n", s);
 	}
-	endSend();
 }
 /**************************************************************************/
 /*!
@@ -2093,7 +3284,8 @@ void  RA8875::writeBlock(uint8_t *data, int len) {
 		d: the data (16 bit)
 */
 /**************************************************************************/
-void  RA8875::writeData16(uint16_t data) {
+template<class Panel>
+void  RA8875T<Panel>::writeData16(uint16_t data) {
 #if defined _SPI_HYPERDRIVE && (defined(__MK20DX128__) || defined(__MK20DX256__))
 	SPI.beginTransaction(settings);
 	writecommand_cont(RA8875_DATAWRITE);
@@ -2114,7 +3306,8 @@ void  RA8875::writeData16(uint16_t data) {
 
 */
 /**************************************************************************/
-uint8_t  RA8875::readData(bool stat)
+template<class Panel>
+uint8_t  RA8875T<Panel>::readData(bool stat)
 {
 	//SPI.setClockDivider(SPI_CLOCK_DIV8);//2Mhz (3.3Mhz max)
 	uint8_t buf[2], rbuf[2];
@@ -2122,10 +3315,14 @@ uint8_t  RA8875::readData(bool stat)
 	buf[1]= 0;
 	startSend();
 
+#if RA8875_FAST_SPI
+	_fast.transfer(buf, rbuf, 2);
+#else
 	HAL_StatusTypeDef s= HAL_SPI_TransmitReceive(hspi, buf, rbuf, 2, 100);
 	if(s != HAL_OK) {
 		printf("SPI transfer failed: %d\r\n", s);
 	}
+#endif
 	endSend();
 	return rbuf[1];
 }
@@ -2135,7 +3332,8 @@ uint8_t  RA8875::readData(bool stat)
 
 */
 /**************************************************************************/
-uint8_t  RA8875::readStatus(void) {
+template<class Panel>
+uint8_t  RA8875T<Panel>::readStatus(void) {
 	return readData(true);
 }
 
@@ -2146,12 +3344,14 @@ uint8_t  RA8875::readStatus(void) {
 		d: the command
 */
 /**************************************************************************/
-void RA8875::writeCommand(uint8_t d) {
+template<class Panel>
+void RA8875T<Panel>::writeCommand(uint8_t d) {
 	uint8_t buf[]= {RA8875_CMDWRITE, d};
 	writeBlock(buf, sizeof(buf));
 }
 
-void RA8875::writeCommandData(uint8_t c, uint8_t d) {
+template<class Panel>
+void RA8875T<Panel>::writeCommandData(uint8_t c, uint8_t d) {
 	uint8_t buf[]= {RA8875_CMDWRITE, c, RA8875_DATAWRITE, d};
 	writeBlock(buf, sizeof(buf));
 }
@@ -2161,9 +3361,14 @@ void RA8875::writeCommandData(uint8_t c, uint8_t d) {
 		starts SPI communication
 */
 /**************************************************************************/
-void RA8875::startSend(){
+template<class Panel>
+void RA8875T<Panel>::startSend(){
 	// set cs low
+#if RA8875_FAST_SPI
+	_fast.select();
+#else
 	HAL_GPIO_WritePin(cs_port, cs_pin, GPIO_PIN_RESET);
+#endif
 }
 
 /**************************************************************************/
@@ -2171,73 +3376,53 @@ void RA8875::startSend(){
 		ends SPI communication
 */
 /**************************************************************************/
-void RA8875::endSend(){
+template<class Panel>
+void RA8875T<Panel>::endSend(){
 	// set cs high
+#if RA8875_FAST_SPI
+	_fast.deselect();
+#else
 	HAL_GPIO_WritePin(cs_port, cs_pin, GPIO_PIN_SET);
+#endif
 }
 
 // do actual SPI
-uint8_t RA8875::SPItranfer(uint8_t d)
+template<class Panel>
+uint8_t RA8875T<Panel>::SPItranfer(uint8_t d)
 {
 	uint8_t r= 0;
+#if RA8875_FAST_SPI
+	_fast.transfer(&d, &r, 1);
+#else
 	HAL_StatusTypeDef s= HAL_SPI_TransmitReceive(hspi, &d, &r, 1, 100);
 	if(s != HAL_OK) {
 		printf("SPI transfer failed: %d\r\n", s);
 	}
+#endif
 	return r;
 }
 
 #include "stdarg.h"
-int RA8875::printf(const char* format, ...)
+template<class Panel>
+int RA8875T<Panel>::printf(const char* format, ...)
 {
     va_list args;
     va_start(args, format);
     char buffer[132]; // max length for display anyway
     int n= vsnprintf(buffer, sizeof(buffer), format, args);
     va_end(args);
+    if(n >= (int)sizeof(buffer)) n= sizeof(buffer)-1; // truncated
 
-    // handle any \n in the stream
-    // TODO handle multiple \n anywhere in stream, and also \r
-    /*		if (buffer[i] == '\r') {
-			if(i == len-1 || buffer[i+1] != '\n') {
-				// standalone CR
-				uint16_t x, y;
-				getCursor(&x, &y);
-				setCursor(0,y);
-				if(i != len-1) writeCommand(RA8875_MRWC);
-			}else{
-				// ignore if followed by \n
-				continue;
-			}
-		} else if (buffer[i] == '\n') {  // always do \r\n, but should be an option
-			//get current y
-			t1 = readReg(RA8875_F_CURYL);
-			t2 = readReg(RA8875_F_CURYH);
-			//calc new line y
-			ny = (t2 << 8) | (t1 & 0xFF);
-			//update y
-			ny = ny + (16 + (16*_textScale))+_fontInterline;//TODO??
-			setCursor(0,ny);
-			if(i != len-1) writeCommand(RA8875_MRWC);
-    */
-    // this only handles a \n at the end of the stream,
-    char *p= strchr(buffer, '\n');
-    if(p == nullptr) {
-    	this->textWrite(buffer, n);
-    }else{
-    	int l= p-buffer;
-    	if(l > 0){
-    		this->textWrite(buffer, l);
-    	}
-		//get current y
-		uint8_t t1 = readReg(RA8875_F_CURYL);
-		uint8_t t2 = readReg(RA8875_F_CURYH);
-		//calc new line y
-		uint16_t ny = (t2 << 8) | (t1 & 0xFF);
-		//update y
-		ny = ny + (16 + (16*_textScale))+_fontInterline;//TODO??
-		setCursor(0,ny);
-    }
+    this->textWrite(buffer, n);
 
     return n;
 }
+
+// only the member functions actually called end up in the image (--gc-sections)
+template class RA8875T<PanelRuntime>;
+template class RA8875T<Panel320x240>;
+template class RA8875T<Panel480x272>;
+template class RA8875T<Panel640x480>;
+template class RA8875T<Panel800x480>;
+template class RA8875T<PanelAdafruit480x272>;
+template class RA8875T<PanelAdafruit800x480>;
@@ -43,6 +43,17 @@ RA8875 has 4 different font set, same shape but suitable for most languages
 please look at RA8875 datasheet and choose the correct one for your language!
 The default one it's the most common one and should work in most situations */
 #define DEFAULTINTENCODING			ISO_IEC_8859_1//ISO_IEC_8859_2,ISO_IEC_8859_3,ISO_IEC_8859_4
+/* TAB STOPS ++++++++++++++++++++++++++++++++++++++++++++
+\t moves the text cursor to the next multiple of this many characters */
+#define RA8875_TABSIZE				8
+/* SPI FAST PATH ++++++++++++++++++++++++++++++++++++++++++++
+Short transactions skip the HAL and drive the SPI and CS pin passed to the constructor
+directly (see SpiTransport.h), blocks longer than RA8875_FAST_SPI_MAX still go through
+HAL_SPI_Transmit */
+#ifndef RA8875_FAST_SPI
+#define RA8875_FAST_SPI				1
+#endif
+#define RA8875_FAST_SPI_MAX			16
 
 
 /* ----------------------------DO NOT TOUCH ANITHING FROM HERE ------------------------*/
@@ -54,6 +65,11 @@ The default one it's the most common one and should work in most situations */
 
 #include "stm32l1xx_hal.h"
 
+#if RA8875_FAST_SPI
+#include "SpiTransport.h"
+typedef SpiTransport<> RA8875FastSPI;
+#endif
+
 // Colors (RGB565)
 #define	RA8875_BLACK            0x0000
 #define	RA8875_BLUE             0x001F
@@ -76,14 +92,29 @@ enum RA8875extRomCoding { GB2312, GB12345, BIG5, UNICODE, ASCII, UNIJIS, JIS0208
 enum RA8875extRomFamily { STANDARD, ARIAL, ROMAN, BOLD };
 enum RA8875boolean { LAYER1, LAYER2, TRANSPARENT, LIGHTEN, OR, AND, FLOATING };//for LTPR0
 enum RA8875writes { L1, L2, CGRAM, PATTERN, CURSOR };//TESTING
+enum RA8875rop { ROP_BLACK, ROP_NOR, ROP_NOT_S_AND_D, ROP_NOT_S, ROP_S_AND_NOT_D, ROP_NOT_D, ROP_XOR, ROP_NAND,
+				 ROP_AND, ROP_XNOR, ROP_D, ROP_NOT_S_OR_D, ROP_S, ROP_S_OR_NOT_D, ROP_OR, ROP_WHITE };//BTE raster operations, S:source D:destination
+
+// items for the batched fills
+struct RA8875circle { int16_t x, y, r; uint16_t color; };
+struct RA8875rect { int16_t x, y, w, h; uint16_t color; };
 
+#include "RA8875Panels.h"
 
-class RA8875 {
+struct RA8875initStep;
+
+/*
+	The panel is a template parameter (see RA8875Panels.h), e.g. RA8875T<Panel800x480>,
+	so sizes, layers and the init table are compile time constants.
+	RA8875 below is the original run time configured class.
+*/
+template<class Panel>
+class RA8875T {
  public:
 //------------- Instance -------------------------
-	RA8875(SPI_HandleTypeDef*, GPIO_TypeDef*, uint16_t);
+	RA8875T(SPI_HandleTypeDef*, GPIO_TypeDef*, uint16_t);//the handle must be through HAL_SPI_Init
 //------------- Setup -------------------------
-	void 		begin(const enum RA8875sizes s);
+	void 		begin(void);
 //------------- Hardware related -------------------------
 	void    	softReset(void);
 	void    	displayOn(bool on);
@@ -95,6 +126,8 @@ class RA8875 {
 	void 		scanDirection(bool invertH,bool invertV);
 //--------------area & color -------------------------
 	void		setActiveWindow(uint16_t XL,uint16_t XR ,uint16_t YT ,uint16_t YB);
+	void		setClipRect(int16_t x, int16_t y, int16_t w, int16_t h);//drawing outside is dropped
+	void		clearClipRect(void);
 	uint16_t 	width(void);
 	uint16_t 	height(void);
 	void		setForegroundColor(uint16_t color);
@@ -110,12 +143,13 @@ class RA8875 {
 	void		showCursor(bool cur,enum RA8875tcursor c=BLINK);//show text cursor, select cursor typ (NORMAL,BLINK)
 	void 		setCursorBlinkRate(uint8_t rate);//0...255 0:faster
 	void    	setCursor(uint16_t x, uint16_t y);
-	void 		getCursor(uint16_t *x, uint16_t *y);//update the library _cursorX,_cursorY internally
-				//and get the current data, this is useful sometime because the chip track cursor internally only
+	void 		getCursor(uint16_t *x, uint16_t *y);//the library tracked cursor, no SPI reads
+	void 		syncCursor(void);//reread _cursorX,_cursorY from the chip, if something else moved it
 	void    	setTextColor(uint16_t fColor, uint16_t bColor);
 	void 		setTextColor(uint16_t fColor);//transparent background
 	void 		uploadUserChar(const uint8_t symbol[],uint8_t address);
 	void		showUserChar(uint8_t symbolAddrs,uint8_t wide=0);//0...255
+	void		showUserChars(const uint8_t addrs[],uint8_t len);//one burst at the text cursor
 	void    	setFontScale(uint8_t scale);//0..3
 	void    	setFontSize(enum RA8875tsize ts,bool halfSize=false);//X16,X24,X32
 	void 		setFontSpacing(uint8_t spc);//0:disabled ... 63:pix max
@@ -126,6 +160,7 @@ class RA8875 {
 	void		setExternalFontRom(enum RA8875extRomType ert, enum RA8875extRomCoding erc,enum RA8875extRomFamily erf=STANDARD);
 	void 		setFont(enum RA8875fontSource s);//INT,EXT (if you have a chip installed)
 	void 		setIntFontCoding(enum RA8875fontCoding f);
+	enum RA8875fontCoding getIntFontCoding(void);//from the register shadow, no SPI reads
 	void		setExtFontFamily(enum RA8875extRomFamily erf,bool setReg=true);
 //--------------Graphic Funcions -------------------------
 	void    	setXY(int16_t x, int16_t y);//graphic set location
@@ -133,10 +168,18 @@ class RA8875 {
 	void 		setY(uint16_t y) ;
 	void 		setGraphicCursor(uint8_t cur);//0...7 Select a custom graphic cursor (you should upload first)
 	void 		showGraphicCursor(bool cur);//show graphic cursor
+	void 		uploadGraphicCursor(uint8_t cur, const uint8_t image[256]);//0...7, 32x32 2 bits per pixel
+	static void encodeGraphicCursor(const char * const rows[], uint8_t n, uint8_t image[256]);//text to image
+	void 		setGraphicCursorColors(uint16_t color0, uint16_t color1);
+	void 		moveGraphicCursor(int16_t x, int16_t y);//only position registers, no redraw
 	//--------------- DRAW -------------------------
 	//void    	pushPixels(uint32_t num, uint16_t p);//push large number of pixels
 	//void    	fillRect(void);
 	void    	drawPixel(int16_t x, int16_t y, uint16_t color);
+	//pixel streams, one window and memory write for many pixels
+	bool    	beginPixels(int16_t &x, int16_t &y, int16_t &w, int16_t &h);//cut to the clip rect, false if not visible
+	void    	pushPixels(const uint16_t p[], uint16_t n);//RGB565, fill the window row by row
+	void    	endPixels(void);
 	void    	drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
 	void    	drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
 	void    	fillScreen(uint16_t color);
@@ -145,6 +188,11 @@ class RA8875 {
 	void    	fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
 	void    	drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
 	void    	fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+	//batches, grouped by color and only the registers that change are sent
+	void    	fillCircles(const RA8875circle c[], uint16_t n);
+	void    	fillCircles(const RA8875circle c[], uint16_t n, uint16_t color);//shared color
+	void    	fillRects(const RA8875rect r[], uint16_t n);
+	void    	fillRects(const RA8875rect r[], uint16_t n, uint16_t color);//shared color
 	void    	drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
 	void    	fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
 	void    	drawEllipse(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint16_t color);
@@ -159,16 +207,25 @@ class RA8875 {
 //-------------- DMA -------------------------------
 	void 		drawFlashImage(int16_t x,int16_t y,int16_t w,int16_t h,uint8_t picnum);
 //-------------- BTE --------------------------------------------
-	void 		BTE_size(uint16_t w, uint16_t h);
-	void	 	BTE_source(uint16_t SX,uint16_t DX ,uint16_t SY ,uint16_t DY);
-	void		BTE_ROP_code(unsigned char setx);//TESTING
-	void 		BTE_enable(void);//TESTING
+	//these start the engine and return, the next drawing waits for it
+	void 		copyRect(int16_t sx, int16_t sy, int16_t dx, int16_t dy, int16_t w, int16_t h, enum RA8875rop rop=ROP_S);
+	void 		copyRect(uint8_t srcLayer, int16_t sx, int16_t sy, uint8_t dstLayer, int16_t dx, int16_t dy, int16_t w, int16_t h, enum RA8875rop rop=ROP_S);
+	void 		stampRect(uint8_t srcLayer, int16_t sx, int16_t sy, uint8_t dstLayer, int16_t dx, int16_t dy, int16_t w, int16_t h);//skips the transparent color
+	void 		moveRect(int16_t sx, int16_t sy, int16_t dx, int16_t dy, int16_t w, int16_t h, uint16_t fill);
+	void 		solidFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+	void 		uploadPattern(uint8_t n, const uint16_t pixels[64]);//0...15, 8x8
+	void 		patternFill(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t n, enum RA8875rop rop=ROP_S);
+	void 		patternStamp(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t n);//skips the transparent color
+	void 		bteWait(void) { if (_btePending) { waitBusy(0x40); _btePending = false; } }
 
 //-------------- LAYERS -----------------------------------------
 	bool 	useLayers(bool on);
 	void		writeTo(enum RA8875writes d);//TESTING
 	void 		layerEffect(enum RA8875boolean efx);
 	void 		layerTransparency(uint8_t layer1,uint8_t layer2);
+	bool 		doubleBuffer(bool on);//draw to the hidden layer, 8bpp if needed for two layers
+	void 		flip(bool copyFront=false);//show what was drawn
+	uint32_t 	frameTime(void) { return _frameMs; }//ms between the last two flips
 //--------------GPIO & PWM -------------------------
 	void    	GPIOX(bool on);
 	void    	PWMout(uint8_t pw,uint8_t p);//1:backlight, 2:free
@@ -184,14 +241,19 @@ class RA8875 {
 //--------------Text Write -------------------------
 int printf(const char* format, ...);
 void print(const char* str) { textWrite(str, strlen(str)); };
+void print(const char* str, uint16_t len) { if (len > 0) textWrite(str, len); };
 void println(const char* str) { print(str); print("\r\n"); };
+//character cell of the current font in pixels
+uint16_t charWidth(void);
+uint16_t lineHeight(void);
 
- private:
+ protected:
 	//------------- VARS ----------------------------
 
 	//----------------------------------------
 	uint16_t 		 		_width, _height;
-	uint16_t				_cursorX, _cursorY; //try to internally track text cursor...
+	uint16_t				_cursorX, _cursorY; //text cursor tracked from the font metrics
+	bool					_cursorMoved; //chip cursor needs rewriting before the next text
 	uint8_t 		 		_textScale;
 	bool					_textWrap;
 	uint8_t					_fontSpacing;
@@ -211,15 +273,42 @@ void println(const char* str) { print(str); print("\r\n"); };
 	uint8_t					_maxLayers;
 	bool					_useMultiLayers;
 	uint8_t					_currentLayer;
+	bool					_color8; //8bpp, so two layers fit at 800x480
+	bool					_doubleBuffer;
+	uint8_t					_frontLayer;
+	uint32_t				_flipTick, _frameMs;
+	bool					_btePending; //BTE started and not waited for
+	uint8_t					_gcursorPos[4]; //GCHP0...GCVP1 as last written
+	bool					_gcursorPosValid;
+	//clip rect, inclusive ------------------
+	int16_t					_clipXL,_clipYT,_clipXR,_clipYB;
 	//scroll vars ----------------------------
 	int16_t					_scrollXL,_scrollXR,_scrollYT,_scrollYB;
 
+	// constant for compile time panels, PanelRuntime reads the vars set by begin()
+	uint16_t	W(void) const { if (Panel::width) return Panel::width; return _width; }
+	uint16_t	H(void) const { if (Panel::height) return Panel::height; return _height; }
+	uint8_t		layers(void) const { if (_color8) return 2; if (Panel::width) return Panel::maxLayers; return _maxLayers; }
+	void 		colorRegs(uint16_t color, uint8_t data[3]);
+
 	//		functions --------------------------
-	void 	initialize(uint8_t initIndex);
+	void 	initState(void);
+	void 	initialize(const uint8_t timing[15]);
+	void 	runSequence(const RA8875initStep *seq, const uint8_t timing[15]);
 	void    textWrite(const char* buffer, uint16_t len=0);//thanks to Paul Stoffregen for the initial version of this one
+	void    textSend(const char* buffer, uint16_t len);
+	void 	newLine(void);
 	void 	PWMsetup(uint8_t pw,bool on, uint8_t clock);
 	// 		helpers-----------------------------
 	void 	checkLimitsHelper(int16_t &x,int16_t &y);//RA8875 it's prone to freeze with values out of range
+	bool 	clipOut(int16_t xl, int16_t yt, int16_t xr, int16_t yb) const;
+	bool 	clipInside(int16_t xl, int16_t yt, int16_t xr, int16_t yb) const;
+	uint8_t clipCode(int16_t x, int16_t y) const;
+	bool 	clipLine(int16_t &x0, int16_t &y0, int16_t &x1, int16_t &y1);
+	// what the drawing engine position registers hold, the active window clips the rest
+	bool 	engineFits(int16_t x, int16_t y) const { return x >= 0 && x <= 1023 && y >= 0 && y <= 511; }
+	void 	softEllipse(int16_t xc, int16_t yc, int16_t a, int16_t b, uint8_t quadrants, bool filled, uint16_t color);
+	void 	softTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
 	void 	circleHelper(int16_t x0, int16_t y0, int16_t r, uint16_t color, bool filled);
 	void 	rectHelper  (int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, bool filled);
 	void 	triangleHelper(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color, bool filled);
@@ -227,8 +316,13 @@ void println(const char* str) { print(str); print("\r\n"); };
 	void 	curveHelper(int16_t xCenter, int16_t yCenter, int16_t longAxis, int16_t shortAxis, uint8_t curvePart, uint16_t color, bool filled);
 	void 	lineAddressing(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
 	void 	curveAddressing(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+	void 	circleRun(const RA8875circle c[], uint16_t n, uint16_t color, bool all, uint8_t shadow[5], bool &valid);
+	void 	rectRun(const RA8875rect r[], uint16_t n, uint16_t color, bool all, uint8_t shadow[8], bool &valid);
+	void 	changedRegisters(const uint8_t reg[], const uint8_t data[], uint8_t shadow[], uint8_t len, bool valid);
 	void 	roundRectHelper(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color, bool filled);
 
+	void 	bteStart(uint8_t srcLayer, int16_t sx, int16_t sy, uint8_t dstLayer, int16_t dx, int16_t dy, int16_t w, int16_t h, uint8_t becr1);
+	bool 	bteClip(int16_t &sx, int16_t &sy, int16_t &dx, int16_t &dy, int16_t &w, int16_t &h);
 	void 	DMA_blockModeSize(int16_t BWR,int16_t BHR,int16_t SPWR);
 	void 	DMA_startAddress(unsigned long adrs);
 	//---------------------------------------------------------
@@ -237,11 +331,13 @@ void println(const char* str) { print(str); print("\r\n"); };
 	uint8_t 	readReg(uint8_t reg);
 	//void    	writeCommand(uint8_t d);
 	void    	writeData(uint8_t data);
-	void    	writeBlock(uint8_t *data, int len);
+	void    	writeBlock(const uint8_t *data, int len);
+	void    	writeBlock(const uint8_t *head, int hlen, const uint8_t *data, int len);
+	void    	spiSend(const uint8_t *data, int len);
 	void        writeCommandData(uint8_t c, uint8_t d);
 	//void  		writeData16(uint16_t data);
 	uint8_t 	readData(bool stat=false);
-	void        setMultipleRegisters(uint8_t reg[], uint8_t data[], uint8_t len);
+	void        setMultipleRegisters(const uint8_t reg[], const uint8_t data[], uint8_t len);
 
 	bool 	waitPoll(uint8_t r, uint8_t f);//from adafruit
 	void 		waitBusy(uint8_t res=0x80);//0x80, 0x40(BTE busy), 0x01(DMA busy)
@@ -252,6 +348,7 @@ void println(const char* str) { print(str); print("\r\n"); };
 	bool        _rst; // set to true if using H/W reset otherwise does soft reset
 	// Register containers -----------------------------------------
 	uint8_t		_MWCR0Reg; //keep track of the register 		  [0x40]
+	uint8_t		_MWCR1Reg; //keep track of the register 		  [0x41]
 	uint8_t		_DPCRReg;  ////Display Configuration		  	  [0x20]
 	uint8_t		_FNCR0Reg; //Font Control Register 0 		  	  [0x21]
 	uint8_t		_FNCR1Reg; //Font Control Register1 			  [0x22]
@@ -264,6 +361,16 @@ void println(const char* str) { print(str); print("\r\n"); };
 	SPI_HandleTypeDef *hspi;
 	GPIO_TypeDef* cs_port;
 	uint16_t cs_pin;
+#if RA8875_FAST_SPI
+	RA8875FastSPI _fast; // same SPI and pin, without the HAL
+#endif
+};
+
+// panel size chosen at run time
+class RA8875 : public RA8875T<PanelRuntime> {
+ public:
+	RA8875(SPI_HandleTypeDef *hspi, GPIO_TypeDef *csport, uint16_t cspin) : RA8875T<PanelRuntime>(hspi, csport, cspin) {}
+	void 		begin(const enum RA8875sizes s);
 };
 
 #endif
@@ -0,0 +1,61 @@
+/*
+	Panel traits for RA8875T<Panel>.
+	Everything is constexpr so the bounds checks fold into constants and the
+	init table is sent straight from flash.
+	timing[] holds PLLC1, PLLC2, PCSR, then HDWR to VPWR in register order.
+	(included from RA8875.h after the enums)
+*/
+
+#ifndef _RA8875PANELS_H_
+#define _RA8875PANELS_H_
+
+struct Panel320x240 {//still not supported! Wait next version
+	static constexpr enum RA8875sizes size = RA8875_320x240;
+	static constexpr uint16_t width = 320;
+	static constexpr uint16_t height = 240;
+	static constexpr uint8_t maxLayers = 2;
+	static constexpr uint8_t timing[15] = {0x0A,0x02,0x03,0x27,0x00,0x05,0x04,0x03,0xEF,0x00,0x05,0x00,0x0E,0x00,0x02};//(to be fixed)
+};
+
+struct Panel480x272 {
+	static constexpr enum RA8875sizes size = RA8875_480x272;
+	static constexpr uint16_t width = 480;
+	static constexpr uint16_t height = 272;
+	static constexpr uint8_t maxLayers = 2;
+	static constexpr uint8_t timing[15] = {0x10,0x02,0x82,0x3B,0x00,0x01,0x00,0x05,0x0F,0x01,0x02,0x00,0x07,0x00,0x09};//(0x0A)
+};
+
+struct Panel640x480 {//still not supported! Wait next version
+	static constexpr enum RA8875sizes size = RA8875_640x480;
+	static constexpr uint16_t width = 640;
+	static constexpr uint16_t height = 480;
+	static constexpr uint8_t maxLayers = 1;
+	static constexpr uint8_t timing[15] = {0x0B,0x02,0x01,0x4F,0x05,0x0F,0x01,0x00,0xDF,0x10,0x0A,0x00,0x0E,0x00,0x01};//(to be fixed)
+};
+
+struct Panel800x480 {
+	static constexpr enum RA8875sizes size = RA8875_800x480;
+	static constexpr uint16_t width = 800;
+	static constexpr uint16_t height = 480;
+	static constexpr uint8_t maxLayers = 1;
+	static constexpr uint8_t timing[15] = {0x10,0x02,0x81,0x63,0x00,0x03,0x03,0x0B,0xDF,0x01,0x1F,0x00,0x16,0x00,0x01};//(0x0B)(to be fixed?)
+};
+
+// Adafruit boards also need GPIOX on for the backlight
+struct PanelAdafruit480x272 : Panel480x272 {
+	static constexpr enum RA8875sizes size = Adafruit_480x272;
+};
+
+struct PanelAdafruit800x480 : Panel800x480 {
+	static constexpr enum RA8875sizes size = Adafruit_800x480;
+};
+
+// size picked at run time by RA8875::begin(RA8875sizes), a width of 0 makes
+// the bounds checks read _width/_height instead
+struct PanelRuntime : Panel480x272 {
+	static constexpr uint16_t width = 0;
+	static constexpr uint16_t height = 0;
+	static constexpr uint8_t maxLayers = 0;
+};
+
+#endif
@@ -0,0 +1,75 @@
+/*
+	Bare register SPI transport for the short RA8875 transactions.
+
+	A 2 to 4 byte register access through HAL_SPI_Transmit spends most of its
+	time in handle locking, state checks and HAL_GetTick timeouts, and
+	HAL_GPIO_WritePin for CS. This drives the SPI data register directly and
+	CS through BSRR, on the SPI instance and pin the display was constructed
+	with, kept here so an access is one load off the object and no calls.
+	The register types are parameters so a host test can put recording ones
+	in their place.
+
+	The SPI must already be set up by HAL_SPI_Init (master, 8 bit, software NSS),
+	the baud rate may be changed underneath by clock_update_peripherals.
+*/
+
+#ifndef _SPITRANSPORT_H_
+#define _SPITRANSPORT_H_
+
+#include <stdint.h>
+
+#include "stm32l1xx_hal.h"
+
+template<class SPI_T = SPI_TypeDef, class GPIO_T = GPIO_TypeDef>
+class SpiTransport {
+ public:
+	SpiTransport(SPI_T *spi, GPIO_T *csPort, uint16_t csPin) : _spi(spi), _csPort(csPort), _csPin(csPin) {}
+
+	inline void select() { _csPort->BSRR = (uint32_t)_csPin << 16; }
+	inline void deselect() { _csPort->BSRR = _csPin; }
+
+	// transmit only, the next byte is queued while the previous one shifts out
+	void write(const uint8_t *tx, int len) {
+		SPI_T *s= _spi;
+		enable();
+		for (int i= 0; i < len; i++) {
+			while ((s->SR & SPI_SR_TXE) == 0);
+			s->DR= tx[i];
+		}
+		drain();
+	}
+
+	// lock step, so an interrupt between bytes can not cause an overrun
+	void transfer(const uint8_t *tx, uint8_t *rx, int len) {
+		SPI_T *s= _spi;
+		enable();
+		for (int i= 0; i < len; i++) {
+			while ((s->SR & SPI_SR_TXE) == 0);
+			s->DR= tx[i];
+			while ((s->SR & SPI_SR_RXNE) == 0);
+			rx[i]= s->DR;
+		}
+		while (s->SR & SPI_SR_BSY);
+	}
+
+ private:
+	inline void enable() {
+		if ((_spi->CR1 & SPI_CR1_SPE) == 0) _spi->CR1 |= SPI_CR1_SPE;
+	}
+
+	// wait for the last byte to go and discard what came back, reading DR then
+	// SR also clears the overrun flag so the HAL does not see it later
+	inline void drain() {
+		SPI_T *s= _spi;
+		while ((s->SR & SPI_SR_TXE) == 0);
+		while (s->SR & SPI_SR_BSY);
+		(void)(uint32_t)s->DR;
+		(void)(uint32_t)s->SR;
+	}
+
+	SPI_T *_spi;
+	GPIO_T *_csPort;
+	uint16_t _csPin;
+};
+
+#endif
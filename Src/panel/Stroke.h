@@ -0,0 +1,180 @@
+/*
+	Touch stroke renderer.
+	Keeps the last points of each finger and joins the samples with thick
+	segments, each one two filled triangles plus a round cap at the new
+	point, so the line stays continuous however fast the finger moves.
+	Samples closer than the minimum distance to the last point are skipped,
+	a slow finger doesn't redraw the same spot over and over.
+	Fingers missing from a report end their stroke (endReport).
+
+	Smoothing runs a Catmull-Rom spline through the samples: each sample
+	gets its round cap as it arrives, the piece between two samples is
+	drawn when the sample after them arrives (one sample of latency) and
+	split into as few straight pieces as keep it within STROKE_TOLERANCE
+	of the curve, more on sharp bends and long fast moves, a single one on
+	straight runs. Fixed point, 1/16 pixel.
+*/
+
+#ifndef _STROKE_H_
+#define _STROKE_H_
+
+#include <stdint.h>
+
+// max distance of the drawn pieces from the spline, 1/16 pixels
+#define STROKE_TOLERANCE	16
+// pieces per sample at most
+#define STROKE_MAX_PIECES	8
+
+// FINGERS up to 32, the GSL1680 reports ids 0...15
+template<class Display, uint8_t FINGERS>
+class StrokeRenderer {
+ public:
+	// width in pixels, samples nearer than minDist pixels are dropped
+	StrokeRenderer(uint8_t width, uint8_t minDist, bool smooth=true) : _r(width / 2), _minDist(minDist), _smooth(smooth), _down(0), _seen(0) {}
+
+	void add(Display *d, uint8_t finger, int16_t x, int16_t y, uint16_t color) {
+		if (finger >= FINGERS) return;
+		uint32_t bit = 1UL << finger;
+		_seen |= bit;
+		Finger &f = _f[finger];
+		if (!(_down & bit)) {//a new stroke starts with a dot
+			_down |= bit;
+			f.n = 1;
+			f.x[0] = x;
+			f.y[0] = y;
+			f.color = color;
+			d->fillCircle(x, y, _r, color);
+			return;
+		}
+		int32_t dx = x - f.x[f.n-1], dy = y - f.y[f.n-1];
+		if (dx * dx + dy * dy < (int32_t)_minDist * _minDist) return;
+		f.color = color;
+
+		if (!_smooth) {
+			segment(d, f.x[0], f.y[0], x, y, color);
+			f.x[0] = x;
+			f.y[0] = y;
+			return;
+		}
+		// the piece up to the last sample is drawn now that the next one is known,
+		// the first piece of a stroke repeats its start point
+		if (f.n >= 2) {
+			uint8_t k = f.n - 1;
+			uint8_t j = k > 1 ? k - 2 : 0;
+			spline(d, f, f.x[j], f.y[j], f.x[k-1], f.y[k-1], f.x[k], f.y[k], x, y);
+		}
+		d->fillCircle(x, y, _r, color);//the finger shows before the curve reaches it
+		if (f.n == 3) {//drop the oldest
+			f.x[0] = f.x[1]; f.y[0] = f.y[1];
+			f.x[1] = f.x[2]; f.y[1] = f.y[2];
+			f.n = 2;
+		}
+		f.x[f.n] = x;
+		f.y[f.n] = y;
+		f.n++;
+	}
+
+	// call after each report, fingers not added since the last call are lifted
+	// and the last piece of their stroke is drawn
+	void endReport(Display *d) {
+		uint32_t lifted = _down & ~_seen;
+		for (uint8_t i = 0; lifted != 0; i++, lifted >>= 1) {
+			if (!(lifted & 1)) continue;
+			Finger &f = _f[i];
+			if (_smooth && f.n >= 2) {
+				uint8_t k = f.n - 1;
+				uint8_t j = k > 1 ? k - 2 : 0;
+				spline(d, f, f.x[j], f.y[j], f.x[k-1], f.y[k-1], f.x[k], f.y[k], f.x[k], f.y[k]);
+			}
+		}
+		_down &= _seen;
+		_seen = 0;
+	}
+
+ private:
+	struct Finger {
+		int16_t x[3], y[3]; // last samples, oldest first
+		uint8_t n;
+		uint16_t color;
+	};
+
+	// thick segment, the cap joins it to the next one
+	void segment(Display *d, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color, bool cap=true) {
+		int32_t dx = x1 - x0, dy = y1 - y0;
+		int32_t len = isqrt(dx * dx + dy * dy);
+		if (len == 0) return;
+		// half width offset perpendicular to the segment
+		int16_t ox = divRound(-dy * _r, len);
+		int16_t oy = divRound(dx * _r, len);
+		d->fillTriangle(x0 + ox, y0 + oy, x1 + ox, y1 + oy, x1 - ox, y1 - oy, color);
+		d->fillTriangle(x0 + ox, y0 + oy, x1 - ox, y1 - oy, x0 - ox, y0 - oy, color);
+		if (cap) d->fillCircle(x1, y1, _r, color);
+	}
+
+	// Catmull-Rom piece p1-p2 as a cubic Bezier: b1 = p1 + (p2 - p0) / 6, b2 = p2 - (p3 - p1) / 6
+	void spline(Display *d, Finger &f, int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3) {
+		int32_t px[4], py[4];
+		px[0] = x1 << 4; py[0] = y1 << 4;
+		px[3] = x2 << 4; py[3] = y2 << 4;
+		px[1] = px[0] + divRound((x2 - x0) << 4, 6);
+		py[1] = py[0] + divRound((y2 - y0) << 4, 6);
+		px[2] = px[3] - divRound((x3 - x1) << 4, 6);
+		py[2] = py[3] - divRound((y3 - y1) << 4, 6);
+
+		// distance of the control points from the chord, n pieces stray about 3/4 m / n^2
+		int32_t cx = px[3] - px[0], cy = py[3] - py[0];
+		int32_t chord = isqrt(cx * cx + cy * cy);
+		if (chord == 0) chord = 1;
+		int32_t m = imax(iabs((px[1] - px[0]) * cy - (py[1] - py[0]) * cx),
+						 iabs((px[2] - px[0]) * cy - (py[2] - py[0]) * cx)) / chord;
+		int32_t n = 1;
+		while (n < STROKE_MAX_PIECES && 4 * STROKE_TOLERANCE * n * n < 3 * m) n++;
+
+		int16_t lx = x1, ly = y1;
+		for (int32_t i = 1; i <= n; i++) {
+			int16_t x = x2, y = y2;
+			if (i < n) {
+				int32_t t = (i << 8) / n;//Q8
+				x = (bezier(px, t) + 8) >> 4;
+				y = (bezier(py, t) + 8) >> 4;
+			}
+			segment(d, lx, ly, x, y, f.color, i < n);//the sample got its cap when it came
+			lx = x; ly = y;
+		}
+	}
+
+	// de Casteljau, t in Q8
+	static int32_t bezier(const int32_t p[4], int32_t t) {
+		int32_t a = lerp(p[0], p[1], t), b = lerp(p[1], p[2], t), c = lerp(p[2], p[3], t);
+		a = lerp(a, b, t);
+		b = lerp(b, c, t);
+		return lerp(a, b, t);
+	}
+	static int32_t lerp(int32_t a, int32_t b, int32_t t) { return a + (((b - a) * t) >> 8); }
+	static int32_t iabs(int32_t v) { return v < 0 ? -v : v; }
+	static int32_t imax(int32_t a, int32_t b) { return a > b ? a : b; }
+	static int16_t divRound(int32_t n, int32_t d) { return (n >= 0 ? n + d / 2 : n - d / 2) / d; }
+
+	static int32_t isqrt(int32_t v) {
+		int32_t r = 0, b = 1L << 30;
+		while (b > v) b >>= 2;
+		while (b != 0) {
+			if (v >= r + b) {
+				v -= r + b;
+				r = (r >> 1) + b;
+			} else {
+				r >>= 1;
+			}
+			b >>= 2;
+		}
+		return r;
+	}
+
+	int16_t _r;
+	uint8_t _minDist;
+	bool _smooth;
+	uint32_t _down, _seen; // bit per finger
+	Finger _f[FINGERS];
+};
+
+#endif
@@ -0,0 +1,160 @@
+/*
+	Scrolling text console.
+	ROWS lines of COLS characters in a scroll window. The lines live in a ring
+	in display memory, the controller's vertical scroll offset picks which one
+	shows at the top, so advancing a line is one fillRect of the line that
+	becomes the new bottom plus an offset write, whatever the console height.
+	The text is also kept in a ring here so redraw() can restore the console
+	after the screen was cleared.
+	While scrolled, display memory in the window is not at screen positions,
+	so whatever else draws there must call unscroll() first.
+	Uses the font metrics current at begin(), characters are fixed width.
+*/
+
+#ifndef _TEXTCONSOLE_H_
+#define _TEXTCONSOLE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+template<class Display, uint8_t COLS, uint8_t ROWS>
+class TextConsole {
+ public:
+	// top: first pixel row of the console, it spans the full width
+	void begin(Display *d, uint16_t top, uint16_t fg, uint16_t bg) {
+		_d = d;
+		_top = top;
+		_fg = fg;
+		_bg = bg;
+		_cw = d->charWidth();
+		_lh = d->lineHeight();
+		d->setScrollWindow(0, COLS * _cw - 1, top, top + ROWS * _lh - 1);
+		clear();
+	}
+
+	void clear(void) {
+		memset(_len, 0, sizeof(_len));
+		_first = 0;
+		_row = 0;
+		_col = 0;
+		_d->fillRect(0, _top, COLS * _cw - 1, ROWS * _lh - 1, _bg);
+		_d->scroll(0, 0);
+	}
+
+	// restore the console after something else drew over it, the lines go
+	// back in display order with no scroll offset
+	void redraw(void) {
+		reorder();
+		_d->fillRect(0, _top, COLS * _cw - 1, ROWS * _lh - 1, _bg);
+		_d->setTextColor(_fg, _bg);
+		for (uint8_t s = 0; s < ROWS; s++) {
+			if (_len[s] == 0) continue;
+			_d->setCursor(0, slotY(s));
+			_d->print(_lines[s], _len[s]);
+		}
+		_d->scroll(0, 0);
+	}
+
+	// make the window show display memory at screen positions again, before
+	// drawing over the console; a redraw if it scrolled since, else nothing
+	void unscroll(void) {
+		if (_first != 0) redraw();
+	}
+
+	void print(const char* str) {
+		uint8_t start = _col;
+		_d->setTextColor(_fg, _bg);
+		for (; *str; str++) {
+			char c = *str;
+			if (c == '\n' || c == '\r') {
+				flush(start);
+				if (c == '\n') newLine();
+				else _col = 0;
+				start = _col;
+				continue;
+			}
+			uint8_t s = slot(_row);
+			_lines[s][_col++] = c;
+			if (_col > _len[s]) _len[s] = _col;
+			if (_col == COLS) {
+				flush(start);
+				newLine();
+				start = 0;
+			}
+		}
+		flush(start);
+	}
+
+	void printf(const char* format, ...) {
+		char buf[COLS * 2 + 1];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(buf, sizeof(buf), format, args);
+		va_end(args);
+		print(buf);
+	}
+
+	// display memory slot of a visible row, and the offset that puts _first on top
+	static uint8_t slotOf(uint8_t first, uint8_t row) { return (first + row) % ROWS; }
+	static uint16_t offsetOf(uint8_t first, uint16_t lh) { return first * lh; }
+
+ private:
+	uint8_t slot(uint8_t row) { return slotOf(_first, row); }
+	uint16_t slotY(uint8_t s) { return _top + s * _lh; }
+
+	// rotate the ring so the top line is in slot 0, by three reversals
+	void reorder(void) {
+		reverse(0, _first);
+		reverse(_first, ROWS);
+		reverse(0, ROWS);
+		_first = 0;
+	}
+	void reverse(uint8_t a, uint8_t b) {
+		while (a + 1 < b) swapSlots(a++, --b);
+	}
+	void swapSlots(uint8_t a, uint8_t b) {
+		for (uint8_t i = 0; i < COLS; i++) {
+			char t = _lines[a][i];
+			_lines[a][i] = _lines[b][i];
+			_lines[b][i] = t;
+		}
+		uint8_t t = _len[a];
+		_len[a] = _len[b];
+		_len[b] = t;
+	}
+
+	// send the characters written to the current line since start
+	void flush(uint8_t start) {
+		if (_col <= start) return;
+		uint8_t s = slot(_row);
+		_d->setCursor(start * _cw, slotY(s));
+		_d->print(&_lines[s][start], _col - start);
+	}
+
+	void newLine(void) {
+		_col = 0;
+		if (_row < ROWS - 1) {
+			_row++;
+			return;
+		}
+		// the top line is recycled as the new bottom line
+		uint8_t s = _first;
+		_len[s] = 0;
+		_d->fillRect(0, slotY(s), COLS * _cw - 1, _lh - 1, _bg);
+		_first = (_first + 1) % ROWS;
+		_d->scroll(0, offsetOf(_first, _lh));
+		_d->setTextColor(_fg, _bg);
+	}
+
+	Display *_d;
+	uint16_t _top, _fg, _bg;
+	uint16_t _cw, _lh;
+	uint8_t _first;		// slot shown at the top
+	uint8_t _row, _col;	// cursor, visible row and column
+	char _lines[ROWS][COLS];
+	uint8_t _len[ROWS];
+};
+
+#endif
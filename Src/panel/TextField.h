@@ -0,0 +1,69 @@
+/*
+	Incremental text field.
+	Remembers what it last rendered and only re-sends the runs of characters
+	that changed, placed from the fixed width font metrics. Runs separated by
+	a few unchanged characters are merged as repositioning the cursor costs
+	more than resending them.
+	The text must be drawn with an opaque background (setTextColor(fg, bg)),
+	characters are overwritten in place and a shorter value is padded with spaces.
+*/
+
+#ifndef _TEXTFIELD_H_
+#define _TEXTFIELD_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+// unchanged characters worth resending rather than moving the cursor
+#define TEXTFIELD_MERGE_GAP		16
+
+template<class Display, uint8_t N>
+class TextField {
+ public:
+	// position in character cells of the current font
+	TextField(uint8_t col, uint8_t row) : _col(col), _row(row) { invalidate(); }
+
+	// the next update redraws everything, e.g. after the screen was cleared
+	void invalidate(void) { memset(_shown, 0, sizeof(_shown)); }
+
+	void printf(Display *d, const char* format, ...) {
+		char buf[N+1];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(buf, sizeof(buf), format, args);
+		va_end(args);
+		set(d, buf);
+	}
+
+	void set(Display *d, const char* str) {
+		char next[N];
+		uint8_t len = strnlen(str, N);
+		memcpy(next, str, len);
+		memset(&next[len], ' ', N - len);
+
+		uint16_t cw = d->charWidth();
+		uint16_t x = _col * cw, y = _row * d->lineHeight();
+		uint8_t i = 0;
+		while (i < N) {
+			if (next[i] == _shown[i]) { i++; continue; }
+			// extend the run over changes separated by short gaps
+			uint8_t end = i + 1, last = i + 1;
+			while (end < N && end - last < TEXTFIELD_MERGE_GAP) {
+				if (next[end] != _shown[end]) last = end + 1;
+				end++;
+			}
+			d->setCursor(x + i * cw, y);
+			d->print(&next[i], last - i);
+			i = last;
+		}
+		memcpy(_shown, next, N);
+	}
+
+ private:
+	uint8_t _col, _row;
+	char _shown[N]; // 0 never matches, forces a redraw
+};
+
+#endif
@@ -0,0 +1,174 @@
+/*
+	UTF-8 text.
+	Decodes UTF-8 and prints each character through the internal font in
+	one of its ISO 8859-1...4 codings, switching the coding register only
+	when the current one lacks a character (then to the one covering most
+	of what follows). Consecutive characters of one coding go out as one
+	print, characters no coding has are printed from CGRAM through a
+	GlyphCache, keyed by code point, in one burst per run. CGRAM glyphs
+	are 8x16 like the X16 internal font and aren't wrapped at the edge.
+	Invalid sequences decode to U+FFFD.
+*/
+
+#ifndef _UTF8_TEXT_H_
+#define _UTF8_TEXT_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include "GlyphCache.h"
+
+// bytes of one coding printed at once
+#define UTF8_RUN		32
+// printf output
+#define UTF8_PRINTF		64
+// characters looked ahead to choose a coding
+#define UTF8_LOOKAHEAD	16
+#define UTF8_INVALID	0xFFFD
+
+template<class Display, uint16_t SLOTS>
+class Utf8Text {
+ public:
+	typedef typename GlyphCache<Display, SLOTS>::Source Source;
+
+	// fallback: 16 byte glyphs by code point, stored from CGRAM address first
+	Utf8Text(Source fallback, uint8_t first=0) : _cache(fallback, first), _coding(ISO_IEC_8859_1), _switches(0) {}
+
+	void printf(Display *d, const char* format, ...) {
+		char buf[UTF8_PRINTF];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(buf, sizeof(buf), format, args);
+		va_end(args);
+		print(d, buf);
+	}
+
+	void print(Display *d, const char *s) {
+		char text[UTF8_RUN];
+		uint16_t glyphs[GLYPH_RUN];
+		uint8_t nt = 0, ng = 0;
+		_coding = d->getIntFontCoding();// others may have set it since
+		while (*s) {
+			const char *here = s;
+			uint32_t cp = decode(s);
+			int8_t c = _coding;
+			if (cp >= 0x80 && !encode(cp, _coding)) c = best(here);
+			if (cp >= 0x80 && c < 0) {//not in the font, from CGRAM
+				if (nt > 0) { d->print(text, nt); nt = 0; }
+				glyphs[ng++] = cp <= 0xFFFF ? cp : UTF8_INVALID;
+				if (ng == GLYPH_RUN) { _cache.print(d, glyphs, ng); ng = 0; }
+				continue;
+			}
+			if (ng > 0) { _cache.print(d, glyphs, ng); ng = 0; }
+			if (c != _coding) {
+				if (nt > 0) { d->print(text, nt); nt = 0; }
+				d->setIntFontCoding((enum RA8875fontCoding)c);
+				_coding = c;
+				_switches++;
+			}
+			text[nt++] = cp < 0x80 ? cp : encode(cp, c);
+			if (nt == UTF8_RUN) { d->print(text, nt); nt = 0; }
+		}
+		if (nt > 0) d->print(text, nt);
+		if (ng > 0) _cache.print(d, glyphs, ng);
+	}
+
+	// coding register writes so far
+	uint32_t switches(void) const { return _switches; }
+	GlyphCache<Display, SLOTS> &cache(void) { return _cache; }
+
+	// next code point, s moves past it
+	static uint32_t decode(const char *&s) {
+		uint8_t b = *s++;
+		if (b < 0x80) return b;
+		uint8_t n;
+		uint32_t cp, min;
+		if ((b & 0xE0) == 0xC0) { n = 1; cp = b & 0x1F; min = 0x80; }
+		else if ((b & 0xF0) == 0xE0) { n = 2; cp = b & 0x0F; min = 0x800; }
+		else if ((b & 0xF8) == 0xF0) { n = 3; cp = b & 0x07; min = 0x10000; }
+		else return UTF8_INVALID;
+		for (uint8_t i = 0; i < n; i++) {
+			uint8_t c = s[i];
+			if ((c & 0xC0) != 0x80) {//cut short, the next character starts here
+				s += i;
+				return UTF8_INVALID;
+			}
+			cp = (cp << 6) | (c & 0x3F);
+		}
+		s += n;
+		if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return UTF8_INVALID;
+		return cp;
+	}
+
+	// byte of a code point above 0x7F in coding 0...3 (ISO 8859-1...4), 0 if it has none
+	static uint8_t encode(uint32_t cp, uint8_t coding) {
+		if (cp < 0xA0 || cp > 0x2DD) return 0;
+		if (coding == 0) return cp <= 0xFF ? cp : 0;
+		const uint16_t *t = _upper[coding - 1];
+		for (uint8_t i = 0; i < 96; i++) {
+			if (t[i] == cp) return 0xA0 + i;
+		}
+		return 0;
+	}
+
+ private:
+	// the coding that has the most of the characters from s on, -1 if none has the first
+	static int8_t best(const char *s) {
+		int8_t c = -1;
+		uint8_t most = 0;
+		for (uint8_t k = 0; k < 4; k++) {
+			const char *p = s;
+			uint8_t n = 0;
+			while (*p && n < UTF8_LOOKAHEAD) {
+				uint32_t cp = decode(p);
+				if (cp >= 0x80 && !encode(cp, k)) break;
+				n++;
+			}
+			if (n > most) { most = n; c = k; }
+		}
+		return c;
+	}
+
+	// 0xA0...0xFF, 0 where the coding has no character
+	static const uint16_t _upper[3][96];
+
+	GlyphCache<Display, SLOTS> _cache;
+	int8_t _coding; // as the display had it when print started
+	uint32_t _switches;
+};
+
+template<class Display, uint16_t SLOTS>
+const uint16_t Utf8Text<Display, SLOTS>::_upper[3][96] = {
+	{// ISO 8859-2
+		0x00A0,0x0104,0x02D8,0x0141,0x00A4,0x013D,0x015A,0x00A7,0x00A8,0x0160,0x015E,0x0164,
+		0x0179,0x00AD,0x017D,0x017B,0x00B0,0x0105,0x02DB,0x0142,0x00B4,0x013E,0x015B,0x02C7,
+		0x00B8,0x0161,0x015F,0x0165,0x017A,0x02DD,0x017E,0x017C,0x0154,0x00C1,0x00C2,0x0102,
+		0x00C4,0x0139,0x0106,0x00C7,0x010C,0x00C9,0x0118,0x00CB,0x011A,0x00CD,0x00CE,0x010E,
+		0x0110,0x0143,0x0147,0x00D3,0x00D4,0x0150,0x00D6,0x00D7,0x0158,0x016E,0x00DA,0x0170,
+		0x00DC,0x00DD,0x0162,0x00DF,0x0155,0x00E1,0x00E2,0x0103,0x00E4,0x013A,0x0107,0x00E7,
+		0x010D,0x00E9,0x0119,0x00EB,0x011B,0x00ED,0x00EE,0x010F,0x0111,0x0144,0x0148,0x00F3,
+		0x00F4,0x0151,0x00F6,0x00F7,0x0159,0x016F,0x00FA,0x0171,0x00FC,0x00FD,0x0163,0x02D9,
+	},
+	{// ISO 8859-3
+		0x00A0,0x0126,0x02D8,0x00A3,0x00A4,0x0000,0x0124,0x00A7,0x00A8,0x0130,0x015E,0x011E,
+		0x0134,0x00AD,0x0000,0x017B,0x00B0,0x0127,0x00B2,0x00B3,0x00B4,0x00B5,0x0125,0x00B7,
+		0x00B8,0x0131,0x015F,0x011F,0x0135,0x00BD,0x0000,0x017C,0x00C0,0x00C1,0x00C2,0x0000,
+		0x00C4,0x010A,0x0108,0x00C7,0x00C8,0x00C9,0x00CA,0x00CB,0x00CC,0x00CD,0x00CE,0x00CF,
+		0x0000,0x00D1,0x00D2,0x00D3,0x00D4,0x0120,0x00D6,0x00D7,0x011C,0x00D9,0x00DA,0x00DB,
+		0x00DC,0x016C,0x015C,0x00DF,0x00E0,0x00E1,0x00E2,0x0000,0x00E4,0x010B,0x0109,0x00E7,
+		0x00E8,0x00E9,0x00EA,0x00EB,0x00EC,0x00ED,0x00EE,0x00EF,0x0000,0x00F1,0x00F2,0x00F3,
+		0x00F4,0x0121,0x00F6,0x00F7,0x011D,0x00F9,0x00FA,0x00FB,0x00FC,0x016D,0x015D,0x02D9,
+	},
+	{// ISO 8859-4
+		0x00A0,0x0104,0x0138,0x0156,0x00A4,0x0128,0x013B,0x00A7,0x00A8,0x0160,0x0112,0x0122,
+		0x0166,0x00AD,0x017D,0x00AF,0x00B0,0x0105,0x02DB,0x0157,0x00B4,0x0129,0x013C,0x02C7,
+		0x00B8,0x0161,0x0113,0x0123,0x0167,0x014A,0x017E,0x014B,0x0100,0x00C1,0x00C2,0x00C3,
+		0x00C4,0x00C5,0x00C6,0x012E,0x010C,0x00C9,0x0118,0x00CB,0x0116,0x00CD,0x00CE,0x012A,
+		0x0110,0x0145,0x014C,0x0136,0x00D4,0x00D5,0x00D6,0x00D7,0x00D8,0x0172,0x00DA,0x00DB,
+		0x00DC,0x0168,0x016A,0x00DF,0x0101,0x00E1,0x00E2,0x00E3,0x00E4,0x00E5,0x00E6,0x012F,
+		0x010D,0x00E9,0x0119,0x00EB,0x0117,0x00ED,0x00EE,0x012B,0x0111,0x0146,0x014D,0x0137,
+		0x00F4,0x00F5,0x00F6,0x00F7,0x00F8,0x0173,0x00FA,0x00FB,0x00FC,0x0169,0x016B,0x02D9,
+	},
+};
+
+#endif
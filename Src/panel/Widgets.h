@@ -0,0 +1,349 @@
+/*
+	Retained widgets.
+	A fixed pool of labels, buttons, sliders, progress bars and numeric
+	readouts that remember their state. Changing a widget only records the
+	area that needs repainting in a short damage list, paint() then clips to
+	each damaged rectangle (setClipRect) and repaints the widgets under it in
+	creation order, later widgets on top.
+	Damaged rectangles are merged when their union adds no more than
+	mergeWaste pixels that didn't need repainting: 0 keeps them apart (more
+	transactions, no overdraw), large values end up repainting one box.
+	A progress bar or slider change only damages the part that moved.
+	Text widgets are always repainted whole, the text isn't clipped.
+	Touches and repaints find their widgets through a HitGrid index
+	instead of testing every widget.
+*/
+
+#ifndef _WIDGETS_H_
+#define _WIDGETS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "HitGrid.h"
+
+// damaged rectangles kept, more are merged into the cheapest pair
+#define WIDGET_MAX_DAMAGE	8
+// default repaint area accepted to merge two rectangles, in pixels
+#define WIDGET_MERGE_WASTE	2048
+// characters of a label or button text
+#define WIDGET_TEXT			16
+// hit-test index: screen size, cell size and widgets kept per cell
+#define WIDGET_GRID_WIDTH	800
+#define WIDGET_GRID_HEIGHT	480
+#define WIDGET_GRID_CELL	40
+#define WIDGET_GRID_SLOTS	4
+
+enum WidgetKind { W_LABEL, W_BUTTON, W_SLIDER, W_PROGRESS, W_NUMBER };
+
+struct WidgetRect {
+	int16_t x, y, w, h;
+
+	int32_t area(void) const { return (int32_t)w * h; }
+	bool empty(void) const { return w <= 0 || h <= 0; }
+	bool contains(int16_t px, int16_t py) const { return px >= x && px < x + w && py >= y && py < y + h; }
+	bool covers(const WidgetRect &o) const { return o.x >= x && o.y >= y && o.x + o.w <= x + w && o.y + o.h <= y + h; }
+	bool overlaps(const WidgetRect &o) const { return x < o.x + o.w && o.x < x + w && y < o.y + o.h && o.y < y + h; }
+	WidgetRect unite(const WidgetRect &o) const {
+		int16_t l = x < o.x ? x : o.x, t = y < o.y ? y : o.y;
+		int16_t r = x + w > o.x + o.w ? x + w : o.x + o.w, b = y + h > o.y + o.h ? y + h : o.y + o.h;
+		WidgetRect u = {l, t, (int16_t)(r - l), (int16_t)(b - t)};
+		return u;
+	}
+	int32_t overlapArea(const WidgetRect &o) const {
+		if (!overlaps(o)) return 0;
+		int16_t l = x > o.x ? x : o.x, t = y > o.y ? y : o.y;
+		int16_t r = x + w < o.x + o.w ? x + w : o.x + o.w, b = y + h < o.y + o.h ? y + h : o.y + o.h;
+		return (int32_t)(r - l) * (b - t);
+	}
+};
+
+struct Widget {
+	WidgetRect r;
+	uint8_t kind;
+	bool pressed;
+	uint16_t fg, bg;
+	int32_t value, min, max;
+	char text[WIDGET_TEXT + 1];
+};
+
+template<class Display, uint8_t N>
+class WidgetSet {
+	static_assert(N <= 127, "widget ids are int8_t, -1 for none");
+ public:
+	WidgetSet(int32_t mergeWaste=WIDGET_MERGE_WASTE) : _count(0), _ndamage(0), _mergeWaste(mergeWaste) {}
+
+	// the add functions return the widget id, -1 when the pool is full
+	int8_t addLabel(int16_t x, int16_t y, int16_t w, int16_t h, const char *text, uint16_t fg, uint16_t bg) {
+		return add(W_LABEL, x, y, w, h, text, 0, 0, 0, fg, bg);
+	}
+	int8_t addButton(int16_t x, int16_t y, int16_t w, int16_t h, const char *text, uint16_t fg, uint16_t bg) {
+		return add(W_BUTTON, x, y, w, h, text, 0, 0, 0, fg, bg);
+	}
+	int8_t addSlider(int16_t x, int16_t y, int16_t w, int16_t h, int32_t min, int32_t max, uint16_t fg, uint16_t bg) {
+		return add(W_SLIDER, x, y, w, h, "", min, min, max, fg, bg);
+	}
+	int8_t addProgress(int16_t x, int16_t y, int16_t w, int16_t h, int32_t max, uint16_t fg, uint16_t bg) {
+		return add(W_PROGRESS, x, y, w, h, "", 0, 0, max, fg, bg);
+	}
+	// shows value with the printf format, e.g. "%5ld"
+	int8_t addNumber(int16_t x, int16_t y, int16_t w, int16_t h, const char *format, uint16_t fg, uint16_t bg) {
+		return add(W_NUMBER, x, y, w, h, format, 0, 0, 0, fg, bg);
+	}
+
+	void setText(int8_t id, const char *text) {
+		Widget &wd = _w[id];
+		if (strncmp(wd.text, text, WIDGET_TEXT) == 0) return;
+		strncpy(wd.text, text, WIDGET_TEXT);
+		damage(wd.r);
+	}
+
+	void setValue(int8_t id, int32_t v) {
+		Widget &wd = _w[id];
+		if (wd.kind == W_SLIDER || wd.kind == W_PROGRESS) {
+			if (v < wd.min) v = wd.min;
+			if (v > wd.max) v = wd.max;
+		}
+		if (v == wd.value) return;
+		if (wd.kind == W_PROGRESS) {//between the old and the new end
+			int16_t a = fillWidth(wd, wd.value), b = fillWidth(wd, v);
+			WidgetRect r = {(int16_t)(wd.r.x + (a < b ? a : b)), wd.r.y, (int16_t)(a < b ? b - a : a - b), wd.r.h};
+			damage(r);
+		} else if (wd.kind == W_SLIDER) {//old and new knob
+			damage(knob(wd, wd.value));
+			damage(knob(wd, v));
+		} else {
+			damage(wd.r);
+		}
+		wd.value = v;
+	}
+
+	// move or resize, both the old and the new place are repainted
+	void setRect(int8_t id, int16_t x, int16_t y, int16_t w, int16_t h) {
+		Widget &wd = _w[id];
+		WidgetRect r = {x, y, w, h};
+		if (memcmp(&r, &wd.r, sizeof(r)) == 0) return;
+		damage(wd.r);
+		_grid.move(id, wd.r.x, wd.r.y, wd.r.w, wd.r.h, x, y, w, h);
+		wd.r = r;
+		damage(r);
+	}
+
+	void setPressed(int8_t id, bool on) {
+		Widget &wd = _w[id];
+		if (wd.pressed == on) return;
+		wd.pressed = on;
+		damage(wd.r);
+	}
+
+	int32_t value(int8_t id) const { return _w[id].value; }
+	const Widget &widget(int8_t id) const { return _w[id]; }
+	uint8_t count(void) const { return _count; }
+
+	// slider value for a touch at x
+	int32_t sliderValue(int8_t id, int16_t x) const {
+		const Widget &wd = _w[id];
+		int16_t travel = wd.r.w - wd.r.h;
+		if (travel <= 0) return wd.min;
+		int32_t p = x - wd.r.x - wd.r.h / 2;
+		if (p < 0) p = 0;
+		if (p > travel) p = travel;
+		return wd.min + (p * (wd.max - wd.min) + travel / 2) / travel;
+	}
+
+	// topmost widget under the point, -1 if none
+	int8_t hit(int16_t x, int16_t y) const {
+		const uint8_t *ids;
+		uint8_t n = _grid.at(x, y, &ids);
+		if (n == HIT_OVERFLOW) {
+			for (int8_t i = _count - 1; i >= 0; i--) {
+				if (_w[i].r.contains(x, y)) return i;
+			}
+			return -1;
+		}
+		for (int8_t k = n - 1; k >= 0; k--) {
+			if (_w[ids[k]].r.contains(x, y)) return ids[k];
+		}
+		return -1;
+	}
+
+	// everything is repainted by the next paint(), e.g. after the screen was cleared
+	void invalidate(void) {
+		_ndamage = 0;
+		for (uint8_t i = 0; i < _count; i++) damage(_w[i].r);
+	}
+
+	void damage(const WidgetRect &r) {
+		if (r.empty()) return;
+		WidgetRect n = r;
+		// text can't be cut (the chip wraps it at the window edge), take whole text widgets
+		bool grown = true;
+		while (grown) {
+			grown = false;
+			for (uint8_t i = 0; i < _count; i++) {
+				const Widget &wd = _w[i];
+				if (wd.kind == W_SLIDER || wd.kind == W_PROGRESS) continue;
+				if (!wd.r.overlaps(n) || n.covers(wd.r)) continue;
+				n = n.unite(wd.r);
+				grown = true;
+			}
+		}
+		// grow into the rectangles it merges with, which may then merge with others
+		bool merged = true;
+		while (merged) {
+			merged = false;
+			for (uint8_t i = 0; i < _ndamage; i++) {
+				if (waste(_damage[i], n) > _mergeWaste) continue;
+				n = n.unite(_damage[i]);
+				_damage[i] = _damage[--_ndamage];
+				merged = true;
+				break;
+			}
+		}
+		if (_ndamage == WIDGET_MAX_DAMAGE) {//full, merge the cheapest pair
+			uint8_t bi = 0, bj = 1;
+			int32_t best = INT32_MAX;
+			for (uint8_t i = 0; i < _ndamage; i++) {
+				for (uint8_t j = i + 1; j < _ndamage; j++) {
+					int32_t c = waste(_damage[i], _damage[j]);
+					if (c < best) { best = c; bi = i; bj = j; }
+				}
+				int32_t c = waste(_damage[i], n);
+				if (c < best) { best = c; bi = i; bj = WIDGET_MAX_DAMAGE; }
+			}
+			if (bj == WIDGET_MAX_DAMAGE) {
+				_damage[bi] = _damage[bi].unite(n);
+				return;
+			}
+			_damage[bi] = _damage[bi].unite(_damage[bj]);
+			_damage[bj] = _damage[--_ndamage];
+		}
+		_damage[_ndamage++] = n;
+	}
+
+	bool dirty(void) const { return _ndamage > 0; }
+
+	// repaint the damaged areas, nothing is sent when nothing changed
+	void paint(Display *d) {
+		for (uint8_t k = 0; k < _ndamage; k++) {
+			const WidgetRect &r = _damage[k];
+			d->setClipRect(r.x, r.y, r.w, r.h);
+			uint8_t ids[N];
+			uint8_t n = _grid.query(r.x, r.y, r.w, r.h, ids, N);
+			if (n == HIT_OVERFLOW) {
+				for (uint8_t i = 0; i < _count; i++) {
+					if (_w[i].r.overlaps(r)) paintWidget(d, _w[i]);
+				}
+				continue;
+			}
+			for (uint8_t i = 0; i < n; i++) {
+				if (_w[ids[i]].r.overlaps(r)) paintWidget(d, _w[ids[i]]);
+			}
+		}
+		if (_ndamage > 0) d->clearClipRect();
+		_ndamage = 0;
+	}
+
+ private:
+	int8_t add(uint8_t kind, int16_t x, int16_t y, int16_t w, int16_t h, const char *text, int32_t value, int32_t min, int32_t max, uint16_t fg, uint16_t bg) {
+		if (_count >= N) return -1;
+		Widget &wd = _w[_count];
+		WidgetRect r = {x, y, w, h};
+		wd.r = r;
+		wd.kind = kind;
+		wd.pressed = false;
+		wd.fg = fg;
+		wd.bg = bg;
+		wd.value = value;
+		wd.min = min;
+		wd.max = max;
+		strncpy(wd.text, text, WIDGET_TEXT);
+		wd.text[WIDGET_TEXT] = 0;
+		_grid.add(_count, x, y, w, h);
+		damage(r);
+		return _count++;
+	}
+
+	// pixels repainted needlessly if a and b become their union
+	static int32_t waste(const WidgetRect &a, const WidgetRect &b) {
+		return a.unite(b).area() - a.area() - b.area() + a.overlapArea(b);
+	}
+
+	static int16_t fillWidth(const Widget &wd, int32_t v) {
+		if (wd.max <= wd.min) return 0;
+		return (int32_t)wd.r.w * (v - wd.min) / (wd.max - wd.min);
+	}
+
+	// square knob on the track
+	static WidgetRect knob(const Widget &wd, int32_t v) {
+		int16_t travel = wd.r.w - wd.r.h;
+		int16_t p = wd.max > wd.min ? (int32_t)travel * (v - wd.min) / (wd.max - wd.min) : 0;
+		WidgetRect r = {(int16_t)(wd.r.x + p), wd.r.y, wd.r.h, wd.r.h};
+		return r;
+	}
+
+	// fillRect/drawRect cover w+1 x h+1 pixels
+	static void fill(Display *d, const WidgetRect &r, uint16_t color) {
+		if (!r.empty()) d->fillRect(r.x, r.y, r.w - 1, r.h - 1, color);
+	}
+
+	// text wider than the widget is cut to what fits, it would start left of
+	// the widget and the clip rect its repaint set
+	static void centerText(Display *d, const WidgetRect &r, const char *text, uint16_t fg, uint16_t bg) {
+		uint16_t len = strlen(text), fit = r.w > 0 ? r.w / d->charWidth() : 0;
+		if (len > fit) len = fit;
+		if (len == 0) return;
+		int16_t tw = len * d->charWidth();
+		d->setTextColor(fg, bg);
+		d->setCursor(r.x + (r.w - tw) / 2, r.y + (r.h - (int16_t)d->lineHeight()) / 2);
+		d->print(text, len);
+	}
+
+	void paintWidget(Display *d, const Widget &wd) {
+		const WidgetRect &r = wd.r;
+		switch (wd.kind) {
+			case W_LABEL:
+				fill(d, r, wd.bg);
+				centerText(d, r, wd.text, wd.fg, wd.bg);
+				break;
+			case W_BUTTON: {
+				uint16_t fg = wd.pressed ? wd.bg : wd.fg, bg = wd.pressed ? wd.fg : wd.bg;
+				int16_t rad = r.h / 4;
+				d->fillRoundRect(r.x, r.y, r.w - 1, r.h - 1, rad, bg);
+				d->drawRoundRect(r.x, r.y, r.w - 1, r.h - 1, rad, wd.fg);
+				centerText(d, r, wd.text, fg, bg);
+				break;
+			}
+			case W_SLIDER: {
+				fill(d, r, wd.bg);
+				WidgetRect track = {(int16_t)(r.x + r.h / 2), (int16_t)(r.y + r.h / 2 - 1), (int16_t)(r.w - r.h), 3};
+				fill(d, track, wd.fg);
+				fill(d, knob(wd, wd.value), wd.fg);
+				break;
+			}
+			case W_PROGRESS: {
+				int16_t fw = fillWidth(wd, wd.value);
+				WidgetRect done = {r.x, r.y, fw, r.h}, left = {(int16_t)(r.x + fw), r.y, (int16_t)(r.w - fw), r.h};
+				fill(d, done, wd.fg);
+				fill(d, left, wd.bg);
+				break;
+			}
+			case W_NUMBER: {
+				char buf[WIDGET_TEXT + 1];
+				snprintf(buf, sizeof(buf), wd.text, (long)wd.value);
+				fill(d, r, wd.bg);
+				centerText(d, r, buf, wd.fg, wd.bg);
+				break;
+			}
+		}
+	}
+
+	Widget _w[N];
+	uint8_t _count;
+	HitGrid<WIDGET_GRID_WIDTH, WIDGET_GRID_HEIGHT, WIDGET_GRID_CELL, WIDGET_GRID_SLOTS> _grid;
+	WidgetRect _damage[WIDGET_MAX_DAMAGE];
+	uint8_t _ndamage;
+	int32_t _mergeWaste;
+};
+
+#endif
@@ -376,7 +376,7 @@ from 0 to 255
 ----- Bit 3,2,1,0 (Pattern Set No)
 If pattern Format = 8x8 then Pattern Set [3:0]
 If pattern Format = 16x16 then Pattern Set [1:0] is valid */
-#define RA8875_PTNO				  	  0x65//Pattern Set No for BTE
+#define RA8875_PTNO				  	  0x66//Pattern Set No for BTE
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //                            Color Registers
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -36,6 +36,7 @@
 #include "stm32l1xx_hal.h"
 
 /* USER CODE BEGIN 0 */
+#include "irq_priority.h"
 
 /* USER CODE END 0 */
 
@@ -50,11 +51,12 @@ void HAL_MspInit(void)
 
   __COMP_CLK_ENABLE();
 
-  HAL_NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_0);
+  // all bits preemption, with group 0 SysTick could never preempt the EXTI handlers
+  HAL_NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_4);
 
   /* System interrupt init*/
 /* SysTick_IRQn interrupt configuration */
-  HAL_NVIC_SetPriority(SysTick_IRQn, 0, 0);
+  HAL_NVIC_SetPriority(SysTick_IRQn, IRQ_PRIO_SYSTICK, 0);
 
   /* USER CODE BEGIN MspInit 1 */
 
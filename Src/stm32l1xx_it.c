@@ -36,6 +36,8 @@
 #include "stm32l1xx.h"
 #include "stm32l1xx_it.h"
 /* USER CODE BEGIN 0 */
+#include "DeferredWork.h"
+#include "Log.h"
 
 /* USER CODE END 0 */
 /* External variables --------------------------------------------------------*/
@@ -61,17 +63,47 @@ void SysTick_Handler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+* @brief This function handles Hard fault interrupt.
+*        Gets out whatever was logged before stopping.
+*/
+void HardFault_Handler(void)
+{
+    log_flush();
+    __asm volatile ("bkpt #0");
+    while(1);
+}
+
+/**
+* @brief This function handles USART1 global interrupt.
+*/
+void USART1_IRQHandler(void)
+{
+    log_tx_irq();
+}
+
+/**
+* @brief This function handles Pendable request for system service.
+*        Runs the deferred work queued by the ISRs at the lowest priority.
+*/
+void PendSV_Handler(void)
+{
+#if !WORK_RUN_IN_MAIN
+    work_run_pending();
+#endif
+}
+
 /**
 * @brief This function handles EXTI line1 interrupt.
 */
 void EXTI1_IRQHandler(void)
 {
     /* USER CODE BEGIN EXTI1_IRQn 0 */
-
+    WORK_ISR_ENTER();
     /* USER CODE END EXTI1_IRQn 0 */
     HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_1);
     /* USER CODE BEGIN EXTI1_IRQn 1 */
-
+    WORK_ISR_EXIT();
     /* USER CODE END EXTI1_IRQn 1 */
 }
 
@@ -81,11 +113,11 @@ void EXTI1_IRQHandler(void)
 void EXTI0_IRQHandler(void)
 {
     /* USER CODE BEGIN EXTI0_IRQn 0 */
-
+    WORK_ISR_ENTER();
     /* USER CODE END EXTI0_IRQn 0 */
     HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_0);
     /* USER CODE BEGIN EXTI0_IRQn 1 */
-
+    WORK_ISR_EXIT();
     /* USER CODE END EXTI0_IRQn 1 */
 }
 
@@ -0,0 +1,119 @@
+// Host build of the HAL header, found before the real one (-Ihal first).
+//
+// The real headers give the register structs, bit names and macros, the
+// core intrinsics are plain C here and the peripherals we touch are host
+// structs (hal_host.c) so the firmware modules run unchanged under test.
+
+#ifndef HOST_STM32L1XX_HAL_H
+#define HOST_STM32L1XX_HAL_H
+
+#include <stdint.h>
+
+// keep the Cortex-M inline asm out, provide the intrinsics instead
+#define __CORE_CMINSTR_H
+#define __CORE_CMFUNC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint32_t host_primask;
+extern uint32_t host_wfi_count;
+// a cycle of the host peripherals, oscillators become ready
+void host_cycle(void);
+
+static inline void __NOP(void) { host_cycle(); }
+static inline void __WFI(void) { host_wfi_count++; }
+static inline void __WFE(void) {}
+static inline void __SEV(void) {}
+static inline void __ISB(void) { __sync_synchronize(); }
+static inline void __DSB(void) { __sync_synchronize(); }
+static inline void __DMB(void) { __sync_synchronize(); }
+// single threaded, a reservation always succeeds
+static inline uint32_t __LDREXW(volatile uint32_t *p) { return *p; }
+static inline uint32_t __STREXW(uint32_t v, volatile uint32_t *p) { *p = v; return 0; }
+static inline void __CLREX(void) {}
+static inline uint32_t __RBIT(uint32_t v)
+{
+    uint32_t r = 0;
+    for (int i = 0; i < 32; i++, v >>= 1) r = (r << 1) | (v & 1);
+    return r;
+}
+static inline uint8_t __CLZ(uint32_t v) { return v ? __builtin_clz(v) : 32; }
+static inline uint32_t __REV(uint32_t v) { return __builtin_bswap32(v); }
+static inline void __disable_irq(void) { host_primask = 1; }
+static inline void __enable_irq(void) { host_primask = 0; }
+static inline uint32_t __get_PRIMASK(void) { return host_primask; }
+static inline void __set_PRIMASK(uint32_t m) { host_primask = m; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#include_next <stm32l1xx_hal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern USART_TypeDef host_USART1;
+extern SPI_TypeDef host_SPI1, host_SPI2;
+extern GPIO_TypeDef host_GPIOA, host_GPIOB;
+extern RCC_TypeDef host_RCC;
+extern PWR_TypeDef host_PWR;
+extern FLASH_TypeDef host_FLASH;
+extern RTC_TypeDef host_RTC;
+extern EXTI_TypeDef host_EXTI;
+extern SCB_Type host_SCB;
+extern SysTick_Type host_SysTick;
+extern DWT_Type host_DWT;
+extern CoreDebug_Type host_CoreDebug;
+extern volatile uint32_t host_USART1_TXEIE;
+
+#ifdef __cplusplus
+}
+#endif
+
+#undef USART1
+#define USART1 (&host_USART1)
+#undef SPI1
+#define SPI1 (&host_SPI1)
+#undef SPI2
+#define SPI2 (&host_SPI2)
+#undef GPIOA
+#define GPIOA (&host_GPIOA)
+#undef GPIOB
+#define GPIOB (&host_GPIOB)
+#undef RCC
+#define RCC (&host_RCC)
+#undef PWR
+#define PWR (&host_PWR)
+#undef FLASH
+#define FLASH (&host_FLASH)
+#undef RTC
+#define RTC (&host_RTC)
+#undef EXTI
+#define EXTI (&host_EXTI)
+#undef SCB
+#define SCB (&host_SCB)
+#undef SysTick
+#define SysTick (&host_SysTick)
+#undef DWT
+#define DWT (&host_DWT)
+#undef CoreDebug
+#define CoreDebug (&host_CoreDebug)
+
+// bit band aliases have no host address
+#undef __HAL_RCC_HSI_ENABLE
+#define __HAL_RCC_HSI_ENABLE() SET_BIT(RCC->CR, RCC_CR_HSION)
+#undef __HAL_RCC_HSI_DISABLE
+#define __HAL_RCC_HSI_DISABLE() CLEAR_BIT(RCC->CR, RCC_CR_HSION)
+#undef __HAL_RCC_MSI_ENABLE
+#define __HAL_RCC_MSI_ENABLE() SET_BIT(RCC->CR, RCC_CR_MSION)
+#undef __HAL_RCC_PLL_ENABLE
+#define __HAL_RCC_PLL_ENABLE() SET_BIT(RCC->CR, RCC_CR_PLLON)
+#undef __HAL_RCC_PLL_DISABLE
+#define __HAL_RCC_PLL_DISABLE() CLEAR_BIT(RCC->CR, RCC_CR_PLLON)
+#define USART1_TXEIE host_USART1_TXEIE
+
+#endif
@@ -0,0 +1,176 @@
+// Host peripherals and the HAL calls the firmware modules make, see
+// hal/stm32l1xx_hal.h. Tests set and inspect these directly.
+
+#include "stm32l1xx_hal.h"
+#include "hal_host.h"
+
+uint32_t host_primask;
+uint32_t host_wfi_count;
+
+USART_TypeDef host_USART1;
+SPI_TypeDef host_SPI1, host_SPI2;
+GPIO_TypeDef host_GPIOA, host_GPIOB;
+RCC_TypeDef host_RCC;
+PWR_TypeDef host_PWR;
+FLASH_TypeDef host_FLASH;
+RTC_TypeDef host_RTC;
+EXTI_TypeDef host_EXTI;
+SCB_Type host_SCB;
+SysTick_Type host_SysTick;
+DWT_Type host_DWT;
+CoreDebug_Type host_CoreDebug;
+volatile uint32_t host_USART1_TXEIE;
+
+uint32_t SystemCoreClock = 2097000;
+
+struct host_hal host_hal;
+
+void host_reset(void)
+{
+    memset(&host_hal, 0, sizeof(host_hal));
+    host_primask = 0;
+    host_wfi_count = 0;
+    memset(&host_USART1, 0, sizeof(host_USART1));
+    memset(&host_RCC, 0, sizeof(host_RCC));
+    memset(&host_PWR, 0, sizeof(host_PWR));
+    memset(&host_FLASH, 0, sizeof(host_FLASH));
+    memset(&host_SCB, 0, sizeof(host_SCB));
+    memset(&host_SysTick, 0, sizeof(host_SysTick));
+    memset(&host_DWT, 0, sizeof(host_DWT));
+    memset(&host_CoreDebug, 0, sizeof(host_CoreDebug));
+    host_USART1_TXEIE = 0;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt, uint32_t sub)
+{
+    (void)sub;
+    if(irq < 0) host_hal.core_prio[-irq] = preempt;
+    else host_hal.prio[irq] = preempt;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq)
+{
+    if(irq >= 0) host_hal.enabled[irq] = 1;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return host_hal.tick;
+}
+
+void HAL_IncTick(void)
+{
+    host_hal.tick++;
+}
+
+void HAL_SuspendTick(void)
+{
+    host_hal.tick_suspended = 1;
+}
+
+void HAL_ResumeTick(void)
+{
+    host_hal.tick_suspended = 0;
+}
+
+void HAL_PWR_EnterSLEEPMode(uint32_t regulator, uint8_t entry)
+{
+    (void)regulator; (void)entry;
+    host_hal.sleeps++;
+}
+
+void HAL_PWR_EnterSTOPMode(uint32_t regulator, uint8_t entry)
+{
+    (void)regulator; (void)entry;
+    host_hal.stops++;
+}
+
+// each oscillator that is on is ready a cycle later, unless it is dead
+void host_cycle(void)
+{
+    static const uint32_t rdy = RCC_CR_HSIRDY | RCC_CR_MSIRDY | RCC_CR_HSERDY | RCC_CR_PLLRDY;
+    uint32_t on = RCC->CR & (RCC_CR_HSION | RCC_CR_MSION | RCC_CR_HSEON | RCC_CR_PLLON);
+    RCC->CR = (RCC->CR & ~rdy) | ((on << 1) & ~host_hal.osc_dead);
+}
+
+// the clock tree as far as ClockProfile sees it: PLL is HSI*6/3. The HAL's
+// own ready waits are left out, they'd time out on a dead oscillator
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *osc)
+{
+    host_hal.osc_configs++;
+    if(osc->OscillatorType & RCC_OSCILLATORTYPE_HSI) SET_BIT(RCC->CR, RCC_CR_HSION);
+    if(osc->PLL.PLLState == RCC_PLL_ON) SET_BIT(RCC->CR, RCC_CR_PLLON);
+    if(osc->PLL.PLLState == RCC_PLL_OFF) CLEAR_BIT(RCC->CR, RCC_CR_PLLON);
+    host_cycle();
+    return HAL_OK;
+}
+
+// as the HAL, a source that isn't ready is refused
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *clk, uint32_t latency)
+{
+    static const uint32_t hz[] = { 2097000, 16000000, 0, 32000000 };
+    static const uint32_t ready[] = { RCC_CR_MSIRDY, RCC_CR_HSIRDY, RCC_CR_HSERDY, RCC_CR_PLLRDY };
+    host_hal.clock_configs++;
+    if((clk->ClockType & RCC_CLOCKTYPE_SYSCLK) && !(RCC->CR & ready[clk->SYSCLKSource])) return HAL_ERROR;
+    MODIFY_REG(FLASH->ACR, FLASH_ACR_LATENCY, latency);
+    if(clk->ClockType & RCC_CLOCKTYPE_SYSCLK) {
+        MODIFY_REG(RCC->CFGR, RCC_CFGR_SWS, clk->SYSCLKSource << 2);
+        SystemCoreClock = hz[clk->SYSCLKSource];
+    }
+    return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+    return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void)
+{
+    return SystemCoreClock;
+}
+
+HAL_StatusTypeDef HAL_InitTick(uint32_t prio)
+{
+    host_hal.tick_inits++;
+    host_hal.tick_hz = SystemCoreClock;
+    HAL_NVIC_SetPriority(SysTick_IRQn, prio, 0);
+    return HAL_OK;
+}
+
+void HAL_Delay(uint32_t ms)
+{
+    host_hal.tick += ms;
+}
+
+// SPI devices are modelled a byte at a time between the CS edges
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    if(state == GPIO_PIN_RESET) {
+        port->ODR &= ~pin;
+        if(host_hal.spi_select) host_hal.spi_select(port, pin);
+    }else{
+        port->ODR |= pin;
+    }
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *h, uint8_t *tx, uint8_t *rx, uint16_t len, uint32_t timeout)
+{
+    (void)h; (void)timeout;
+    host_hal.spi_calls++;
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t r = host_hal.spi_byte ? host_hal.spi_byte(tx[i]) : 0;
+        if(rx) rx[i] = r;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *h, uint8_t *tx, uint16_t len, uint32_t timeout)
+{
+    return HAL_SPI_TransmitReceive(h, tx, 0, len, timeout);
+}
@@ -0,0 +1,40 @@
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+// What the host HAL recorded, see hal_host.c
+
+#include <stdint.h>
+#include <string.h>
+
+#include "stm32l1xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct host_hal {
+    uint32_t tick;
+    uint8_t prio[64];      // by IRQn
+    uint8_t core_prio[16]; // by -IRQn, eg PendSV
+    uint8_t enabled[64];
+    uint8_t tick_suspended;
+    uint32_t sleeps, stops;
+    uint32_t osc_configs, clock_configs;
+    uint32_t osc_dead; // RCC_CR_xxxRDY of oscillators that never start
+    uint32_t tick_inits, tick_hz; // HCLK SysTick was last set up for
+    // SPI device model: a CS going low, then each byte in, what it answers
+    void (*spi_select)(GPIO_TypeDef *port, uint16_t pin);
+    uint8_t (*spi_byte)(uint8_t tx);
+    uint32_t spi_calls; // HAL_SPI_Transmit/TransmitReceive
+};
+
+extern struct host_hal host_hal;
+
+// everything back to reset values
+void host_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,276 @@
+#ifndef RA8875_MODEL_H
+#define RA8875_MODEL_H
+
+// The RA8875 as seen from the SPI: registers that keep what is written,
+// drawing that is done at once, and counts of what the driver sent.
+// Build the driver with RA8875_FAST_SPI=0 so it all goes through the HAL.
+
+#include "hal_host.h"
+#include "RA8875.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct RA8875Model {
+	uint8_t reg[256];
+	uint32_t writes[256];	// data writes per register
+	uint32_t transactions;	// CS low
+	uint32_t bytes;			// all bytes on the bus
+	uint32_t reads;			// register reads
+	uint32_t status;		// status reads
+	uint32_t pixelBytes;	// data bytes into MRWC
+	// the last register writes, oldest first
+	struct { uint8_t reg, val; } log[512];
+	uint16_t nlog;
+	// the BTE operations started, as programmed
+	struct Bte {
+		uint16_t sx, sy, dx, dy, w, h;
+		uint8_t srcLayer, dstLayer, becr1, ptno;
+		uint32_t status;	// status reads before it started
+	} bte[16];
+	uint8_t nbte;
+	// shapes the drawing engine started, as programmed
+	struct Draw {
+		uint8_t dcr;
+		uint16_t x0, y0, x1, y1, r;	// circle center in x0,y0
+		uint16_t color;			// 16bpp
+	} draws[64];
+	uint8_t ndraws;
+	// characters written in text mode, 8x16 cells of the internal font
+	char text[30][100];
+	// graphic cursor and CGRAM, written from the start by each memory write
+	uint8_t cursor[8][256];
+	uint8_t cgram[256][16];
+	uint16_t memAt;
+
+	uint8_t pixelHi;	// first byte of a 16bpp pixel, pixelPhase set
+	uint8_t pixelPhase;
+	uint8_t cur;	// register selected by the last command
+	uint8_t mode;	// cycle type byte, 0xFF when the next byte is one
+};
+
+static RA8875Model ra;
+// pixels drawn by lines, rectangles and memory writes, in the active window
+static uint16_t ra_fb[480][800];
+
+static void ra_select(GPIO_TypeDef *port, uint16_t pin)
+{
+	(void)port; (void)pin;
+	ra.transactions++;
+	ra.mode = 0xFF;
+}
+
+static uint16_t ra_reg16(uint8_t r)
+{
+	return ra.reg[r] | ra.reg[r + 1] << 8;
+}
+
+// a character at the text cursor, which moves on by a cell; a character
+// that doesn't fit goes to the start of the next line of the active window
+static void ra_char(uint8_t c)
+{
+	uint16_t x = ra_reg16(RA8875_F_CURXL), y = ra_reg16(RA8875_F_CURYL);
+	if (x + 8 > ra_reg16(RA8875_HEAW0) + 1) {
+		x = ra_reg16(RA8875_HSAW0);
+		y += 16;
+		ra.reg[RA8875_F_CURYL] = y;
+		ra.reg[RA8875_F_CURYH] = y >> 8;
+	}
+	if (x / 8 < 100 && y / 16 < 30) ra.text[y / 16][x / 8] = c;
+	x += 8;
+	ra.reg[RA8875_F_CURXL] = x;
+	ra.reg[RA8875_F_CURXH] = x >> 8;
+}
+
+// a filled rectangle clears the characters under it
+static void ra_fill(void)
+{
+	uint16_t x0 = ra_reg16(RA8875_DLHSR0), y0 = ra_reg16(RA8875_DLVSR0);
+	uint16_t x1 = ra_reg16(RA8875_DLHER0), y1 = ra_reg16(RA8875_DLVER0);
+	for (uint16_t r = y0 / 16; r <= y1 / 16 && r < 30; r++) {
+		for (uint16_t c = x0 / 8; c <= x1 / 8 && c < 100; c++) ra.text[r][c] = 0;
+	}
+}
+
+static void ra_bte(void)
+{
+	if (ra.nbte == sizeof(ra.bte) / sizeof(ra.bte[0])) return;
+	RA8875Model::Bte &b = ra.bte[ra.nbte++];
+	b.sx = ra_reg16(RA8875_HSBE0);
+	b.sy = ra_reg16(RA8875_VSBE0) & 0x7FFF;
+	b.srcLayer = ra.reg[RA8875_VSBE1] >> 7;
+	b.dx = ra_reg16(RA8875_HDBE0);
+	b.dy = ra_reg16(RA8875_VDBE0) & 0x7FFF;
+	b.dstLayer = ra.reg[RA8875_VDBE1] >> 7;
+	b.w = ra_reg16(RA8875_BEWR0);
+	b.h = ra_reg16(RA8875_BEHR0);
+	b.becr1 = ra.reg[RA8875_BECR1];
+	b.ptno = ra.reg[RA8875_PTNO];
+	b.status = ra.status;
+}
+
+static uint16_t ra_fg(void)
+{
+	return ra.reg[RA8875_FGCR0] << 11 | ra.reg[RA8875_FGCR1] << 5 | ra.reg[RA8875_FGCR2];
+}
+
+static void ra_draw(uint8_t dcr)
+{
+	if (ra.ndraws == sizeof(ra.draws) / sizeof(ra.draws[0])) return;
+	RA8875Model::Draw &d = ra.draws[ra.ndraws++];
+	d.dcr = dcr;
+	if (dcr & RA8875_DCR_CIRCLE_START) {
+		d.x0 = ra_reg16(RA8875_DCHR0);
+		d.y0 = ra_reg16(RA8875_DCVR0);
+		d.r = ra.reg[RA8875_DCRR];
+		d.x1 = d.y1 = 0;
+	} else {
+		d.x0 = ra_reg16(RA8875_DLHSR0);
+		d.y0 = ra_reg16(RA8875_DLVSR0);
+		d.x1 = ra_reg16(RA8875_DLHER0);
+		d.y1 = ra_reg16(RA8875_DLVER0);
+		d.r = 0;
+	}
+	d.color = ra_fg();
+}
+
+static void ra_plot(int x, int y, uint16_t c)
+{
+	if (x < ra_reg16(RA8875_HSAW0) || x > ra_reg16(RA8875_HEAW0)) return;
+	if (y < ra_reg16(RA8875_VSAW0) || y > ra_reg16(RA8875_VEAW0)) return;
+	if (x < 800 && y < 480) ra_fb[y][x] = c;
+}
+
+// a line or rectangle of the drawing engine, lines by Bresenham
+static void ra_raster(uint8_t dcr)
+{
+	int x0 = ra_reg16(RA8875_DLHSR0), y0 = ra_reg16(RA8875_DLVSR0);
+	int x1 = ra_reg16(RA8875_DLHER0), y1 = ra_reg16(RA8875_DLVER0);
+	uint16_t c = ra_fg();
+	if (dcr & 0x10) {
+		bool fill = dcr & 0x20;
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				if (fill || x == x0 || x == x1 || y == y0 || y == y1) ra_plot(x, y, c);
+			}
+		}
+		return;
+	}
+	int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+	int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+	int e = dx + dy;
+	for (;;) {
+		ra_plot(x0, y0, c);
+		if (x0 == x1 && y0 == y1) break;
+		int e2 = 2 * e;
+		if (e2 >= dy) { e += dy; x0 += sx; }
+		if (e2 <= dx) { e += dx; y0 += sy; }
+	}
+}
+
+// a graphic memory write at the memory cursor, which moves on in the active window
+static void ra_pixel(uint8_t b)
+{
+	uint16_t c;
+	if ((ra.reg[RA8875_SYSR] & 0x0C) == 0) {
+		c = b;
+	} else if (!ra.pixelPhase) {
+		ra.pixelHi = b;
+		ra.pixelPhase = 1;
+		return;
+	} else {
+		c = ra.pixelHi << 8 | b;
+		ra.pixelPhase = 0;
+	}
+	uint16_t x = ra_reg16(RA8875_CURH0), y = ra_reg16(RA8875_CURV0);
+	ra_plot(x, y, c);
+	if (++x > ra_reg16(RA8875_HEAW0)) {//next row of the active window
+		x = ra_reg16(RA8875_HSAW0);
+		y++;
+		ra.reg[RA8875_CURV0] = y;
+		ra.reg[RA8875_CURV1] = y >> 8;
+	}
+	ra.reg[RA8875_CURH0] = x;
+	ra.reg[RA8875_CURH1] = x >> 8;
+}
+
+static uint8_t ra_byte(uint8_t tx)
+{
+	ra.bytes++;
+	if (ra.mode == 0xFF) {
+		ra.mode = tx;
+		if (tx == RA8875_DATAREAD) ra.reads++;
+		if (tx == RA8875_CMDREAD) ra.status++;
+		return 0;
+	}
+	switch (ra.mode) {
+	case RA8875_CMDWRITE:
+		ra.cur = tx;
+		ra.pixelPhase = 0;
+		if (tx == RA8875_MRWC) ra.memAt = 0;
+		ra.mode = 0xFF; // a data cycle may follow in the same transaction
+		break;
+	case RA8875_DATAWRITE:
+		ra.writes[ra.cur]++;
+		if (ra.cur == RA8875_MRWC) {
+			ra.pixelBytes++;
+			if (ra.reg[RA8875_MWCR0] & 0x80) ra_char(tx);
+			else if ((ra.reg[RA8875_MWCR1] & 0x0C) == 0) ra_pixel(tx);
+			else if ((ra.reg[RA8875_MWCR1] & 0x0C) == 0x08) ra.cursor[(ra.reg[RA8875_MWCR1] >> 4) & 7][ra.memAt++ & 0xFF] = tx;
+			else if ((ra.reg[RA8875_MWCR1] & 0x0C) == 0x04) ra.cgram[ra.reg[RA8875_CGSR]][ra.memAt++ & 0x0F] = tx;
+			break;
+		}
+		// drawing, clears and BTE are done as soon as they start
+		if (ra.cur == RA8875_DCR) {
+			if ((tx & 0xB1) == 0xB0) ra_fill();
+			if (tx & 0xC0) ra_draw(tx);
+			if ((tx & 0x81) == 0x80) ra_raster(tx);
+			tx &= ~0xC0;
+		}
+		if (ra.cur == RA8875_BECR0 && (tx & 0x80)) ra_bte();
+		if (ra.cur == RA8875_ELLIPSE || ra.cur == RA8875_BECR0 || ra.cur == RA8875_MCLR) tx &= ~0x80;
+		ra.reg[ra.cur] = tx;
+		if (ra.nlog < sizeof(ra.log) / sizeof(ra.log[0])) {
+			ra.log[ra.nlog].reg = ra.cur;
+			ra.log[ra.nlog].val = tx;
+			ra.nlog++;
+		}
+		break;
+	case RA8875_DATAREAD:
+		return ra.reg[ra.cur];
+	case RA8875_CMDREAD:
+		return 0; // never busy
+	}
+	return 0;
+}
+
+// start over, counts and registers cleared
+static inline void ra_reset(void)
+{
+	memset(&ra, 0, sizeof(ra));
+	memset(ra_fb, 0, sizeof(ra_fb));
+	ra.mode = 0xFF;
+	host_hal.spi_select = ra_select;
+	host_hal.spi_byte = ra_byte;
+}
+
+// counts cleared, registers kept, to measure one operation
+static inline void ra_count(void)
+{
+	memset(ra.writes, 0, sizeof(ra.writes));
+	ra.transactions = ra.bytes = ra.reads = ra.status = ra.pixelBytes = 0;
+	ra.nlog = 0;
+	ra.nbte = 0;
+	ra.ndraws = 0;
+}
+
+// index of the first write of v to r in the log from i on, -1 if none
+static inline int ra_find(uint8_t r, uint8_t v, int i = 0)
+{
+	for (; i < ra.nlog; i++) {
+		if (ra.log[i].reg == r && ra.log[i].val == v) return i;
+	}
+	return -1;
+}
+
+#endif
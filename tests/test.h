@@ -0,0 +1,31 @@
+#ifndef TEST_H
+#define TEST_H
+
+// Minimal checks for the host tests, a failing CHECK prints where and
+// makes the test exit non zero through TEST_END.
+
+#include <stdio.h>
+
+static int test_failures;
+
+#define CHECK(c) do { \
+    if(!(c)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); \
+        test_failures++; \
+    } \
+} while(0)
+
+#define CHECK_EQ(a, b) do { \
+    long long _a = (long long)(a), _b = (long long)(b); \
+    if(_a != _b) { \
+        printf("%s:%d: %s == %s failed, %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+        test_failures++; \
+    } \
+} while(0)
+
+#define TEST_END() do { \
+    printf("%s: %s\n", __FILE__, test_failures ? "FAILED" : "ok"); \
+    return test_failures ? 1 : 0; \
+} while(0)
+
+#endif
@@ -0,0 +1,107 @@
+// fillCircles/fillRects against the per call path onto the RA8875 model:
+// the same shapes drawn, for a fraction of the bytes
+
+#include "ra8875_model.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+static SPI_HandleTypeDef hspi;
+static RA8875T<Panel800x480> d(&hspi, GPIOA, GPIO_PIN_4);
+
+static const uint16_t colors[5] = {RA8875_RED, RA8875_GREEN, RA8875_BLUE, RA8875_YELLOW, RA8875_WHITE};
+
+static int by_shape(const void *a, const void *b)
+{
+	const RA8875Model::Draw *p = (const RA8875Model::Draw *)a, *q = (const RA8875Model::Draw *)b;
+	if (p->color != q->color) return p->color - q->color;
+	if (p->x0 != q->x0) return p->x0 - q->x0;
+	if (p->y0 != q->y0) return p->y0 - q->y0;
+	if (p->x1 != q->x1) return p->x1 - q->x1;
+	return p->y1 - q->y1;
+}
+
+// the shapes drawn since ra_count, in a canonical order
+struct Shapes {
+	uint8_t n;
+	RA8875Model::Draw d[64];
+};
+
+static void keep(Shapes &s)
+{
+	s.n = ra.ndraws;
+	memcpy(s.d, ra.draws, sizeof(s.d));
+	qsort(s.d, s.n, sizeof(s.d[0]), by_shape);
+}
+
+static bool same(const Shapes &a, const Shapes &b)
+{
+	if (a.n != b.n) return false;
+	for (int i = 0; i < a.n; i++) {
+		if (a.d[i].dcr != b.d[i].dcr || by_shape(&a.d[i], &b.d[i]) != 0 || a.d[i].r != b.d[i].r) return false;
+	}
+	return true;
+}
+
+static Shapes one, batch;
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+
+	// five fingers painting, 8 reports of 20 pixel dots
+	RA8875circle dots[40];
+	int n = 0;
+	for (int e = 0; e < 8; e++) {
+		for (int f = 0; f < 5; f++) dots[n++] = {(int16_t)(100 + f * 120 + e * 3), (int16_t)(200 + e * 2), 20, colors[f]};
+	}
+
+	ra_count();
+	for (int i = 0; i < n; i++) d.fillCircle(dots[i].x, dots[i].y, dots[i].r, dots[i].color);
+	keep(one);
+	uint32_t bytes = ra.bytes, transactions = ra.transactions;
+
+	ra_count();
+	d.fillCircles(dots, n);
+	keep(batch);
+	CHECK_EQ(one.n, 40);
+	CHECK(same(one, batch));
+	// a color is set once, the center moves, the radius stays
+	CHECK_EQ(ra.writes[RA8875_FGCR0], 5);
+	CHECK_EQ(ra.writes[RA8875_DCRR], 1);
+	printf("40 circles: per call %lu bytes in %lu transactions, batched %lu bytes in %lu transactions\n",
+		(unsigned long)bytes, (unsigned long)transactions, (unsigned long)ra.bytes, (unsigned long)ra.transactions);
+	CHECK(ra.bytes * 2 < bytes);
+
+	// shared color
+	ra_count();
+	d.fillCircles(dots, 5, RA8875_CYAN);
+	CHECK_EQ(ra.ndraws, 5);
+	for (int i = 0; i < 5; i++) CHECK_EQ(ra.draws[i].color, RA8875_CYAN);
+	CHECK_EQ(ra.writes[RA8875_FGCR0], 1);
+
+	// off screen ones are dropped
+	RA8875circle off[2] = {{-50, -50, 20, RA8875_RED}, {100, 100, 20, RA8875_RED}};
+	ra_count();
+	d.fillCircles(off, 2);
+	CHECK_EQ(ra.ndraws, 1);
+
+	// rects
+	RA8875rect rects[20];
+	for (int i = 0; i < 20; i++) rects[i] = {(int16_t)(10 + i * 30), (int16_t)(300 + (i & 3) * 10), 20, 20, colors[i % 3]};
+	ra_count();
+	for (int i = 0; i < 20; i++) d.fillRect(rects[i].x, rects[i].y, rects[i].w, rects[i].h, rects[i].color);
+	keep(one);
+	bytes = ra.bytes;
+	ra_count();
+	d.fillRects(rects, 20);
+	keep(batch);
+	CHECK(same(one, batch));
+	CHECK_EQ(ra.writes[RA8875_FGCR0], 3);
+	printf("20 rects: per call %lu bytes, batched %lu bytes\n", (unsigned long)bytes, (unsigned long)ra.bytes);
+	CHECK(ra.bytes < bytes);
+
+	TEST_END();
+}
@@ -0,0 +1,116 @@
+// The BTE operations onto the RA8875 model: the registers each one
+// programs, the clipping, and that a BTE is only waited for by the next one
+
+#include "ra8875_model.h"
+#include "test.h"
+
+static SPI_HandleTypeDef hspi;
+static RA8875T<Panel800x480> d(&hspi, GPIOA, GPIO_PIN_4);
+
+static void check_bte(int i, int sx, int sy, int dx, int dy, int w, int h, int becr1)
+{
+	const RA8875Model::Bte &b = ra.bte[i];
+	CHECK_EQ(b.sx, sx);
+	CHECK_EQ(b.sy, sy);
+	CHECK_EQ(b.dx, dx);
+	CHECK_EQ(b.dy, dy);
+	CHECK_EQ(b.w, w);
+	CHECK_EQ(b.h, h);
+	CHECK_EQ(b.becr1, becr1);
+}
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+
+	// up and left: forward from the top left
+	ra_count();
+	d.copyRect(100, 200, 10, 20, 50, 40);
+	CHECK_EQ(ra.nbte, 1);
+	check_bte(0, 100, 200, 10, 20, 50, 40, (ROP_S << 4) | 0x02);
+	CHECK_EQ(ra.bte[0].srcLayer, 0);
+	CHECK_EQ(ra.bte[0].dstLayer, 0);
+	// started, not waited for
+	CHECK_EQ(ra.status, 0);
+	printf("copyRect: %lu transactions, %lu bytes\n", (unsigned long)ra.transactions, (unsigned long)ra.bytes);
+
+	// panning right over itself: backwards from the bottom right, after
+	// waiting for the one before
+	d.copyRect(0, 0, 10, 0, 100, 50);
+	CHECK_EQ(ra.nbte, 2);
+	check_bte(1, 99, 49, 109, 49, 100, 50, (ROP_S << 4) | 0x03);
+	CHECK_EQ(ra.bte[1].status, 1);
+
+	// ROP codes
+	ra_count();
+	d.copyRect(0, 0, 0, 100, 8, 8, ROP_XOR);
+	CHECK_EQ(ra.bte[0].becr1, (ROP_XOR << 4) | 0x03);
+
+	// between layers
+	ra_count();
+	d.copyRect(1, 0, 0, 0, 0, 0, 8, 8);
+	CHECK_EQ(ra.bte[0].srcLayer, 1);
+	CHECK_EQ(ra.bte[0].dstLayer, 0);
+	check_bte(0, 0, 0, 0, 0, 8, 8, (ROP_S << 4) | 0x02);
+
+	// clipped: the source to the screen, the destination to the clip rect
+	ra_count();
+	d.copyRect(-10, 300, 0, 0, 50, 10);
+	check_bte(0, 0, 300, 10, 0, 40, 10, (ROP_S << 4) | 0x02);
+	d.copyRect(0, 0, 790, 300, 50, 10);
+	CHECK_EQ(ra.bte[1].w, 10);
+	d.setClipRect(0, 0, 400, 400);
+	d.copyRect(0, 0, 380, 390, 50, 50);
+	CHECK_EQ(ra.bte[2].w, 20);
+	CHECK_EQ(ra.bte[2].h, 10);
+	// nothing left, nothing sent
+	ra_count();
+	d.copyRect(0, 0, 500, 0, 50, 50);
+	CHECK_EQ(ra.nbte, 0);
+	d.clearClipRect();
+
+	// transparent copy with the key color
+	ra_count();
+	d.setTrasparentColor(RA8875_MAGENTA);
+	CHECK_EQ(ra.reg[RA8875_BGTR0], 0x1F);
+	CHECK_EQ(ra.reg[RA8875_BGTR1], 0);
+	CHECK_EQ(ra.reg[RA8875_BGTR2], 0x1F);
+	d.stampRect(1, 0, 0, 0, 200, 100, 32, 16);
+	check_bte(0, 0, 0, 200, 100, 32, 16, (ROP_S << 4) | 0x05);
+
+	// a move fills the part it uncovers
+	ra_count();
+	d.moveRect(0, 0, 10, 0, 100, 50, RA8875_BLUE);
+	CHECK_EQ(ra.nbte, 2);
+	check_bte(1, 0, 0, 0, 0, 10, 50, (ROP_S << 4) | 0x0C);
+	CHECK_EQ(ra.reg[RA8875_FGCR2], 0x1F);
+
+	// a solid fill doesn't wait for its end
+	ra_count();
+	d.solidFill(0, 0, 800, 480, RA8875_BLACK);
+	check_bte(0, 0, 0, 0, 0, 800, 480, (ROP_S << 4) | 0x0C);
+
+	// patterns: 64 pixels into the pattern RAM, then tiled by number
+	uint16_t px[64];
+	for (int i = 0; i < 64; i++) px[i] = i & 1 ? RA8875_WHITE : RA8875_BLACK;
+	ra_count();
+	d.uploadPattern(3, px);
+	CHECK_EQ(ra.pixelBytes, 128);
+	CHECK_EQ(ra.reg[RA8875_PTNO], 3);
+	CHECK_EQ(ra.reg[RA8875_MWCR1] & 0x0C, 0);	// back to the layer
+	d.patternFill(16, 16, 64, 64, 3, ROP_AND);
+	check_bte(0, 0, 0, 16, 16, 64, 64, (ROP_AND << 4) | 0x06);
+	CHECK_EQ(ra.bte[0].ptno, 3);
+	d.patternStamp(16, 16, 64, 64, 5);
+	check_bte(1, 0, 0, 16, 16, 64, 64, (ROP_S << 4) | 0x07);
+	CHECK_EQ(ra.bte[1].ptno, 5);
+
+	// a drawing waits for a BTE still running
+	ra_count();
+	d.fillRect(0, 0, 10, 10, RA8875_RED);
+	CHECK(ra.status >= 1);
+
+	TEST_END();
+}
@@ -0,0 +1,172 @@
+// Clipping onto the RA8875 model, against reference rasterizers: the
+// software ellipse and triangle for shapes the engine can't take, lines
+// clipped by Cohen-Sutherland, and shapes off the clip rect cost nothing
+
+#include "ra8875_model.h"
+#include "test.h"
+
+#include <math.h>
+
+static SPI_HandleTypeDef hspi;
+static RA8875T<Panel800x480> d(&hspi, GPIOA, GPIO_PIN_4);
+
+static const uint16_t C = RA8875_WHITE;
+
+static uint32_t rnd_state = 1;
+static int rnd(int lo, int hi)
+{
+	rnd_state = rnd_state * 1103515245 + 12345;
+	return lo + (int)((rnd_state >> 8) % (uint32_t)(hi - lo + 1));
+}
+
+// pixels of the screen that differ from a reference, away from its edge
+// where the two may round differently; in(x, y) is the reference, band(x, y)
+// true near its edge
+template<class In, class Band>
+static int wrong(In in, Band band)
+{
+	int n = 0;
+	for (int y = 0; y < 480; y++) {
+		for (int x = 0; x < 800; x++) {
+			if ((ra_fb[y][x] == C) != in(x, y) && !band(x, y)) n++;
+		}
+	}
+	return n;
+}
+
+static int filled(void)
+{
+	int n = 0;
+	for (int y = 0; y < 480; y++) for (int x = 0; x < 800; x++) n += ra_fb[y][x] == C;
+	return n;
+}
+
+static void ellipse(int xc, int yc, int a, int b)
+{
+	memset(ra_fb, 0, sizeof(ra_fb));
+	if (a == b) d.fillCircle(xc, yc, a, C);
+	else d.fillEllipse(xc, yc, a, b, C);
+	double a2 = (double)a * a, b2 = (double)b * b;
+	auto v = [=](int x, int y) { return (x - xc) * (x - xc) / a2 + (y - yc) * (y - yc) / b2; };
+	int n = wrong([=](int x, int y) { return v(x, y) <= 1.0; },
+		[=](int x, int y) { double e = v(x, y); return e > 0.85 && e < 1.25; });
+	if (n) printf("ellipse %d,%d %dx%d: %d pixels wrong\n", xc, yc, a, b, n);
+	CHECK_EQ(n, 0);
+}
+
+// signed distance of x,y from the line a-b, positive on the left
+static double side(double ax, double ay, double bx, double by, double x, double y)
+{
+	double l = hypot(bx - ax, by - ay);
+	return l == 0 ? 0 : ((bx - ax) * (y - ay) - (by - ay) * (x - ax)) / l;
+}
+
+static void triangle(int x0, int y0, int x1, int y1, int x2, int y2)
+{
+	memset(ra_fb, 0, sizeof(ra_fb));
+	d.fillTriangle(x0, y0, x1, y1, x2, y2, C);
+	double s = side(x0, y0, x1, y1, x2, y2) < 0 ? -1 : 1;
+	auto in = [=](int x, int y) {
+		return s * side(x0, y0, x1, y1, x, y) >= 0 && s * side(x1, y1, x2, y2, x, y) >= 0 && s * side(x2, y2, x0, y0, x, y) >= 0;
+	};
+	auto band = [=](int x, int y) {
+		return fabs(side(x0, y0, x1, y1, x, y)) < 1.5 || fabs(side(x1, y1, x2, y2, x, y)) < 1.5 ||
+			fabs(side(x2, y2, x0, y0, x, y)) < 1.5;
+	};
+	int n = wrong(in, band);
+	if (n) printf("triangle %d,%d %d,%d %d,%d: %d pixels wrong\n", x0, y0, x1, y1, x2, y2, n);
+	CHECK_EQ(n, 0);
+}
+
+// the drawn part of a line from far outside: on screen, close to the line,
+// and there if the line crosses the screen
+static void line(int x0, int y0, int x1, int y1)
+{
+	memset(ra_fb, 0, sizeof(ra_fb));
+	ra_count();
+	d.drawLine(x0, y0, x1, y1, C);
+	int n = 0, off = 0;
+	for (int y = 0; y < 480; y++) {
+		for (int x = 0; x < 800; x++) {
+			if (ra_fb[y][x] != C) continue;
+			n++;
+			if (fabs(side(x0, y0, x1, y1, x, y)) > 1.5) off++;
+		}
+	}
+	// the reference: points of the segment that are on screen
+	int on = 0;
+	for (int i = 0; i <= 4000; i++) {
+		double x = x0 + (x1 - x0) * i / 4000.0, y = y0 + (y1 - y0) * i / 4000.0;
+		if (x >= 1 && x <= 798 && y >= 1 && y <= 478) on++;
+	}
+	if (off) printf("line %d,%d %d,%d: %d of %d pixels off the line\n", x0, y0, x1, y1, off, n);
+	CHECK_EQ(off, 0);
+	if (on > 0) CHECK(n > 0);
+	if (n == 0) CHECK_EQ(ra.bytes, 0);
+}
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+
+	// centers the engine can't take: off screen, or a radius over 255
+	ellipse(-10, 50, 40, 30);
+	ellipse(790, -20, 60, 45);
+	ellipse(400, 240, 300, 300);
+	ellipse(-200, 240, 260, 250);
+	for (int k = 0; k < 20; k++) ellipse(rnd(-150, -1), rnd(-100, 580), rnd(1, 200), rnd(1, 200));
+	// radii past 32 bit intermediates, a center far off screen
+	ellipse(-1500, 240, 2000, 2000);
+	ellipse(-20000, 240, 20300, 400);
+	ellipse(400, -30000, 600, 30200);
+
+	// triangles with a corner the engine can't take
+	triangle(-50, 10, 100, 200, 300, -40);
+	triangle(10, 10, 1100, 240, 10, 470);
+	triangle(-30000, -30000, 30000, 240, -30000, 30000);
+	for (int k = 0; k < 50; k++) triangle(rnd(-300, -1), rnd(-200, 680), rnd(-300, 1100), rnd(-200, 680), rnd(-300, 1100), rnd(-200, 680));
+
+	// lines from far away
+	line(-1000, -1000, 2000, 1500);
+	line(-500, 240, 1500, 240);
+	line(400, -3000, 400, 3000);
+	line(-100, 600, 900, -100);
+	for (int k = 0; k < 200; k++) line(rnd(-2000, 2800), rnd(-2000, 2500), rnd(-2000, 2800), rnd(-2000, 2500));
+
+	// completely outside the clip rect: nothing sent
+	ra_count();
+	d.fillCircle(-100, -100, 20, C);
+	d.fillEllipse(1000, 200, 100, 50, C);
+	d.fillTriangle(-10, -10, -50, -90, -30, -5, C);
+	d.fillRect(900, 0, 50, 50, C);
+	d.drawLine(-10, -10, -100, 500, C);
+	CHECK_EQ(ra.bytes, 0);
+
+	// a clip rect: rects intersect it, the active window brackets the engine
+	d.setClipRect(100, 100, 200, 100);
+	CHECK_EQ(ra_reg16(RA8875_HSAW0), 100);
+	CHECK_EQ(ra_reg16(RA8875_HEAW0), 299);
+	CHECK_EQ(ra_reg16(RA8875_VSAW0), 100);
+	CHECK_EQ(ra_reg16(RA8875_VEAW0), 199);
+	memset(ra_fb, 0, sizeof(ra_fb));
+	ra_count();
+	d.fillRect(50, 150, 100, 100, C);
+	CHECK_EQ(ra_reg16(RA8875_DLHSR0), 100);
+	CHECK_EQ(ra_reg16(RA8875_DLVER0), 199);
+	CHECK_EQ(filled(), 51 * 50);
+	// an outline across the edge is its visible sides
+	memset(ra_fb, 0, sizeof(ra_fb));
+	d.drawRect(250, 150, 100, 20, C);
+	CHECK_EQ(filled(), 50 * 2 + 21 - 2);
+	// a circle half in is drawn by the engine where it is, the window clips it
+	ra_count();
+	d.fillCircle(100, 150, 30, C);
+	CHECK_EQ(ra.ndraws, 1);
+	CHECK_EQ(ra.draws[0].x0, 100);
+	d.clearClipRect();
+	CHECK_EQ(ra_reg16(RA8875_HEAW0), 799);
+
+	TEST_END();
+}
@@ -0,0 +1,156 @@
+// ClockProfile: wait state and prescaler tables, and what a switch leaves
+// behind in the core and the bus peripherals
+
+#include "stm32l1xx_hal.h"
+#include "hal_host.h"
+#include "ClockProfile.h"
+#include "irq_priority.h"
+#include "test.h"
+
+I2C_HandleTypeDef hi2c1, hi2c2;
+SPI_HandleTypeDef hspi1, hspi2;
+UART_HandleTypeDef huart1;
+static I2C_TypeDef i2c1_regs;
+
+static uint32_t spi_hz(uint32_t pclk, uint32_t br)
+{
+    return pclk >> ((br >> 3) + 1);
+}
+
+int main(void)
+{
+    // RM0038 table 13
+    CHECK_EQ(clock_flash_latency(1, 16000000), 0);
+    CHECK_EQ(clock_flash_latency(1, 16000001), 1);
+    CHECK_EQ(clock_flash_latency(1, 32000000), 1);
+    CHECK_EQ(clock_flash_latency(1, 32000001), -1);
+    CHECK_EQ(clock_flash_latency(2, 8000000), 0);
+    CHECK_EQ(clock_flash_latency(2, 16000000), 1);
+    CHECK_EQ(clock_flash_latency(2, 16000001), -1);
+    CHECK_EQ(clock_flash_latency(3, 2097000), 0);
+    CHECK_EQ(clock_flash_latency(3, 4200000), 1);
+    CHECK_EQ(clock_flash_latency(3, 4200001), -1);
+    CHECK_EQ(clock_flash_latency(0, 1000), -1);
+    CHECK_EQ(clock_flash_latency(4, 1000), -1);
+    // every profile is within its voltage range
+    for (int i = 0; i < CLOCK_NPROFILES; i++) {
+        CHECK(clock_flash_latency(clock_profiles[i].vrange, clock_profiles[i].sysclk_hz) >= 0);
+    }
+
+    // the fastest SPI clock not above the limit, whatever the bus clock
+    for (uint32_t pclk = 1000000; pclk <= 32000000; pclk += 97000) {
+        for (uint32_t max = 100000; max <= 16000000; max *= 2) {
+            uint32_t br = clock_spi_prescaler(pclk, max);
+            CHECK((br & ~SPI_CR1_BR) == 0);
+            if(br != SPI_BAUDRATEPRESCALER_256) CHECK(spi_hz(pclk, br) <= max);
+            if(br != SPI_BAUDRATEPRESCALER_2) CHECK(spi_hz(pclk, br - (1 << 3)) > max);
+        }
+    }
+    CHECK_EQ(clock_spi_prescaler(32000000, 8000000), SPI_BAUDRATEPRESCALER_4);
+    CHECK_EQ(clock_spi_prescaler(2097000, 8000000), SPI_BAUDRATEPRESCALER_2);
+    CHECK_EQ(clock_spi_prescaler(16000000, 4000000), SPI_BAUDRATEPRESCALER_4);
+
+    // switches, with the peripherals up and running
+    host_reset();
+    hspi1.Instance = SPI1;
+    hspi1.State = HAL_SPI_STATE_READY;
+    SPI1->CR1 = SPI_CR1_SPE | SPI_CR1_MSTR;
+    hspi2.Instance = SPI2;
+    hspi2.State = HAL_SPI_STATE_READY; // configured but not enabled
+    hi2c1.Instance = &i2c1_regs;
+    hi2c1.State = HAL_I2C_STATE_READY;
+    hi2c1.Init.ClockSpeed = 100000;
+    i2c1_regs.CR1 = I2C_CR1_PE;
+    huart1.Instance = USART1;
+    huart1.State = HAL_UART_STATE_READY;
+    huart1.Init.BaudRate = 115200;
+    USART1->SR = USART_SR_TC;
+
+    clock_init(CLOCK_IDLE);
+    CHECK_EQ(clock_current(), CLOCK_IDLE);
+    CHECK_EQ(SystemCoreClock, 2097000);
+    CHECK_EQ(__get_PRIMASK(), 0);
+
+    clock_request(CLOCK_INTERACTIVE);
+    CHECK_EQ(clock_current(), CLOCK_INTERACTIVE);
+    CHECK_EQ(SystemCoreClock, 32000000);
+    CHECK_EQ(FLASH->ACR & FLASH_ACR_LATENCY, FLASH_ACR_LATENCY);
+    CHECK(FLASH->ACR & FLASH_ACR_PRFTEN);
+    CHECK_EQ(PWR->CR & PWR_CR_VOS, PWR_REGULATOR_VOLTAGE_SCALE1);
+    // SysTick follows HCLK
+    CHECK_EQ(host_hal.tick_hz, 32000000);
+    CHECK_EQ(host_hal.core_prio[-SysTick_IRQn], IRQ_PRIO_SYSTICK);
+    // SPI1 back on at the new rate, SPI2 left off
+    CHECK(SPI1->CR1 & SPI_CR1_SPE);
+    CHECK(SPI1->CR1 & SPI_CR1_MSTR);
+    CHECK_EQ(SPI1->CR1 & SPI_CR1_BR, SPI_BAUDRATEPRESCALER_4);
+    CHECK_EQ(SPI2->CR1 & SPI_CR1_SPE, 0);
+    CHECK_EQ(SPI2->CR1 & SPI_CR1_BR, SPI_BAUDRATEPRESCALER_4);
+    // I2C timing for 32MHz, still enabled
+    CHECK_EQ(i2c1_regs.CR2 & I2C_CR2_FREQ, 32);
+    CHECK_EQ(i2c1_regs.TRISE, 33);
+    CHECK_EQ(i2c1_regs.CCR, 160);
+    CHECK(i2c1_regs.CR1 & I2C_CR1_PE);
+    CHECK_EQ(hi2c1.State, HAL_I2C_STATE_READY);
+    CHECK_EQ(USART1->BRR, UART_BRR_SAMPLING16(32000000, 115200));
+
+    // nested requests, the highest one wins until all are released
+    clock_request(CLOCK_BOOT);
+    CHECK_EQ(clock_current(), CLOCK_INTERACTIVE);
+    clock_release(CLOCK_INTERACTIVE);
+    CHECK_EQ(clock_current(), CLOCK_BOOT);
+    CHECK_EQ(SystemCoreClock, 16000000);
+    CHECK_EQ(host_hal.tick_hz, 16000000);
+    CHECK_EQ(RCC->CR & RCC_CR_PLLON, 0);
+    clock_release(CLOCK_BOOT);
+    CHECK_EQ(clock_current(), CLOCK_IDLE);
+    CHECK_EQ(RCC->CR & RCC_CR_HSION, 0);
+    CHECK_EQ(PWR->CR & PWR_CR_VOS, PWR_REGULATOR_VOLTAGE_SCALE3);
+    CHECK_EQ(FLASH->ACR & FLASH_ACR_LATENCY, 0);
+    CHECK_EQ(host_hal.tick_hz, 2097000);
+    CHECK_EQ(SPI1->CR1 & SPI_CR1_BR, SPI_BAUDRATEPRESCALER_2);
+    CHECK_EQ(i2c1_regs.CR2 & I2C_CR2_FREQ, 2);
+    // releasing what isn't held does nothing
+    uint32_t n = host_hal.clock_configs;
+    clock_release(CLOCK_INTERACTIVE);
+    CHECK_EQ(host_hal.clock_configs, n);
+
+    // after Stop, with interrupts masked by idle_enter, they stay masked
+    SystemCoreClock = 2097000;
+    __disable_irq();
+    clock_restore();
+    CHECK_EQ(__get_PRIMASK(), 1);
+    __enable_irq();
+    clock_restore();
+    CHECK_EQ(__get_PRIMASK(), 0);
+
+    // a PLL that doesn't lock: an error back instead of a hang, also with
+    // interrupts masked, and the system clock not switched to it
+    host_hal.osc_dead = RCC_CR_PLLRDY;
+    CHECK_EQ(clock_request(CLOCK_INTERACTIVE), -1);
+    CHECK_EQ(clock_current(), CLOCK_IDLE);
+    CHECK_EQ(SystemCoreClock, 2097000);
+    CHECK(__HAL_RCC_GET_SYSCLK_SOURCE() != RCC_CFGR_SWS_PLL);
+    CHECK_EQ(__get_PRIMASK(), 0);
+    __disable_irq();
+    CHECK_EQ(clock_request(CLOCK_INTERACTIVE), -1);
+    CHECK_EQ(__get_PRIMASK(), 1);
+    __enable_irq();
+    CHECK_EQ(host_hal.tick_hz, 2097000);
+    // once it locks the next call gets there
+    host_hal.osc_dead = 0;
+    CHECK_EQ(clock_release(CLOCK_INTERACTIVE), 0);
+    CHECK_EQ(clock_current(), CLOCK_INTERACTIVE);
+    CHECK_EQ(SystemCoreClock, 32000000);
+    CHECK_EQ(clock_release(CLOCK_INTERACTIVE), 0);
+    CHECK_EQ(clock_current(), CLOCK_IDLE);
+    // no HSI, no boot profile
+    host_hal.osc_dead = RCC_CR_HSIRDY;
+    CHECK_EQ(clock_request(CLOCK_BOOT), -1);
+    CHECK_EQ(clock_current(), CLOCK_IDLE);
+    CHECK_EQ(__HAL_RCC_GET_SYSCLK_SOURCE(), RCC_CFGR_SWS_MSI);
+    host_hal.osc_dead = 0;
+    CHECK_EQ(clock_release(CLOCK_BOOT), 0);
+
+    TEST_END();
+}
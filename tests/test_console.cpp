@@ -0,0 +1,98 @@
+// TextConsole onto the RA8875 model: the ring and the scroll offset show
+// the last lines in order, a scroll costs one line, unscroll() puts the
+// window back at screen positions
+
+#include "ra8875_model.h"
+#include "test.h"
+#include "TextConsole.h"
+
+typedef RA8875T<Panel800x480> Display;
+typedef TextConsole<Display, 20, 4> Console;
+
+static SPI_HandleTypeDef hspi;
+static Display d(&hspi, GPIOA, GPIO_PIN_4);
+static Console console;
+
+static const uint16_t top = 7 * 16;
+
+// text of visible console row r, as the scroll window shows it
+static const char *shown(int r)
+{
+	static char line[21];
+	uint16_t v = ra_reg16(RA8875_VOFS0);
+	uint16_t y = top + (r * 16 + v) % (4 * 16);
+	memcpy(line, ra.text[y / 16], 20);
+	line[20] = 0;
+	return line;
+}
+
+int main(void)
+{
+	// the offset math: the top line's slot comes first, the offset puts it on top
+	CHECK_EQ(Console::slotOf(0, 0), 0);
+	CHECK_EQ(Console::slotOf(3, 0), 3);
+	CHECK_EQ(Console::slotOf(3, 1), 0);
+	CHECK_EQ(Console::slotOf(2, 3), 1);
+	CHECK_EQ(Console::offsetOf(3, 16), 48);
+
+	host_reset();
+	ra_reset();
+	d.begin();
+	console.begin(&d, top, RA8875_GREEN, RA8875_BLACK);
+	CHECK_EQ(ra_reg16(RA8875_VSSW0), top);
+	CHECK_EQ(ra_reg16(RA8875_VESW0), top + 4 * 16 - 1);
+
+	for (int i = 0; i < 3; i++) console.printf("line %d\n", i);
+	CHECK_EQ(ra_reg16(RA8875_VOFS0), 0);
+	CHECK(strcmp(shown(0), "line 0") == 0);
+	CHECK(strcmp(shown(2), "line 2") == 0);
+
+	// the bottom line filled: each new line scrolls by one
+	for (int i = 3; i < 6; i++) console.printf("line %d\n", i);
+	CHECK_EQ(ra_reg16(RA8875_VOFS0), 3 * 16);
+	CHECK(strcmp(shown(0), "line 3") == 0);
+	CHECK(strcmp(shown(1), "line 4") == 0);
+	CHECK(strcmp(shown(2), "line 5") == 0);
+	CHECK_EQ(shown(3)[0], 0);
+
+	// a long line wraps onto the next
+	console.print("abcdefghijklmnopqrstuvwxyz");
+	CHECK(strcmp(shown(2), "abcdefghijklmnopqrst") == 0);
+	CHECK(strcmp(shown(3), "uvwxyz") == 0);
+
+	// a scroll is one line cleared and the offset, whatever the height
+	console.print("\nnext");
+	ra_count();
+	console.print("\n");
+	uint32_t scroll = ra.bytes;
+	CHECK_EQ(ra.pixelBytes, 0);
+	CHECK_EQ(ra.writes[RA8875_DCR], 1);
+	CHECK_EQ(ra.writes[RA8875_VOFS0], 1);
+	CHECK(strcmp(shown(2), "next") == 0);
+	CHECK_EQ(shown(3)[0], 0);
+	ra_count();
+	console.redraw();
+	printf("scroll: %lu bytes, redraw of the console: %lu bytes\n", (unsigned long)scroll, (unsigned long)ra.bytes);
+
+	// redraw puts the lines in memory in display order with no offset,
+	// so a drawing at screen positions over the console lands where it shows
+	CHECK_EQ(ra_reg16(RA8875_VOFS0), 0);
+	CHECK(strcmp(shown(0), "abcdefghijklmnopqrst") == 0);
+	CHECK(strcmp(shown(1), "uvwxyz") == 0);
+	CHECK(strcmp(shown(2), "next") == 0);
+	CHECK(strcmp(ra.text[top / 16 + 2], "next") == 0);
+
+	// unscroll does nothing until it scrolls again
+	ra_count();
+	console.unscroll();
+	CHECK_EQ(ra.bytes, 0);
+	console.print("a\nb\nc\n");
+	CHECK(ra_reg16(RA8875_VOFS0) != 0);
+	console.unscroll();
+	CHECK_EQ(ra_reg16(RA8875_VOFS0), 0);
+	for (int r = 0; r < 4; r++) CHECK(strncmp(ra.text[top / 16 + r], shown(r), 20) == 0);
+	CHECK(strcmp(shown(0), "a") == 0);
+	CHECK(strcmp(shown(2), "c") == 0);
+
+	TEST_END();
+}
@@ -0,0 +1,113 @@
+// The graphic cursor onto the RA8875 model: the text to image encoder, the
+// upload into the cursor RAM, the colors, and a move that writes only the
+// position registers that changed
+
+#include "ra8875_model.h"
+#include "test.h"
+
+typedef RA8875T<Panel800x480> Display;
+
+static SPI_HandleTypeDef hspi;
+static Display d(&hspi, GPIOA, GPIO_PIN_4);
+
+// 2 bit code of pixel x,y, first pixel in the high bits
+static int code(const uint8_t image[256], int x, int y)
+{
+	return (image[y * 8 + x / 4] >> (6 - 2 * (x & 3))) & 3;
+}
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+
+	// nothing drawn is the background everywhere
+	uint8_t image[256];
+	Display::encodeGraphicCursor(0, 0, image);
+	for (int i = 0; i < 256; i++) CHECK_EQ(image[i], 0xAA);
+
+	// '0', '1' and 'x' are the codes 0, 1 and 3, the rest background;
+	// short rows and missing rows are background, past 32 is cut
+	static const char *const rows[] = {
+		"01x.",
+		"",
+		"0123456789012345678901234567890110",
+		"                               1",
+	};
+	Display::encodeGraphicCursor(rows, 4, image);
+	CHECK_EQ(image[0], 0x1E);	// 00 01 11 10
+	CHECK_EQ(image[1], 0xAA);
+	CHECK_EQ(code(image, 0, 0), 0);
+	CHECK_EQ(code(image, 1, 0), 1);
+	CHECK_EQ(code(image, 2, 0), 3);
+	CHECK_EQ(code(image, 3, 0), 2);
+	for (int x = 0; x < 32; x++) CHECK_EQ(code(image, x, 1), 2);
+	CHECK_EQ(code(image, 0, 2), 0);
+	CHECK_EQ(code(image, 1, 2), 1);
+	CHECK_EQ(code(image, 2, 2), 2);
+	CHECK_EQ(code(image, 30, 2), 0);
+	CHECK_EQ(code(image, 31, 2), 1);
+	CHECK_EQ(code(image, 0, 3), 2);	// nothing spilled from the long row
+	CHECK_EQ(code(image, 31, 3), 1);
+	CHECK_EQ(image[3 * 8 + 7], 0xA9);
+	for (int y = 4; y < 32; y++) for (int x = 0; x < 32; x++) CHECK_EQ(code(image, x, y), 2);
+
+	// the upload lands in the slot's cursor RAM in one burst, then
+	// memory writes go back to the layer
+	ra_count();
+	d.uploadGraphicCursor(3, image);
+	CHECK_EQ(memcmp(ra.cursor[3], image, 256), 0);
+	CHECK_EQ(ra.pixelBytes, 256);
+	CHECK_EQ((ra.reg[RA8875_MWCR1] >> 4) & 7, 3);
+	CHECK_EQ(ra.reg[RA8875_MWCR1] & 0x0C, 0);
+	printf("upload: %lu bytes in %lu transactions\n", (unsigned long)ra.bytes, (unsigned long)ra.transactions);
+	CHECK(ra.transactions < 16);
+
+	// colors in RGB332
+	d.setGraphicCursorColors(RA8875_RED, RA8875_BLUE);
+	CHECK_EQ(ra.reg[RA8875_GCC0], 0xE0);
+	CHECK_EQ(ra.reg[RA8875_GCC1], 0x03);
+	d.setGraphicCursorColors(RA8875_WHITE, RA8875_BLACK);
+	CHECK_EQ(ra.reg[RA8875_GCC0], 0xFF);
+	CHECK_EQ(ra.reg[RA8875_GCC1], 0x00);
+
+	d.showGraphicCursor(true);
+	CHECK(ra.reg[RA8875_MWCR1] & 0x80);
+
+	// the first move writes the four position registers
+	ra_count();
+	d.moveGraphicCursor(300, 200);
+	CHECK_EQ(ra_reg16(RA8875_GCHP0), 300);
+	CHECK_EQ(ra_reg16(RA8875_GCVP0), 200);
+	CHECK_EQ(ra.writes[RA8875_GCHP0] + ra.writes[RA8875_GCHP1] + ra.writes[RA8875_GCVP0] + ra.writes[RA8875_GCVP1], 4);
+	// a finger moving a little only changes the low bytes
+	ra_count();
+	d.moveGraphicCursor(305, 203);
+	CHECK_EQ(ra.writes[RA8875_GCHP0], 1);
+	CHECK_EQ(ra.writes[RA8875_GCHP1], 0);
+	CHECK_EQ(ra.writes[RA8875_GCVP0], 1);
+	CHECK_EQ(ra.writes[RA8875_GCVP1], 0);
+	CHECK_EQ(ra.reads, 0);
+	uint32_t move = ra.bytes;
+	// no move, nothing sent
+	ra_count();
+	d.moveGraphicCursor(305, 203);
+	CHECK_EQ(ra.bytes, 0);
+	// kept on the screen
+	d.moveGraphicCursor(-40, 900);
+	CHECK_EQ(ra_reg16(RA8875_GCHP0), 0);
+	CHECK_EQ(ra_reg16(RA8875_GCVP0), 479);
+
+	// against marking the finger with a dot drawn and erased each frame
+	ra_count();
+	d.fillCircle(305, 203, 20, RA8875_WHITE);
+	d.fillCircle(305, 203, 20, RA8875_BLACK);
+	printf("cursor move: %lu bytes, dot drawn and erased: %lu bytes\n", (unsigned long)move, (unsigned long)ra.bytes);
+	CHECK(move * 4 < ra.bytes);
+
+	d.showGraphicCursor(false);
+	CHECK(!(ra.reg[RA8875_MWCR1] & 0x80));
+
+	TEST_END();
+}
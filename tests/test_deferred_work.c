@@ -0,0 +1,73 @@
+// DeferredWork queue: order, capacity, drops and the PendSV request
+
+#include "stm32l1xx_hal.h"
+#include "hal_host.h"
+#include "DeferredWork.h"
+#include "irq_priority.h"
+#include "test.h"
+
+static uint32_t ran[64];
+static int nran;
+
+static void record(uint32_t arg)
+{
+    ran[nran++] = arg;
+}
+
+// posting from inside work, as a chained bottom half would
+static void repost(uint32_t arg)
+{
+    record(arg);
+    if(arg < 103) work_post(repost, arg + 1);
+}
+
+int main(void)
+{
+    host_reset();
+    work_init();
+    CHECK_EQ(host_hal.core_prio[-PendSV_IRQn], IRQ_PRIO_PENDSV);
+    CHECK(!work_pending());
+
+    // FIFO, and every post asks for PendSV
+    CHECK(work_post(record, 1));
+    CHECK(SCB->ICSR & SCB_ICSR_PENDSVSET_Msk);
+    CHECK(work_post(record, 2));
+    CHECK(work_pending());
+    work_run_pending();
+    CHECK_EQ(nran, 2);
+    CHECK_EQ(ran[0], 1);
+    CHECK_EQ(ran[1], 2);
+    CHECK(!work_pending());
+
+    // one slot tells full from empty, the rest are usable
+    nran = 0;
+    for (uint32_t i = 0; i < WORK_QUEUE_SIZE - 1; i++) CHECK(work_post(record, 10 + i));
+    CHECK(!work_post(record, 99));
+    CHECK(!work_post(record, 99));
+    CHECK_EQ(work_get_dropped(), 2);
+    work_run_pending();
+    CHECK_EQ(nran, WORK_QUEUE_SIZE - 1);
+    for (int i = 0; i < nran; i++) CHECK_EQ(ran[i], 10 + i);
+
+    // the indices wrap many times without losing or repeating items
+    nran = 0;
+    for (uint32_t i = 0; i < 40; i++) {
+        CHECK(work_post(record, i));
+        if(i % 3 == 2) {
+            work_run_pending();
+        }
+    }
+    work_run_pending();
+    CHECK_EQ(nran, 40);
+    for (int i = 0; i < nran; i++) CHECK_EQ(ran[i], i);
+
+    // work queued by work runs in the same pass
+    nran = 0;
+    work_post(repost, 100);
+    work_run_pending();
+    CHECK_EQ(nran, 4);
+    CHECK_EQ(ran[3], 103);
+    CHECK_EQ(work_get_dropped(), 2);
+
+    TEST_END();
+}
@@ -0,0 +1,87 @@
+// Double buffering onto the RA8875 model: which layer shows, which one is
+// written, the color depth, and what a flip costs
+
+#include "ra8875_model.h"
+#include "test.h"
+
+static SPI_HandleTypeDef hspi;
+
+// layer written to, 0 or 1, from MWCR1
+static int written(void) { return ra.reg[RA8875_MWCR1] & 1; }
+// layer shown, from LTPR0
+static int shown(void) { return ra.reg[RA8875_LTPR0] & 7; }
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	RA8875T<Panel800x480> d(&hspi, GPIOA, GPIO_PIN_4);
+	d.begin();
+
+	// 800x480 has two layers only at 8bpp
+	CHECK(d.doubleBuffer(true));
+	CHECK_EQ(ra.reg[RA8875_SYSR], 0x00);
+	CHECK(ra.reg[RA8875_DPCR] & 0x80);
+	CHECK_EQ(shown(), 0);
+	CHECK_EQ(written(), 1);
+	// colors go in 3:3:2
+	d.setForegroundColor(RA8875_WHITE);
+	CHECK_EQ(ra.reg[RA8875_FGCR0], 7);
+	CHECK_EQ(ra.reg[RA8875_FGCR1], 7);
+	CHECK_EQ(ra.reg[RA8875_FGCR2], 3);
+
+	// a flip is one LTPR0 write, then drawing goes to the layer that was shown
+	host_hal.tick += 16;
+	ra_count();
+	d.flip();
+	CHECK_EQ(ra.writes[RA8875_LTPR0], 1);
+	CHECK_EQ(ra.writes[RA8875_BECR0], 0);
+	CHECK_EQ(shown(), 1);
+	CHECK_EQ(written(), 0);
+	CHECK_EQ(d.frameTime(), 16);
+	printf("flip: %lu transactions, %lu bytes\n", (unsigned long)ra.transactions, (unsigned long)ra.bytes);
+
+	host_hal.tick += 20;
+	d.flip();
+	CHECK_EQ(shown(), 0);
+	CHECK_EQ(written(), 1);
+	CHECK_EQ(d.frameTime(), 20);
+
+	// the new back buffer starts as a BTE copy of the frame just shown
+	ra_count();
+	d.flip(true);
+	CHECK_EQ(shown(), 1);
+	CHECK_EQ(written(), 0);
+	CHECK_EQ(ra.writes[RA8875_BECR0], 1);
+	CHECK_EQ(ra.reg[RA8875_VSBE1] >> 7, 1);	// from layer 2
+	CHECK_EQ(ra.reg[RA8875_VDBE1] >> 7, 0);	// into layer 1
+	CHECK_EQ(ra_reg16(RA8875_BEWR0), 800);
+	CHECK_EQ(ra_reg16(RA8875_BEHR0), 480);
+	CHECK_EQ(ra.reg[RA8875_BECR1], (ROP_S << 4) | 0x02);
+
+	// off: one layer shown and written, back to 65K colors
+	CHECK(d.doubleBuffer(false));
+	CHECK_EQ(shown(), 0);
+	CHECK_EQ(written(), 0);
+	CHECK(!(ra.reg[RA8875_DPCR] & 0x80));
+	CHECK_EQ(ra.reg[RA8875_SYSR], 0x0C);
+	d.setForegroundColor(RA8875_WHITE);
+	CHECK_EQ(ra.reg[RA8875_FGCR1], 0x3F);
+	// and a flip does nothing
+	ra_count();
+	d.flip();
+	CHECK_EQ(ra.bytes, 0);
+
+	// 480x272 has the two layers at 16bpp
+	ra_reset();
+	RA8875T<Panel480x272> s(&hspi, GPIOA, GPIO_PIN_4);
+	s.begin();
+	CHECK(s.doubleBuffer(true));
+	CHECK_EQ(ra.writes[RA8875_SYSR], 1);
+	CHECK_EQ(ra.reg[RA8875_SYSR], 0x0C);
+	CHECK_EQ(written(), 1);
+	s.flip();
+	CHECK_EQ(shown(), 1);
+
+	TEST_END();
+}
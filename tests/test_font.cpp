@@ -0,0 +1,153 @@
+// FontRenderer onto the RA8875 model: strings drawn in runs through a small
+// line buffer match a reference rendering pixel for pixel, glyphs that
+// overhang their advance included, the width cache answers for the string
+// it was asked, and glyphs per second and bytes per glyph are printed
+
+#include "ra8875_model.h"
+#include "test.h"
+#include "Font.h"
+
+#include <time.h>
+
+typedef RA8875T<Panel800x480> Display;
+
+static SPI_HandleTypeDef hspi;
+static Display d(&hspi, GPIOA, GPIO_PIN_4);
+
+// a 4 bpp face for ' '...'z': boxes of coverage rising left to right,
+// 'f' overhangs right, 'j' left, 'W' both
+static FontGlyph glyphs['z' - ' ' + 1];
+static uint8_t bitmaps[('z' - ' ' + 1) * 128];
+static const FontKern kerns[] = {{'A', 'V', -2}, {'V', 'A', -2}, {'f', 'f', -1}};
+static FontFace face = {4, ' ', 'z', 16, 12, glyphs, bitmaps, kerns, 3};
+
+static void make_face(void)
+{
+	uint32_t off = 0;
+	for (int c = ' '; c <= 'z'; c++) {
+		FontGlyph &g = glyphs[c - ' '];
+		g.offset = off;
+		g.w = c == ' ' ? 0 : 6;
+		g.h = 10;
+		g.x = 1;
+		g.y = -10;
+		g.advance = 8;
+		if (c == 'f') { g.x = 2; g.w = 9; g.advance = 6; }
+		if (c == 'j') { g.x = -3; g.w = 7; g.advance = 6; }
+		if (c == 'W') { g.x = -2; g.w = 14; g.advance = 10; }
+		for (int i = 0; i < g.w * g.h; i++) {
+			uint8_t v = 1 + (i % g.w + c) % 15;
+			if (i & 1) bitmaps[off + i / 2] |= v;
+			else bitmaps[off + i / 2] = v << 4;
+		}
+		off += (g.w * g.h + 1) / 2;
+	}
+}
+
+static uint8_t cover(const FontGlyph &g, int i)
+{
+	const uint8_t *p = bitmaps + g.offset;
+	return (p[i >> 1] >> ((i & 1) ? 0 : 4)) & 0x0F;
+}
+
+static uint16_t blend(uint16_t fg, uint16_t bg, int c)
+{
+	int r = (bg >> 11) + (((fg >> 11) - (bg >> 11)) * c + 7) / 15;
+	int g = ((bg >> 5) & 0x3F) + ((((fg >> 5) & 0x3F) - ((bg >> 5) & 0x3F)) * c + 7) / 15;
+	int b = (bg & 0x1F) + (((fg & 0x1F) - (bg & 0x1F)) * c + 7) / 15;
+	return r << 11 | g << 5 | b;
+}
+
+// the string drawn in one piece; pixels that differ, between the leftmost
+// and the rightmost ink or advance
+static int wrong(const char *s, int x0, int y0, uint16_t fg, uint16_t bg)
+{
+	static uint8_t ref[16][800];
+	memset(ref, 0, sizeof(ref));
+	int pen = x0, left = x0, right = x0;
+	for (int k = 0; s[k]; k++) {
+		const FontGlyph &g = glyphs[s[k] - ' '];
+		for (int gy = 0; gy < g.h; gy++) {
+			for (int gx = 0; gx < g.w; gx++) {
+				int c = cover(g, gy * g.w + gx), x = pen + g.x + gx;
+				uint8_t &r = ref[face.ascent + g.y + gy][x];
+				if (c > r) r = c;
+			}
+		}
+		if (g.w && pen + g.x < left) left = pen + g.x;
+		if (g.w && pen + g.x + g.w > right) right = pen + g.x + g.w;
+		pen += g.advance;
+		for (unsigned i = 0; s[k + 1] && i < sizeof(kerns) / sizeof(kerns[0]); i++) {
+			if (kerns[i].left == s[k] && kerns[i].right == s[k + 1]) pen += kerns[i].dx;
+		}
+		if (pen > right) right = pen;
+	}
+	int n = 0;
+	for (int y = 0; y < 16; y++) {
+		for (int x = left; x < right; x++) n += ra_fb[y0 + y][x] != blend(fg, bg, ref[y][x]);
+	}
+	return n;
+}
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+	make_face();
+
+	// runs cut through a 48 pixel line buffer: the overhangs survive where
+	// the characters that overhang each other fit the buffer
+	static FontRenderer<Display, 48> small;
+	static const char *const strings[] = {
+		"fifty jiffy", "WWW", "AVAVA jab", "off", "jjjjj", "jjjjj jjjjj", "abcdefghijklmnopqrstuvwxyz",
+	};
+	for (unsigned k = 0; k < sizeof(strings) / sizeof(strings[0]); k++) {
+		memset(ra_fb, 0, sizeof(ra_fb));
+		int16_t end = small.draw(&d, &face, 40, 100, strings[k], RA8875_WHITE, RA8875_BLUE);
+		CHECK_EQ(end - 40, small.width(&face, strings[k]));
+		int n = wrong(strings[k], 40, 100, RA8875_WHITE, RA8875_BLUE);
+		if (n) printf("\"%s\": %d pixels wrong\n", strings[k], n);
+		CHECK_EQ(n, 0);
+	}
+	// overhangs wider than the buffer are cut, the glyphs still drawn
+	static FontRenderer<Display, 12> tiny;
+	memset(ra_fb, 0, sizeof(ra_fb));
+	tiny.draw(&d, &face, 40, 100, "WaW", RA8875_WHITE, RA8875_BLACK);
+	CHECK(ra_fb[100 + face.ascent - 5][40 + 10 + 3] != 0);
+
+	// the width cache: kerning counted, a buffer rewritten in place is
+	// measured again, long strings are measured every time
+	FontRenderer<Display, 32> r;
+	CHECK_EQ(r.width(&face, "AV"), 8 + 8 - 2);
+	char buf[48] = "abc";
+	CHECK_EQ(r.width(&face, buf), 24);
+	strcpy(buf, "ff");
+	CHECK_EQ(r.width(&face, buf), 6 + 6 - 1);
+	strcpy(buf, "abc");
+	CHECK_EQ(r.width(&face, buf), 24);
+	memset(buf, 'a', 40);
+	buf[40] = 0;
+	CHECK_EQ(r.width(&face, buf), 320);
+	buf[0] = 'f';
+	CHECK_EQ(r.width(&face, buf), 318);
+
+	// benchmark: a 40 character line, bytes on the bus and time on the host
+	static FontRenderer<Display, 320> line;
+	const char *text = "The quick brown fox jumps over the lazy";
+	int glyphs_n = strlen(text);
+	ra_count();
+	line.draw(&d, &face, 0, 200, text, RA8875_WHITE, RA8875_BLACK);
+	printf("%d glyphs: %lu bytes, %.1f bytes a glyph in %lu transactions\n", glyphs_n,
+		(unsigned long)ra.bytes, (double)ra.bytes / glyphs_n, (unsigned long)ra.transactions);
+	CHECK(ra.pixelBytes >= (uint32_t)line.width(&face, text) * face.height * 2);
+	const int N = 200;
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (int i = 0; i < N; i++) line.draw(&d, &face, 0, 200, text, RA8875_WHITE, RA8875_BLACK);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("%.0f glyphs a second on the host, model included\n", N * glyphs_n / s);
+
+	TEST_END();
+}
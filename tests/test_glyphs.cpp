@@ -0,0 +1,129 @@
+// GlyphCache onto the RA8875 model: the least recently used glyph goes,
+// glyphs land in CGRAM in one burst each, up to SLOTS of them print in one
+// text burst of a fixed cost, and slots stay within the 256 CGRAM chars
+
+#include "ra8875_model.h"
+#include "test.h"
+#include "GlyphCache.h"
+
+typedef RA8875T<Panel800x480> Display;
+
+static SPI_HandleTypeDef hspi;
+static Display d(&hspi, GPIOA, GPIO_PIN_4);
+
+static uint32_t sourced;
+
+// glyph id's rows are id, id+1... ; ids from 1000 don't exist
+static const uint8_t *source(uint16_t id)
+{
+	static uint8_t bits[16];
+	if (id >= 1000) return 0;
+	sourced++;
+	for (int r = 0; r < 16; r++) bits[r] = id + r;
+	return bits;
+}
+
+static bool holds(int addr, uint16_t id)
+{
+	for (int r = 0; r < 16; r++) {
+		if (ra.cgram[addr][r] != (uint8_t)(id + r)) return false;
+	}
+	return true;
+}
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+
+	GlyphCache<Display, 4> cache(source, 100);
+
+	// a miss uploads the glyph in one burst, nothing read back
+	ra_count();
+	int16_t a1 = cache.slot(&d, 1);
+	CHECK_EQ(a1, 100);
+	CHECK(holds(a1, 1));
+	CHECK_EQ(ra.pixelBytes, 16);
+	CHECK_EQ(ra.reads, 0);
+	CHECK_EQ(ra.reg[RA8875_MWCR1] & 0x0C, 0);	// back to the layer
+	printf("upload: %lu bytes in %lu transactions\n", (unsigned long)ra.bytes, (unsigned long)ra.transactions);
+	CHECK(ra.transactions <= 6);
+	// a hit sends nothing
+	ra_count();
+	CHECK_EQ(cache.slot(&d, 1), a1);
+	CHECK_EQ(ra.bytes, 0);
+	CHECK_EQ(cache.hits(), 1);
+
+	int16_t a2 = cache.slot(&d, 2), a3 = cache.slot(&d, 3), a4 = cache.slot(&d, 4);
+	CHECK_EQ(cache.uploads(), 4);
+	CHECK(a1 != a2 && a2 != a3 && a3 != a4);
+	// 1 used again, so 2 is the least recent and makes room for 5
+	cache.slot(&d, 1);
+	int16_t a5 = cache.slot(&d, 5);
+	CHECK_EQ(a5, a2);
+	CHECK(holds(a5, 5));
+	CHECK(!cache.resident(2));
+	CHECK(cache.resident(1));
+	CHECK(cache.resident(3));
+	// then 3, then 4
+	CHECK_EQ(cache.slot(&d, 6), a3);
+	CHECK_EQ(cache.slot(&d, 7), a4);
+	CHECK_EQ(cache.slot(&d, 2), a1);
+	CHECK_EQ(cache.uploads(), 8);
+	// unknown glyphs take no slot
+	CHECK_EQ(cache.slot(&d, 1000), -1);
+	CHECK_EQ(cache.uploads(), 8);
+
+	// resident glyphs print as text, runs of up to SLOTS in one burst
+	uint16_t run[] = {2, 7, 6, 5, 1000, 2};
+	d.setCursor(0, 64);
+	ra_count();
+	cache.print(&d, run, 6);
+	CHECK_EQ(cache.uploads(), 8);
+	CHECK_EQ(ra.pixelBytes, 5);	// the unknown one skipped
+	CHECK_EQ((uint8_t)ra.text[4][0], a1);
+	CHECK_EQ((uint8_t)ra.text[4][1], a4);
+	CHECK_EQ((uint8_t)ra.text[4][4], a1);
+	CHECK_EQ(ra.reg[RA8875_FNCR0] & 0x80, 0);	// CGROM again after
+	// a burst costs the same, as long as it is
+	uint16_t four[] = {2, 7, 6, 5}, two[] = {2, 7};
+	d.setCursor(0, 64);
+	ra_count();
+	cache.print(&d, four, 4);
+	uint32_t n4 = ra.transactions;
+	d.setCursor(0, 80);
+	ra_count();
+	cache.print(&d, two, 2);
+	printf("a run of 4 glyphs: %lu transactions, of 2: %lu\n", (unsigned long)n4, (unsigned long)ra.transactions);
+	CHECK_EQ(ra.transactions, n4);
+
+	// a run longer than the cache goes out in runs of SLOTS glyphs, each
+	// uploaded before its burst and not evicted by it
+	uint16_t many[6] = {10, 11, 12, 13, 14, 15};
+	d.setCursor(0, 96);
+	ra_count();
+	cache.print(&d, many, 6);
+	CHECK_EQ(cache.uploads(), 14);
+	CHECK_EQ(ra.pixelBytes, 6 * 16 + 6);
+	CHECK(holds((uint8_t)ra.text[6][4], 14));
+	CHECK(holds((uint8_t)ra.text[6][5], 15));
+	CHECK((uint8_t)ra.text[6][4] != (uint8_t)ra.text[6][5]);
+
+	// a wide symbol, ids first... left to right
+	d.setCursor(0, 128);
+	cache.printWide(&d, 20, 3);
+	for (int i = 0; i < 3; i++) CHECK(holds((uint8_t)ra.text[8][i], 20 + i));
+
+	// slots past CGRAM char 255 are left out
+	GlyphCache<Display, 8> top(source, 252);
+	for (uint16_t id = 0; id < 8; id++) {
+		int16_t a = top.slot(&d, 200 + id);
+		CHECK(a >= 252 && a <= 255);
+	}
+	CHECK_EQ(top.uploads(), 8);
+	CHECK(!top.resident(203));
+	CHECK(top.resident(207));
+
+	TEST_END();
+}
@@ -0,0 +1,188 @@
+// HitGrid against a linear scan at 10, 100 and 500 targets: the same
+// answers for points and rectangles, also after targets move, and the time
+// per point query of both
+
+#include "test.h"
+#include "HitGrid.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+struct Target { int16_t x, y, w, h; };
+
+typedef HitGrid<800, 480, 40, 16, 512> Grid;
+
+static Target targets[500];
+static int count;
+static Grid grid;
+
+static uint32_t rnd_state = 1;
+static int rnd(int lo, int hi)
+{
+	rnd_state = rnd_state * 1103515245 + 12345;
+	return lo + (int)((rnd_state >> 8) % (uint32_t)(hi - lo + 1));
+}
+
+static bool contains(const Target &t, int16_t x, int16_t y)
+{
+	return x >= t.x && x < t.x + t.w && y >= t.y && y < t.y + t.h;
+}
+
+static bool overlaps(const Target &t, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	return t.x < x + w && x < t.x + t.w && t.y < y + h && y < t.y + t.h;
+}
+
+// topmost, last added, target under the point, -1 if none
+static int linear(int16_t x, int16_t y)
+{
+	for (int i = count - 1; i >= 0; i--) {
+		if (contains(targets[i], x, y)) return i;
+	}
+	return -1;
+}
+
+static int indexed(int16_t x, int16_t y)
+{
+	const Grid::Id *ids;
+	uint8_t n = grid.at(x, y, &ids);
+	if (n == HIT_OVERFLOW) return linear(x, y);
+	for (int k = n - 1; k >= 0; k--) {
+		if (contains(targets[ids[k]], x, y)) return ids[k];
+	}
+	return -1;
+}
+
+static Target random_target(void)
+{
+	Target t = {(int16_t)rnd(-20, 790), (int16_t)rnd(-20, 470), (int16_t)rnd(16, 64), (int16_t)rnd(16, 48)};
+	return t;
+}
+
+static void build(int n)
+{
+	count = n;
+	grid.clear();
+	for (int i = 0; i < n; i++) {
+		targets[i] = random_target();
+		grid.add(i, targets[i].x, targets[i].y, targets[i].w, targets[i].h);
+	}
+}
+
+// every answer of the grid against the scan, points on screen and small rectangles
+static void compare(void)
+{
+	int wrong = 0;
+	for (int k = 0; k < 2000; k++) {
+		int16_t x = rnd(0, 799), y = rnd(0, 479);
+		if (indexed(x, y) != linear(x, y)) wrong++;
+	}
+	CHECK_EQ(wrong, 0);
+	for (int k = 0; k < 200; k++) {
+		int16_t x = rnd(-10, 790), y = rnd(-10, 470), w = rnd(1, 120), h = rnd(1, 80);
+		Grid::Id ids[255];
+		uint8_t n = grid.query(x, y, w, h, ids, 255);
+		if (n == HIT_OVERFLOW) continue;
+		// the candidates hold every overlapping target, in order, once
+		int j = 0;
+		for (int i = 0; i < count; i++) {
+			if (!overlaps(targets[i], x, y, w, h)) continue;
+			while (j < n && ids[j] < i) j++;
+			if (j == n || ids[j] != i) wrong++;
+		}
+		for (int i = 1; i < n; i++) if (ids[i] <= ids[i - 1]) wrong++;
+	}
+	CHECK_EQ(wrong, 0);
+}
+
+static int overflowed(void)
+{
+	int n = 0;
+	for (int16_t y = 20; y < 480; y += 40) {
+		for (int16_t x = 20; x < 800; x += 40) {
+			const Grid::Id *ids;
+			n += grid.at(x, y, &ids) == HIT_OVERFLOW;
+		}
+	}
+	return n;
+}
+
+static double ns_per_query(int (*find)(int16_t, int16_t))
+{
+	const int N = 200000;
+	static int16_t xs[1024], ys[1024];
+	for (int i = 0; i < 1024; i++) xs[i] = rnd(0, 799), ys[i] = rnd(0, 479);
+	volatile int sink = 0;
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (int i = 0; i < N; i++) sink += find(xs[i & 1023], ys[i & 1023]);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	(void)sink;
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / N;
+}
+
+int main(void)
+{
+	printf("grid of 240 cells: 4 one byte ids a cell %lu bytes, 16 two byte ids a cell %lu bytes\n",
+		(unsigned long)sizeof(HitGrid<800, 480, 40, 4>), (unsigned long)sizeof(Grid));
+
+	static const int sizes[] = {10, 100, 500};
+	for (int s = 0; s < 3; s++) {
+		build(sizes[s]);
+		compare();
+		// targets move, the grid follows
+		for (int k = 0; k < sizes[s]; k++) {
+			int i = rnd(0, count - 1);
+			Target t = random_target();
+			grid.move(i, targets[i].x, targets[i].y, targets[i].w, targets[i].h, t.x, t.y, t.w, t.h);
+			targets[i] = t;
+		}
+		compare();
+		double g = ns_per_query(indexed), l = ns_per_query(linear);
+		printf("%3d targets: grid %6.1f ns, linear scan %6.1f ns a point, %3d of 240 cells overflowed\n",
+			count, g, l, overflowed());
+	}
+
+	// ids past a byte: the default grid keeps one
+	CHECK_EQ(sizeof(HitGrid<800, 480, 40, 4>::Id), 1);
+	CHECK_EQ(sizeof(Grid::Id), 2);
+
+	// 255 ids can't be told from HIT_OVERFLOW, so they are one: the caller
+	// scans instead, one fewer is answered
+	for (int n = 254; n <= 256; n++) {
+		build(0);
+		for (int i = 0; i < n; i++) {
+			Target t = {(int16_t)((i / 2 % 20) * 40 + 5 + (i & 1) * 20), (int16_t)(i / 40 * 40 + 5), 10, 10};
+			targets[i] = t;
+			grid.add(i, t.x, t.y, t.w, t.h);
+		}
+		count = n;
+		Grid::Id ids[255];
+		uint8_t got = grid.query(0, 0, 800, 480, ids, 255);
+		if (n < 255) {
+			CHECK_EQ(got, n);
+			CHECK_EQ(ids[n - 1], n - 1);
+		} else {
+			CHECK_EQ(got, HIT_OVERFLOW);
+		}
+		CHECK_EQ(overflowed(), 0);
+	}
+
+	// a cell overflows past SLOTS ids and stays so until cleared
+	HitGrid<80, 80, 40, 2> small;
+	const uint8_t *ids;
+	small.add(3, 0, 0, 10, 10);
+	small.add(1, 5, 5, 10, 10);
+	CHECK_EQ(small.at(1, 1, &ids), 2);
+	CHECK_EQ(ids[0], 1);
+	CHECK_EQ(ids[1], 3);
+	small.add(2, 0, 0, 4, 4);
+	CHECK_EQ(small.at(1, 1, &ids), HIT_OVERFLOW);
+	small.remove(2, 0, 0, 4, 4);
+	CHECK_EQ(small.at(1, 1, &ids), HIT_OVERFLOW);
+	CHECK_EQ(small.at(50, 50, &ids), 0);
+	small.clear();
+	CHECK_EQ(small.at(1, 1, &ids), 0);
+
+	TEST_END();
+}
@@ -0,0 +1,55 @@
+// IdleManager: the Sleep/Stop decision
+
+#include "stm32l1xx_hal.h"
+#include "hal_host.h"
+#include "IdleManager.h"
+#include "test.h"
+
+// Stop is never entered here, the RTC can't run on the host
+void clock_restore(void) {}
+
+int main(void)
+{
+    host_reset();
+
+    // anything to do wins
+    CHECK_EQ(idle_policy(1, 10000, 1000), IDLE_NONE);
+    // a deadline that is already due
+    CHECK_EQ(idle_policy(0, 10000, 0), IDLE_NONE);
+
+    // short waits aren't worth the Stop round trip
+    CHECK_EQ(idle_policy(0, 10000, 1), IDLE_SLEEP);
+    CHECK_EQ(idle_policy(0, 10000, IDLE_STOP_MIN_MS - 1), IDLE_SLEEP);
+    CHECK_EQ(idle_policy(0, 10000, IDLE_STOP_MIN_MS), IDLE_STOP);
+
+    // touches come in bursts, stay responsive right after one
+    CHECK_EQ(idle_policy(0, 0, 2000), IDLE_SLEEP);
+    CHECK_EQ(idle_policy(0, IDLE_STOP_HOLDOFF_MS - 1, 2000), IDLE_SLEEP);
+    CHECK_EQ(idle_policy(0, IDLE_STOP_HOLDOFF_MS, 2000), IDLE_STOP);
+    CHECK_EQ(idle_policy(0, 0xFFFFFFFF, 0xFFFFFFFF), IDLE_STOP);
+
+    // idle_enter follows it, Sleep keeps the tick and returns with irqs on
+    host_hal.tick = 100;
+    idle_activity();
+    host_hal.tick = 120;
+    __disable_irq();
+    idle_enter(0, 1000);
+    CHECK_EQ(host_hal.sleeps, 1);
+    CHECK_EQ(host_hal.stops, 0);
+    CHECK_EQ(__get_PRIMASK(), 0);
+    __disable_irq();
+    idle_enter(1, 1000);
+    CHECK_EQ(host_hal.sleeps, 1);
+    CHECK_EQ(__get_PRIMASK(), 0);
+
+    struct idle_stats s;
+    idle_get_stats(&s);
+    CHECK_EQ(s.sleeps, 1);
+    CHECK_EQ(s.stops, 0);
+    // no wake from Stop, nothing to time
+    idle_pixel_drawn();
+    idle_get_stats(&s);
+    CHECK_EQ(s.wakes, 0);
+
+    TEST_END();
+}
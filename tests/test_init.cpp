@@ -0,0 +1,73 @@
+// The init table replayed onto the model: what ends up in the registers,
+// in which order, and how long the bring-up waits
+
+#include "ra8875_model.h"
+#include "test.h"
+
+static SPI_HandleTypeDef hspi;
+
+// position of the first write to r, -1 if none
+static int first(uint8_t r)
+{
+	for (int i = 0; i < ra.nlog; i++) {
+		if (ra.log[i].reg == r) return i;
+	}
+	return -1;
+}
+
+template<class Panel>
+static void check_panel(void)
+{
+	host_reset();
+	ra_reset();
+	RA8875T<Panel> d(&hspi, GPIOA, GPIO_PIN_4);
+	d.begin();
+
+	// the timing registers hold the panel's table
+	static const uint8_t regs[15] = {RA8875_PLLC1, RA8875_PLLC2, RA8875_PCSR,
+		RA8875_HDWR, RA8875_HNDFTR, RA8875_HNDR, RA8875_HSTR, RA8875_HPWR,
+		RA8875_VDHR0, RA8875_VDHR1, RA8875_VNDR0, RA8875_VNDR1, RA8875_VSTR0, RA8875_VSTR1, RA8875_VPWR};
+	for (int i = 0; i < 15; i++) {
+		CHECK_EQ(ra.reg[regs[i]], Panel::timing[i]);
+		CHECK_EQ(ra.writes[regs[i]], 1);
+	}
+	CHECK_EQ(ra.reg[RA8875_SYSR], 0x0C);
+
+	// the active window is the full screen
+	CHECK_EQ(ra.reg[RA8875_HSAW0] | ra.reg[RA8875_HSAW1] << 8, 0);
+	CHECK_EQ(ra.reg[RA8875_HEAW0] | ra.reg[RA8875_HEAW1] << 8, Panel::width - 1);
+	CHECK_EQ(ra.reg[RA8875_VSAW0] | ra.reg[RA8875_VSAW1] << 8, 0);
+	CHECK_EQ(ra.reg[RA8875_VEAW0] | ra.reg[RA8875_VEAW1] << 8, Panel::height - 1);
+
+	// reset, PLL, pixel clock, then the rest, memory cleared before display on
+	int reset = ra_find(RA8875_PWRR, RA8875_PWRR_SOFTRESET);
+	CHECK_EQ(reset, 0);
+	CHECK(ra_find(RA8875_PWRR, RA8875_PWRR_NORMAL) == 1);
+	CHECK(first(RA8875_PLLC1) < first(RA8875_PLLC2));
+	CHECK(first(RA8875_PLLC2) < first(RA8875_PCSR));
+	CHECK(first(RA8875_PCSR) < first(RA8875_SYSR));
+	CHECK(first(RA8875_VEAW1) < first(RA8875_MCLR));
+	CHECK(first(RA8875_MCLR) < ra_find(RA8875_PWRR, RA8875_PWRR_NORMAL | RA8875_PWRR_DISPON));
+	CHECK_EQ(ra.reg[RA8875_P1DCR], 255);
+	CHECK_EQ(ra.reg[RA8875_FNCR1], 1 << 6);
+
+	// 1 ms after the reset and 1 ms for the PLL, the clear is polled
+	CHECK_EQ(host_hal.tick, 2);
+	CHECK_EQ(ra.status, 1);
+	CHECK_EQ(ra.reads, 0);
+
+	// one transaction per register and the one status read: a data cycle
+	// runs until CS rises, so registers can't share a frame
+	CHECK_EQ(ra.transactions, ra.nlog + ra.status);
+	CHECK_EQ(ra.nlog, 37);
+	CHECK_EQ(ra.transactions, 38);
+	printf("%ux%u: %u writes, %lu transactions, %lu bytes, %lu ms\n", Panel::width, Panel::height,
+		ra.nlog, (unsigned long)ra.transactions, (unsigned long)ra.bytes, (unsigned long)host_hal.tick);
+}
+
+int main(void)
+{
+	check_panel<Panel480x272>();
+	check_panel<Panel800x480>();
+	TEST_END();
+}
@@ -0,0 +1,99 @@
+// Touch-to-photon latency: the microsecond clock, the histogram and its
+// summary, and the dump going out a line at a time as the log has room
+
+#include "stm32l1xx_hal.h"
+#include "hal_host.h"
+#include "Latency.h"
+#include "test.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// the log, with room for one line at a time so the dump has to wait
+static char out[8192];
+static int nout, lines, space;
+
+int log_printf(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(out + nout, sizeof(out) - nout, fmt, args);
+    va_end(args);
+    nout += n;
+    lines++;
+    space = 0;
+    return n;
+}
+
+int log_space(void)
+{
+    // the TX interrupt empties it between polls
+    if(space < 1024) space += 256;
+    return space;
+}
+
+// a stamp d us ago, with SysTick at 32MHz
+static uint32_t ago(uint32_t d)
+{
+    uint32_t now = 100000000 + 777;
+    return now - d;
+}
+
+int main(void)
+{
+    host_reset();
+
+    // tick plus the part of the ms SysTick has counted down
+    SysTick->LOAD = 31999;
+    host_hal.tick = 5;
+    SysTick->VAL = 31999;
+    CHECK_EQ(latency_now_us(), 5000);
+    SysTick->VAL = 16000;
+    CHECK_EQ(latency_now_us(), 5499);
+    SysTick->VAL = 0;
+    CHECK_EQ(latency_now_us(), 5999);
+    // the same at the idle clock
+    SysTick->LOAD = 2096;
+    SysTick->VAL = 1048;
+    CHECK_EQ(latency_now_us(), 5499);
+
+    // 100000.777 ms
+    SysTick->LOAD = 31999;
+    host_hal.tick = 100000;
+    SysTick->VAL = 31999 - 777 * 32;
+    CHECK_EQ(latency_now_us(), 100000000 + 777);
+
+    struct latency_stats s;
+    latency_get(&s);
+    CHECK_EQ(s.count, 0);
+    latency_dump();
+    CHECK_EQ(nout, 0);
+
+    // 98 quick ones, one slow, one off the scale
+    for (int i = 0; i < 98; i++) latency_record(ago(1000 + i));
+    latency_record(ago(9000));
+    latency_record(ago(LATENCY_BUCKET_US * LATENCY_BUCKETS + 5000));
+    latency_get(&s);
+    CHECK_EQ(s.count, 100);
+    CHECK_EQ(s.min, 1000);
+    CHECK_EQ(s.max, LATENCY_BUCKET_US * LATENCY_BUCKETS + 5000);
+    CHECK_EQ(s.avg, (98 * 1000 + 97 * 98 / 2 + 9000 + s.max) / 100);
+    // the 99th of 100 is the slow one, given as its bucket's upper edge
+    CHECK_EQ(s.p99, (9000 / LATENCY_BUCKET_US + 1) * LATENCY_BUCKET_US);
+
+    // summary and one line per bucket in use, each waited for
+    latency_dump();
+    CHECK_EQ(lines, 1 + 1 + 1 + 1);
+    CHECK(strstr(out, "touch->pixel: n 100, min 1000,") == out);
+    CHECK(strstr(out, "   1000- 1250 us: 98\r\n") != 0);
+    CHECK(strstr(out, "   9000- 9250 us: 1\r\n") != 0);
+    CHECK(strstr(out, "  15750+      us: 1\r\n") != 0);
+
+    latency_reset();
+    latency_get(&s);
+    CHECK_EQ(s.count, 0);
+    CHECK_EQ(s.max, 0);
+
+    TEST_END();
+}
@@ -0,0 +1,106 @@
+// Text layout from the tracked cursor: \n, \r, \t and word wrap land the
+// characters where the chip would put them, with no register reads
+
+#include "ra8875_model.h"
+#include "test.h"
+
+static SPI_HandleTypeDef hspi;
+static RA8875T<Panel800x480> d(&hspi, GPIOA, GPIO_PIN_4);
+
+// row r of the screen from column c, n characters
+static bool at(int r, int c, const char *s)
+{
+	return memcmp(&ra.text[r][c], s, strlen(s)) == 0;
+}
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+	uint16_t x, y;
+
+	// control characters anywhere in the string
+	ra_count();
+	d.setCursor(0, 0);
+	d.printf("ab\ncd\r\tX\nef");
+	CHECK(at(0, 0, "ab"));
+	CHECK(at(1, 0, "cd"));
+	CHECK(at(1, 8, "X"));
+	CHECK(at(2, 0, "ef"));
+	d.getCursor(&x, &y);
+	CHECK_EQ(x, 2 * 8);
+	CHECK_EQ(y, 2 * 16);
+	CHECK_EQ(ra.reads, 0);
+
+	// a word that does not fit goes to the next line, spaces at the break dropped
+	char s[120];
+	memset(s, 'x', 95);
+	strcpy(s + 95, " hello  world");
+	d.setCursor(0, 4 * 16);
+	d.printf("%s", s);
+	CHECK_EQ(ra.text[4][94], 'x');
+	CHECK_EQ(ra.text[4][95], 0);
+	CHECK(at(5, 0, "hello  world"));
+	d.getCursor(&x, &y);
+	CHECK_EQ(x, 12 * 8);
+	CHECK_EQ(y, 5 * 16);
+
+	// a word longer than a line is split
+	memset(s, 'y', 110);
+	s[110] = 0;
+	d.setCursor(0, 7 * 16);
+	d.printf("%s", s);
+	CHECK_EQ(ra.text[7][99], 'y');
+	CHECK(at(8, 0, "yyyyyyyyyy"));
+	CHECK_EQ(ra.text[8][10], 0);
+
+	// a multi line overlay: the cursor is written once per line, nothing read
+	ra_count();
+	d.setCursor(0, 10 * 16);
+	d.printf("one\ntwo\nthree\n");
+	CHECK(at(10, 0, "one") && at(11, 0, "two") && at(12, 0, "three"));
+	CHECK_EQ(ra.reads, 0);
+	CHECK_EQ(ra.writes[RA8875_F_CURYL], 3);
+	printf("3 line overlay: %lu transactions, %lu reads\n", (unsigned long)ra.transactions, (unsigned long)ra.reads);
+
+	// off the bottom back to the top
+	d.setCursor(0, 29 * 16);
+	d.printf("z\nw");
+	CHECK(at(29, 0, "z"));
+	CHECK(at(0, 0, "w"));
+
+	// the chip is only read on demand
+	ra_count();
+	d.syncCursor();
+	CHECK_EQ(ra.reads, 4);
+	d.getCursor(&x, &y);
+	CHECK_EQ(x, 8);
+	CHECK_EQ(y, 0);
+
+	// under a clip rect the chip wraps within the active window, so lines
+	// run between its edges: 10 columns from column 20, 4 rows from row 20
+	d.setClipRect(160, 320, 80, 64);
+	d.setCursor(160, 320);
+	d.printf("one two three four\nfive\tsix");
+	CHECK(at(20, 20, "one two"));
+	CHECK(at(21, 20, "three four"));
+	CHECK_EQ(ra.text[21][30], 0);
+	CHECK(at(22, 20, "five"));
+	CHECK(at(23, 20, "six"));
+	d.getCursor(&x, &y);
+	CHECK_EQ(x, 160 + 3 * 8);
+	CHECK_EQ(y, 23 * 16);
+	CHECK_EQ(ra_reg16(RA8875_F_CURXL), x);	// where the chip has it
+	CHECK_EQ(ra_reg16(RA8875_F_CURYL), y);
+	// off the bottom of the clip rect back to its top
+	d.printf("\nA\nB");
+	CHECK_EQ(ra.text[20][20], 'A');
+	CHECK_EQ(ra.text[21][20], 'B');
+	d.getCursor(&x, &y);
+	CHECK_EQ(ra_reg16(RA8875_F_CURXL), x);
+	CHECK_EQ(ra_reg16(RA8875_F_CURYL), y);
+	d.clearClipRect();
+
+	TEST_END();
+}
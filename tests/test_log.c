@@ -0,0 +1,95 @@
+// Log ring: what goes in comes out of the TX interrupt in order, a line
+// that doesn't fit is dropped whole and reported in the next one
+
+#include "stm32l1xx_hal.h"
+#include "hal_host.h"
+#include "Log.h"
+#include "irq_priority.h"
+#include "test.h"
+
+#include <string.h>
+
+static char out[4096];
+static int nout;
+
+// what the UART would send, with TXE always set
+static void drain(void)
+{
+    USART1->SR = USART_SR_TXE | USART_SR_TC;
+    while(USART1_TXEIE) {
+        USART1->DR = 0x100;
+        log_tx_irq();
+        if(USART1->DR != 0x100) out[nout++] = USART1->DR;
+    }
+    out[nout] = 0;
+}
+
+int main(void)
+{
+    host_reset();
+    log_init();
+    CHECK_EQ(host_hal.prio[USART1_IRQn], IRQ_PRIO_UART);
+    CHECK(host_hal.enabled[USART1_IRQn]);
+    CHECK_EQ(log_space(), LOG_BUFFER_SIZE);
+
+    // the interrupt is started by the write and stops once empty
+    CHECK_EQ(log_write("hello\r\n", 7), 7);
+    CHECK(USART1_TXEIE);
+    CHECK_EQ(log_space(), LOG_BUFFER_SIZE - 7);
+    CHECK_EQ(log_printf("%d+%d=%d\r\n", 1, 2, 3), 7);
+    CHECK_EQ(log_write("", 0), 0);
+    drain();
+    CHECK(strcmp(out, "hello\r\n1+2=3\r\n") == 0);
+    CHECK(!USART1_TXEIE);
+    CHECK_EQ(log_space(), LOG_BUFFER_SIZE);
+
+    // fill it to the byte across the wrap of the indices
+    char line[100];
+    memset(line, 'a', sizeof(line));
+    nout = 0;
+    int n = 0;
+    while(log_space() >= (int)sizeof(line)) n += log_write(line, sizeof(line));
+    int rest = log_space();
+    CHECK_EQ(log_write(line, rest), rest);
+    n += rest;
+    CHECK_EQ(log_space(), 0);
+    CHECK_EQ(n, LOG_BUFFER_SIZE);
+
+    // full, the whole line goes and nothing of it gets in
+    CHECK_EQ(log_write("lost line\r\n", 11), 0);
+    CHECK_EQ(log_printf("%s", "lost too\r\n"), 0);
+    CHECK_EQ(log_get_dropped(), 2);
+    drain();
+    CHECK_EQ(nout, LOG_BUFFER_SIZE);
+    for (int i = 0; i < nout; i++) CHECK(out[i] == 'a');
+
+    // the next line tells how much was lost, once
+    nout = 0;
+    CHECK_EQ(log_write("next\r\n", 6), 6);
+    CHECK_EQ(log_write("after\r\n", 7), 7);
+    drain();
+    CHECK(strcmp(out, "<21 bytes dropped>\r\nnext\r\nafter\r\n") == 0);
+
+    // a report that doesn't fit either keeps adding up
+    nout = 0;
+    memset(line, 'b', sizeof(line));
+    while(log_space() >= (int)sizeof(line)) log_write(line, sizeof(line));
+    log_write(line, log_space());
+    CHECK_EQ(log_write("x\r\n", 3), 0);
+    CHECK_EQ(log_write(line, 1), 0);
+    drain();
+    nout = 0;
+    CHECK_EQ(log_write("y\r\n", 3), 3);
+    drain();
+    CHECK(strcmp(out, "<4 bytes dropped>\r\ny\r\n") == 0);
+    CHECK_EQ(log_get_dropped(), 4);
+
+    // polled flush for fault handlers
+    nout = 0;
+    log_write("fault\r\n", 7);
+    log_flush();
+    CHECK(!USART1_TXEIE);
+    CHECK_EQ(log_space(), LOG_BUFFER_SIZE);
+
+    TEST_END();
+}
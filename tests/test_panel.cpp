@@ -0,0 +1,82 @@
+// RA8875T<Panel> against the run time RA8875: the same registers on the
+// same bus, sizes and clamping from the traits
+
+#include "ra8875_model.h"
+#include "test.h"
+
+static_assert(Panel800x480::width == 800 && Panel800x480::height == 480, "800x480");
+static_assert(PanelAdafruit480x272::width == 480 && PanelAdafruit480x272::size == Adafruit_480x272, "adafruit");
+static_assert(PanelRuntime::width == 0, "run time panel reads _width");
+
+static SPI_HandleTypeDef hspi;
+
+// register writes of a begin(), kept to compare with another
+struct Trace {
+	uint16_t n;
+	struct { uint8_t reg, val; } log[512];
+	uint32_t transactions, bytes;
+};
+
+static void keep(Trace &t)
+{
+	t.n = ra.nlog;
+	memcpy(t.log, ra.log, sizeof(t.log));
+	t.transactions = ra.transactions;
+	t.bytes = ra.bytes;
+}
+
+static bool same(const Trace &a, const Trace &b)
+{
+	return a.n == b.n && memcmp(a.log, b.log, a.n * sizeof(a.log[0])) == 0 &&
+		a.transactions == b.transactions && a.bytes == b.bytes;
+}
+
+static Trace fixed, runtime;
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	RA8875T<Panel800x480> d8(&hspi, GPIOA, GPIO_PIN_4);
+	d8.begin();
+	keep(fixed);
+	CHECK_EQ(d8.width(), 800);
+	CHECK_EQ(d8.height(), 480);
+
+	ra_reset();
+	RA8875 r8(&hspi, GPIOA, GPIO_PIN_4);
+	r8.begin(RA8875_800x480);
+	keep(runtime);
+	CHECK_EQ(r8.width(), 800);
+	CHECK_EQ(r8.height(), 480);
+	CHECK(same(fixed, runtime));
+
+	ra_reset();
+	RA8875T<Panel480x272> d4(&hspi, GPIOA, GPIO_PIN_4);
+	d4.begin();
+	keep(fixed);
+	ra_reset();
+	RA8875 r4(&hspi, GPIOA, GPIO_PIN_4);
+	r4.begin(RA8875_480x272);
+	keep(runtime);
+	CHECK_EQ(r4.width(), 480);
+	CHECK_EQ(r4.height(), 272);
+	CHECK(same(fixed, runtime));
+
+	// only the Adafruit boards turn on GPIOX
+	CHECK(ra_find(RA8875_GPIOX, 1) < 0);
+	ra_reset();
+	RA8875T<PanelAdafruit800x480> da(&hspi, GPIOA, GPIO_PIN_4);
+	da.begin();
+	CHECK(ra_find(RA8875_GPIOX, 1) >= 0);
+
+	// the cursor is clamped to the panel, a constant here, _width at run time
+	ra_count();
+	d8.setX(900);
+	CHECK_EQ(ra.reg[RA8875_CURH0] | ra.reg[RA8875_CURH1] << 8, 799);
+	ra_count();
+	r4.setX(900);
+	CHECK_EQ(ra.reg[RA8875_CURH0] | ra.reg[RA8875_CURH1] << 8, 479);
+
+	TEST_END();
+}
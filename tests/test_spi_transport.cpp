@@ -0,0 +1,156 @@
+// SpiTransport against recording registers: bytes in order inside CS,
+// the instance and pin it was given, lock step reads, the receive side
+// drained after a write. Then the cost of a register write through it
+// against HAL_GPIO_WritePin and HAL_SPI_Transmit, both on the same
+// register file, as writeReg with RA8875_FAST_SPI 1 and 0
+
+#include "stm32l1xx_hal.h"
+#include "SpiTransport.h"
+#include "test.h"
+
+#include <string.h>
+#include <time.h>
+
+// the HAL as built for the target, renamed by the Makefile
+extern "C" HAL_StatusTypeDef stm_HAL_SPI_Transmit(SPI_HandleTypeDef *h, uint8_t *tx, uint16_t len, uint32_t timeout);
+extern "C" void stm_HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+
+// bus events: bytes written, CS_LOW/CS_HIGH with the pin
+enum { CS_LOW = 0x10000, CS_HIGH = 0x20000 };
+static uint32_t ev[64];
+static int nev;
+static bool rx_full, ovr, dr_read;
+static uint8_t rx_next;
+static int overruns;
+
+static uint32_t cr1;
+
+struct MockSpi {
+	struct Status {
+		// reading DR then SR clears the overrun flag
+		operator uint32_t() const {
+			uint32_t v = SPI_SR_TXE | (rx_full ? SPI_SR_RXNE : 0) | (ovr ? SPI_SR_OVR : 0);
+			if (dr_read) ovr = false;
+			dr_read = false;
+			return v;
+		}
+	} SR;
+	struct Data {
+		void operator=(uint32_t v) {
+			if (!(cr1 & SPI_CR1_SPE)) return; // lost while off
+			if (rx_full) overruns++, ovr = true;
+			ev[nev++] = v;
+			rx_full = true;
+			dr_read = false;
+		}
+		operator uint32_t() { rx_full = false; dr_read = true; return rx_next++; }
+	} DR;
+	struct Control {
+		operator uint32_t() const { return cr1; }
+		void operator|=(uint32_t b) { cr1 |= b; }
+	} CR1;
+};
+
+struct MockGpio {
+	struct SetReset {
+		void operator=(uint32_t v) { ev[nev++] = (v >> 16) ? CS_LOW | (v >> 16) : CS_HIGH | v; }
+	} BSRR;
+};
+
+int main(void)
+{
+	MockSpi spi;
+	MockGpio port;
+	SpiTransport<MockSpi, MockGpio> t(&spi, &port, GPIO_PIN_7);
+
+	// a register write: CS around the 4 bytes, the SPI enabled on the way
+	const uint8_t reg[] = { 0x80, 0x40, 0x00, 0x12 };
+	t.select();
+	t.write(reg, 4);
+	t.deselect();
+	CHECK(cr1 & SPI_CR1_SPE);
+	CHECK_EQ(nev, 6);
+	CHECK_EQ(ev[0], CS_LOW | GPIO_PIN_7);
+	for (int i = 0; i < 4; i++) CHECK_EQ(ev[1 + i], reg[i]);
+	CHECK_EQ(ev[5], CS_HIGH | GPIO_PIN_7);
+	// transmit only overruns the receive side, the drain leaves it empty
+	// and the overrun flag cleared
+	CHECK_EQ(overruns, 3);
+	CHECK(!rx_full);
+	CHECK(!ovr);
+
+	// a read, every byte sent is answered before the next one goes
+	nev = 0;
+	overruns = 0;
+	rx_next = 0xA0;
+	const uint8_t rd[] = { 0x80, 0x41, 0x40, 0x00 };
+	uint8_t in[4];
+	t.select();
+	t.transfer(rd, in, 4);
+	t.deselect();
+	CHECK_EQ(overruns, 0);
+	CHECK_EQ(nev, 6);
+	for (int i = 0; i < 4; i++) {
+		CHECK_EQ(ev[1 + i], rd[i]);
+		CHECK_EQ(in[i], 0xA0 + i);
+	}
+	CHECK(!rx_full);
+
+	// a second transport, on its own pin, finds its SPI already on
+	MockGpio port2;
+	SpiTransport<MockSpi, MockGpio> t2(&spi, &port2, GPIO_PIN_12);
+	cr1 = SPI_CR1_SPE | SPI_CR1_MSTR;
+	nev = 0;
+	t2.select();
+	t2.write(reg, 1);
+	t2.deselect();
+	CHECK_EQ(nev, 3);
+	CHECK_EQ(ev[0], CS_LOW | GPIO_PIN_12);
+	CHECK_EQ(ev[1], reg[0]);
+	CHECK_EQ(ev[2], CS_HIGH | GPIO_PIN_12);
+	CHECK_EQ(cr1, SPI_CR1_SPE | SPI_CR1_MSTR);
+	CHECK(!rx_full);
+
+	// benchmark: 4 byte register writes on a register file that is always
+	// ready, so only the code around the bytes is timed
+	static SPI_TypeDef regs;
+	static GPIO_TypeDef gpio;
+	regs.SR = SPI_SR_TXE | SPI_SR_RXNE;
+	regs.CR1 = SPI_CR1_SPE | SPI_CR1_MSTR;
+	SpiTransport<> fast(&regs, &gpio, GPIO_PIN_4);
+	SPI_HandleTypeDef h;
+	memset(&h, 0, sizeof(h));
+	h.Instance = &regs;
+	h.Init.Mode = SPI_MODE_MASTER;
+	h.Init.Direction = SPI_DIRECTION_2LINES;
+	h.Init.DataSize = SPI_DATASIZE_8BIT;
+	h.Init.CRCCalculation = SPI_CRCCALCULATION_DISABLED;
+	h.State = HAL_SPI_STATE_READY;
+	uint8_t buf[4] = { 0x80, 0x40, 0x00, 0x12 };
+	const int N = 1000000;
+	struct timespec t0, t1, t3;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (int i = 0; i < N; i++) {
+		buf[3] = i;
+		fast.select();
+		fast.write(buf, 4);
+		fast.deselect();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	int failed = 0;
+	for (int i = 0; i < N; i++) {
+		buf[3] = i;
+		stm_HAL_GPIO_WritePin(&gpio, GPIO_PIN_4, GPIO_PIN_RESET);
+		failed += stm_HAL_SPI_Transmit(&h, buf, 4, 100) != HAL_OK;
+		stm_HAL_GPIO_WritePin(&gpio, GPIO_PIN_4, GPIO_PIN_SET);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t3);
+	CHECK_EQ(failed, 0);
+	CHECK_EQ(regs.DR, (uint8_t)(N - 1));
+	double f = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / N;
+	double s = ((t3.tv_sec - t1.tv_sec) * 1e9 + (t3.tv_nsec - t1.tv_nsec)) / N;
+	printf("register write: transport %.1f ns, HAL %.1f ns on the host, %.1fx\n", f, s, s / f);
+	CHECK(f < s);
+
+	TEST_END();
+}
@@ -0,0 +1,184 @@
+// StrokeRenderer smoothing: a new sample shows at once, the pieces drawn
+// stay within the tolerance of the Catmull-Rom spline through the samples,
+// and what a sample costs in pieces and in time. Circles sampled at a few
+// speeds stand in for the finger; the distance of the drawn center line from
+// the circle is printed against that of the plain polyline
+
+#include "test.h"
+#include "Stroke.h"
+
+#include <math.h>
+#include <time.h>
+
+// keeps the center line of each piece, from its two triangles, and the caps
+struct Lines {
+	struct Piece { int16_t x0, y0, x1, y1; };
+	Piece pieces[2048];
+	int n, triangles, caps;
+	int16_t capX, capY;
+
+	void fillCircle(int16_t x0, int16_t y0, int16_t, uint16_t) {
+		caps++;
+		capX = x0;
+		capY = y0;
+	}
+	// segment() sends x0+o,x1+o,x1-o then x0+o,x1-o,x0-o
+	void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t) {
+		if (triangles++ & 1) {
+			if (n < 2048) pieces[n].x0 = (x0 + x2) / 2, pieces[n].y0 = (y0 + y2) / 2;
+			n++;
+		} else if (n < 2048) {
+			pieces[n].x1 = (x1 + x2) / 2;
+			pieces[n].y1 = (y1 + y2) / 2;
+		}
+	}
+	void clear() { n = triangles = caps = 0; }
+};
+
+static Lines lines;
+
+static const double R = 150, CX = 400, CY = 240;
+
+static void at(int i, int per_turn, int16_t &x, int16_t &y)
+{
+	x = (int16_t)lround(CX + R * cos(i * 2 * M_PI / per_turn));
+	y = (int16_t)lround(CY + R * sin(i * 2 * M_PI / per_turn));
+}
+
+// the spline through one turn in floating point, ends repeated like the renderer
+static double ref_x[8192], ref_y[8192];
+static int nref;
+
+static void reference(int per_turn)
+{
+	nref = 0;
+	for (int i = 0; i + 1 < per_turn; i++) {
+		int16_t x[4], y[4];
+		for (int k = 0; k < 4; k++) {
+			int j = i - 1 + k;
+			at(j < 0 ? 0 : j >= per_turn ? per_turn - 1 : j, per_turn, x[k], y[k]);
+		}
+		for (int k = 0; k < 64 && nref < 8192; k++, nref++) {
+			double t = k / 64.0, t2 = t * t, t3 = t2 * t;
+			double a = -t3 + 2 * t2 - t, b = 3 * t3 - 5 * t2 + 2, c = -3 * t3 + 4 * t2 + t, e = t3 - t2;
+			ref_x[nref] = (a * x[0] + b * x[1] + c * x[2] + e * x[3]) / 2;
+			ref_y[nref] = (a * y[0] + b * y[1] + c * y[2] + e * y[3]) / 2;
+		}
+	}
+}
+
+// distance of x,y from the segment a-b
+static double to_segment(double x, double y, double ax, double ay, double bx, double by)
+{
+	double dx = bx - ax, dy = by - ay, l = dx * dx + dy * dy;
+	double t = l == 0 ? 0 : fmax(0, fmin(1, ((x - ax) * dx + (y - ay) * dy) / l));
+	return hypot(x - ax - t * dx, y - ay - t * dy);
+}
+
+// largest distance of the pieces drawn, at their ends and middles, from the
+// circle or from the reference spline
+static double error(bool spline)
+{
+	double e = 0;
+	for (int i = 0; i < lines.n && i < 2048; i++) {
+		const Lines::Piece &p = lines.pieces[i];
+		for (int k = 0; k <= 2; k++) {
+			double x = p.x0 + (p.x1 - p.x0) * k / 2.0, y = p.y0 + (p.y1 - p.y0) * k / 2.0;
+			double d = spline ? 1e9 : fabs(hypot(x - CX, y - CY) - R);
+			for (int j = 1; spline && j < nref; j++) d = fmin(d, to_segment(x, y, ref_x[j - 1], ref_y[j - 1], ref_x[j], ref_y[j]));
+			e = fmax(e, d);
+		}
+	}
+	return e;
+}
+
+// one turn sampled per_turn times, the error with and without smoothing
+static void turn(int per_turn)
+{
+	double e[2], off = 0;
+	int pieces[2];
+	for (int smooth = 0; smooth < 2; smooth++) {
+		StrokeRenderer<Lines, 1> s(40, 0, smooth);
+		lines.clear();
+		for (int i = 0; i < per_turn; i++) {
+			int16_t x, y;
+			at(i, per_turn, x, y);
+			s.add(&lines, 0, x, y, 0);
+			s.endReport(&lines);
+		}
+		e[smooth] = error(false);
+		pieces[smooth] = lines.n;
+		if (smooth) {
+			reference(per_turn);
+			off = error(true);
+		}
+	}
+	printf("%3d samples a turn (%5.1f px apart): polyline %3d pieces %4.1f px off the circle, spline %3d pieces %4.1f px off, %4.2f px off the spline\n",
+		per_turn, 2 * M_PI * R / per_turn, pieces[0], e[0], pieces[1], e[1], off);
+	// within the tolerance and the rounding of the pieces to pixels
+	CHECK(off <= STROKE_TOLERANCE / 16.0 + 1.0);
+	CHECK(e[1] <= e[0] + 0.5);
+	CHECK(pieces[1] <= (per_turn - 1) * STROKE_MAX_PIECES);
+}
+
+// time per sample of the smoothing itself, drawing to nothing
+static void speed(void)
+{
+	const int N = 200000;
+	StrokeRenderer<Lines, 1> s(40, 0);
+	lines.clear();
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (int i = 0; i < N; i++) {
+		int16_t x, y;
+		at(i, 24, x, y);
+		s.add(&lines, 0, x, y, 0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / N;
+	printf("spline: %.0f ns a sample on the host, %.2f pieces a sample at 24 a turn\n", ns, (double)lines.n / N);
+}
+
+int main(void)
+{
+	// the second sample shows before the third arrives: its cap, no piece yet
+	StrokeRenderer<Lines, 4> s(40, 4);
+	lines.clear();
+	s.add(&lines, 1, 100, 100, 0);
+	s.endReport(&lines);
+	CHECK_EQ(lines.caps, 1);
+	s.add(&lines, 1, 130, 110, 0);
+	s.endReport(&lines);
+	CHECK_EQ(lines.caps, 2);
+	CHECK_EQ(lines.capX, 130);
+	CHECK_EQ(lines.capY, 110);
+	CHECK_EQ(lines.n, 0);
+	// the third draws the curve up to the second, capped between its pieces
+	// but not again at the second
+	s.add(&lines, 1, 160, 100, 0);
+	int n = lines.n;
+	CHECK(n >= 1);
+	CHECK_EQ(lines.caps, 3 + n - 1);
+	CHECK_EQ(lines.pieces[0].x0, 100);
+	CHECK_EQ(lines.pieces[n - 1].x1, 130);
+	CHECK_EQ(lines.pieces[n - 1].y1, 110);
+	// the lift draws the last of the curve
+	s.endReport(&lines);
+	s.endReport(&lines);
+	CHECK(lines.n > n);
+	CHECK_EQ(lines.pieces[lines.n - 1].x1, 160);
+	CHECK_EQ(lines.caps, 3 + lines.n - 2);
+
+	// a straight run is a piece per sample
+	lines.clear();
+	for (int i = 0; i < 10; i++) s.add(&lines, 0, 100 + 20 * i, 300, 0);
+	CHECK_EQ(lines.n, 8);
+
+	turn(12);
+	turn(24);
+	turn(60);
+	turn(120);
+	speed();
+
+	TEST_END();
+}
@@ -0,0 +1,187 @@
+// StrokeRenderer against a circle per sample onto the RA8875 model, on touch
+// traces like the GSL1680 reports: a slow drag, a fast swipe, a circle and
+// five fingers. The strokes leave no gap along the path, the dots do when the
+// finger outruns them; engine operations and bytes of both are printed. A
+// segment is three operations, so the strokes only cost less than the dots
+// where the skip distance drops more than two samples in three
+
+#include "ra8875_model.h"
+#include "test.h"
+#include "Stroke.h"
+
+#include <math.h>
+
+typedef RA8875T<Panel800x480> Display;
+
+static SPI_HandleTypeDef spi;
+
+// the display, keeping the shapes asked for to check what they cover
+struct Recorder : Display {
+	Recorder() : Display(&spi, GPIOA, GPIO_PIN_4) {}
+	struct Shape {
+		uint8_t triangle;
+		int16_t x[3], y[3], r;
+	};
+	Shape shapes[4096];
+	int n;
+
+	void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+		if (n < 4096) shapes[n] = {0, {x0}, {y0}, r};
+		n++;
+		Display::fillCircle(x0, y0, r, color);
+	}
+	void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
+		if (n < 4096) shapes[n] = {1, {x0, x1, x2}, {y0, y1, y2}, 0};
+		n++;
+		Display::fillTriangle(x0, y0, x1, y1, x2, y2, color);
+	}
+};
+
+static Recorder d;
+
+static double cross(double ax, double ay, double bx, double by, double x, double y)
+{
+	return (bx - ax) * (y - ay) - (by - ay) * (x - ax);
+}
+
+// x,y is inside one of the shapes, with half a pixel to spare for rounding
+static bool covered(double x, double y)
+{
+	for (int i = 0; i < d.n && i < 4096; i++) {
+		const Recorder::Shape &s = d.shapes[i];
+		if (!s.triangle) {
+			double r = s.r + 0.5;
+			if ((x - s.x[0]) * (x - s.x[0]) + (y - s.y[0]) * (y - s.y[0]) <= r * r) return true;
+			continue;
+		}
+		double a = cross(s.x[0], s.y[0], s.x[1], s.y[1], s.x[2], s.y[2]);
+		if (a == 0) continue;
+		bool in = true;
+		for (int k = 0; k < 3 && in; k++) {
+			int j = (k + 1) % 3;
+			double l = hypot(s.x[j] - s.x[k], s.y[j] - s.y[k]);
+			in = (a > 0 ? 1 : -1) * cross(s.x[k], s.y[k], s.x[j], s.y[j], x, y) / l >= -0.5;
+		}
+		if (in) return true;
+	}
+	return false;
+}
+
+struct Trace {
+	const char *name;
+	int fingers, reports;
+	void (*at)(int report, int finger, int16_t &x, int16_t &y);
+};
+
+static void slow(int i, int, int16_t &x, int16_t &y) { x = 100 + 2 * i; y = 240; }
+static void fast(int i, int, int16_t &x, int16_t &y) { x = 20 + 45 * i; y = 100 + 18 * i; }
+static void circle(int i, int, int16_t &x, int16_t &y)
+{
+	x = (int16_t)lround(400 + 150 * cos(i * 2 * M_PI / 60));
+	y = (int16_t)lround(240 + 150 * sin(i * 2 * M_PI / 60));
+}
+static void five(int i, int f, int16_t &x, int16_t &y) { x = 100 + 8 * i; y = 60 + 90 * f; }
+
+static const Trace traces[] = {
+	{"slow drag", 1, 150, slow},
+	{"fast swipe", 1, 17, fast},
+	{"circle", 1, 61, circle},
+	{"five fingers", 5, 80, five},
+};
+
+// points along the path of each finger not covered by what was drawn
+static int gaps(const Trace &t)
+{
+	int n = 0;
+	for (int f = 0; f < t.fingers; f++) {
+		for (int i = 1; i < t.reports; i++) {
+			int16_t x0, y0, x1, y1;
+			t.at(i - 1, f, x0, y0);
+			t.at(i, f, x1, y1);
+			for (int k = 0; k < 8; k++) {
+				if (!covered(x0 + (x1 - x0) * k / 8.0, y0 + (y1 - y0) * k / 8.0)) n++;
+			}
+		}
+	}
+	return n;
+}
+
+struct Cost {
+	int ops, gaps;
+	uint32_t bytes;
+};
+
+static Cost dots(const Trace &t)
+{
+	ra_count();
+	d.n = 0;
+	for (int i = 0; i < t.reports; i++) {
+		for (int f = 0; f < t.fingers; f++) {
+			int16_t x, y;
+			t.at(i, f, x, y);
+			d.fillCircle(x, y, 20, RA8875_CYAN);
+		}
+	}
+	return {d.n, gaps(t), ra.bytes};
+}
+
+static Cost strokes(const Trace &t, uint8_t minDist)
+{
+	StrokeRenderer<Recorder, 16> s(40, minDist, false);
+	ra_count();
+	d.n = 0;
+	for (int i = 0; i < t.reports; i++) {
+		for (int f = 0; f < t.fingers; f++) {
+			int16_t x, y;
+			t.at(i, f, x, y);
+			s.add(&d, f, x, y, RA8875_CYAN);
+		}
+		s.endReport(&d);
+	}
+	s.endReport(&d);
+	return {d.n, gaps(t), ra.bytes};
+}
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+
+	for (unsigned i = 0; i < sizeof(traces) / sizeof(traces[0]); i++) {
+		const Trace &t = traces[i];
+		Cost c = dots(t), s4 = strokes(t, 4), s10 = strokes(t, 10);
+		printf("%-12s %3d samples: dots %4d ops %6lu bytes %3d gaps, strokes min 4 px %4d ops %6lu bytes, min 10 px %4d ops %6lu bytes\n",
+			t.name, t.fingers * t.reports, c.ops, (unsigned long)c.bytes, c.gaps,
+			s4.ops, (unsigned long)s4.bytes, s10.ops, (unsigned long)s10.bytes);
+		CHECK_EQ(s4.gaps, 0);
+		CHECK_EQ(s10.gaps, 0);
+		// a finger slower than the skip distance costs less than the dots
+		if (t.at == slow) CHECK(s10.ops < c.ops && s10.bytes < c.bytes);
+	}
+	// the swipe outruns the 40 pixel dots
+	CHECK(dots(traces[1]).gaps > 0);
+
+	// a skipped sample draws nothing, a lifted finger starts over with a dot
+	StrokeRenderer<Recorder, 16> s(40, 10, false);
+	ra_count();
+	d.n = 0;
+	s.add(&d, 2, 100, 100, RA8875_RED);
+	CHECK_EQ(d.n, 1);
+	s.endReport(&d);
+	s.add(&d, 2, 105, 100, RA8875_RED);
+	CHECK_EQ(d.n, 1);
+	s.endReport(&d);
+	s.add(&d, 2, 130, 100, RA8875_RED);
+	CHECK_EQ(d.n, 4);
+	s.endReport(&d);
+	s.endReport(&d);
+	s.add(&d, 2, 131, 100, RA8875_RED);
+	CHECK_EQ(d.n, 5);
+	CHECK(!d.shapes[4].triangle);
+	// fingers past FINGERS are ignored
+	s.add(&d, 16, 300, 300, RA8875_RED);
+	CHECK_EQ(d.n, 5);
+
+	TEST_END();
+}
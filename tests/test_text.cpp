@@ -0,0 +1,72 @@
+// The stats block of testLcd as setCursor and printf lines: the text goes
+// out from the printf buffer behind a constant header, and the chip is put
+// in text mode once for the block, not twice per line
+
+#include "ra8875_model.h"
+#include "test.h"
+
+static SPI_HandleTypeDef hspi;
+static RA8875T<Panel800x480> d(&hspi, GPIOA, GPIO_PIN_4);
+
+static const char *lines[3] = {
+	"overflow: %6d, max_depth: %6d",
+	"time: %6lu secs, %6lu ms, i2c errors: %6lu",
+	"frame: %5lu ms",
+};
+
+// the block as testLcd draws it, returns the characters printed
+static int stats_block(void)
+{
+	int chars = 0;
+	d.setCursor(0, 0);
+	chars += d.printf(lines[0], 3, 17);
+	d.setCursor(0, 16);
+	chars += d.printf(lines[1], 1234UL, 567UL, 0UL);
+	d.setCursor(0, 32);
+	chars += d.printf(lines[2], 16UL);
+	return chars;
+}
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+
+	ra_count();
+	int chars = stats_block();
+	// the characters and nothing else into MRWC, in one transaction a line
+	CHECK_EQ(ra.pixelBytes, chars);
+	CHECK_EQ(ra.writes[RA8875_MWCR0], 1);
+	CHECK(ra.reg[RA8875_MWCR0] & 0x80);
+	// per line the 4 cursor registers, the text and one status poll
+	CHECK_EQ(ra.transactions, 1 + 3 * (4 + 1 + 1));
+	CHECK_EQ(ra.status, 3);
+	CHECK_EQ(ra.reads, 0);
+	CHECK_EQ(ra.bytes, 4 + 3 * (4 * 4 + 3 + 2) + chars);
+	printf("stats block: %d chars, %lu transactions, %lu bytes, 0 bytes copied\n",
+		chars, (unsigned long)ra.transactions, (unsigned long)ra.bytes);
+
+	// still in text mode, the next block does not switch at all
+	ra_count();
+	stats_block();
+	CHECK_EQ(ra.writes[RA8875_MWCR0], 0);
+
+	// a drawing in between switches back once, and the text once again
+	d.drawPixel(10, 200, RA8875_RED);
+	CHECK(!(ra.reg[RA8875_MWCR0] & 0x80));
+	ra_count();
+	stats_block();
+	CHECK_EQ(ra.writes[RA8875_MWCR0], 1);
+
+	// a string longer than the printf buffer is cut, not read past
+	char big[200];
+	memset(big, 'x', sizeof(big) - 1);
+	big[sizeof(big) - 1] = 0;
+	d.setCursor(0, 64);
+	ra_count();
+	CHECK_EQ(d.printf("%s", big), 131);
+	CHECK_EQ(ra.pixelBytes, 131);
+
+	TEST_END();
+}
@@ -0,0 +1,80 @@
+// TextField onto the RA8875 model: the screen ends up as a full redraw
+// would leave it, and a refresh where a counter ticks sends a fraction of
+// the bytes of rewriting the lines
+
+#include "ra8875_model.h"
+#include "test.h"
+#include "TextField.h"
+
+typedef RA8875T<Panel800x480> Display;
+
+static SPI_HandleTypeDef hspi;
+static Display d(&hspi, GPIOA, GPIO_PIN_4);
+static TextField<Display, 50> stats[3] = { {0, 0}, {0, 1}, {0, 2} };
+
+static void refresh(uint32_t t)
+{
+	stats[0].printf(&d, "overflow: %6d, max_depth: %6d", 0, 17);
+	stats[1].printf(&d, "time: %6lu secs, %6lu ms, i2c errors: %6lu", t / 1000, t, 0UL);
+	stats[2].printf(&d, "frame: %5lu ms", 16UL);
+}
+
+// the same lines rewritten in full, padded to the field
+static void rewrite(uint32_t t)
+{
+	d.setCursor(0, 0);
+	d.printf("%-50s", "overflow:      0, max_depth:     17");
+	d.setCursor(0, 16);
+	char buf[64];
+	snprintf(buf, sizeof(buf), "time: %6lu secs, %6lu ms, i2c errors: %6lu", t / 1000, t, 0UL);
+	d.printf("%-50s", buf);
+	d.setCursor(0, 32);
+	d.printf("%-50s", "frame:    16 ms");
+}
+
+static bool shows(int r, const char *s)
+{
+	return memcmp(ra.text[r], s, strlen(s)) == 0;
+}
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+
+	// the first refresh draws everything
+	ra_count();
+	refresh(2000);
+	CHECK_EQ(ra.pixelBytes, 3 * 50);
+	CHECK(shows(1, "time:      2 secs,   2000 ms, i2c errors:      0"));
+
+	// two seconds later: only the changed digits of the time line
+	ra_count();
+	refresh(4000);
+	uint32_t bytes = ra.bytes, transactions = ra.transactions;
+	CHECK(ra.pixelBytes <= 16);
+	CHECK(shows(0, "overflow:      0, max_depth:     17"));
+	CHECK(shows(1, "time:      4 secs,   4000 ms, i2c errors:      0"));
+	CHECK(shows(2, "frame:    16 ms"));
+
+	// nothing changed, nothing sent
+	ra_count();
+	refresh(4000);
+	CHECK_EQ(ra.bytes, 0);
+
+	ra_count();
+	rewrite(6000);
+	CHECK(shows(1, "time:      6 secs,   6000 ms, i2c errors:      0"));
+	printf("refresh: %lu bytes in %lu transactions, full rewrite %lu bytes in %lu transactions\n",
+		(unsigned long)bytes, (unsigned long)transactions, (unsigned long)ra.bytes, (unsigned long)ra.transactions);
+	CHECK(bytes * 5 < ra.bytes);
+
+	// after a clear the next refresh draws everything again
+	for (int i = 0; i < 3; i++) stats[i].invalidate();
+	ra_count();
+	refresh(6000);
+	CHECK_EQ(ra.pixelBytes, 3 * 50);
+
+	TEST_END();
+}
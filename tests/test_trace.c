@@ -0,0 +1,100 @@
+// Trace frames share the UART with the log text, a frame must come out
+// whole whatever the text does, and timestamps don't restart
+
+#include "stm32l1xx_hal.h"
+#include "hal_host.h"
+#include "Log.h"
+#include "Trace.h"
+#include "cycles.h"
+#include "test.h"
+
+#include <string.h>
+
+static uint8_t out[4096];
+static int nout;
+
+static int tx(int max)
+{
+    int n = 0;
+    USART1->SR = USART_SR_TXE | USART_SR_TC;
+    while(USART1_TXEIE && n < max) {
+        USART1->DR = 0x100;
+        log_tx_irq();
+        if(USART1->DR != 0x100) out[nout++] = USART1->DR, n++;
+    }
+    return n;
+}
+
+// frame at p, returns its id or -1 if it isn't a good one
+static int frame(const uint8_t *p, uint32_t *ts)
+{
+    if(p[0] != 0xA5 || p[1] != 0x5A) return -1;
+    uint8_t sum = 0;
+    for (int i = 2; i < 14; i++) sum += p[i];
+    if(sum != p[14]) return -1;
+    *ts = p[2] | p[3] << 8 | p[4] << 16 | (uint32_t)p[5] << 24;
+    return p[6] | p[7] << 8;
+}
+
+int main(void)
+{
+    host_reset();
+    log_init();
+    trace_init();
+    CHECK(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk);
+
+    // the counter keeps going when someone else asks for it
+    DWT->CYCCNT = 1000;
+    cycles_init();
+    CHECK_EQ(DWT->CYCCNT, 1000);
+
+    // a frame alone
+    TRACE(TRACE_FRAME_START, 0, 0);
+    CHECK(USART1_TXEIE);
+    tx(1000);
+    uint32_t ts;
+    CHECK_EQ(nout, 15);
+    CHECK_EQ(frame(out, &ts), TRACE_FRAME_START);
+    CHECK_EQ(ts, 1000);
+
+    // text queued while a frame is going out waits for its end
+    nout = 0;
+    DWT->CYCCNT = 2000;
+    TRACE(TRACE_PIXEL, 1, 0);
+    DWT->CYCCNT = 3000;
+    TRACE(TRACE_FRAME_END, 0, 7);
+    tx(5);
+    log_write("text\r\n", 6);
+    tx(1000);
+    CHECK_EQ(nout, 15 + 6 + 15);
+    CHECK_EQ(frame(out, &ts), TRACE_PIXEL);
+    CHECK_EQ(ts, 2000);
+    CHECK(memcmp(out + 15, "text\r\n", 6) == 0);
+    // the next frame only when the text is out
+    CHECK_EQ(frame(out + 21, &ts), TRACE_FRAME_END);
+    CHECK_EQ(ts, 3000);
+    CHECK_EQ(out[21 + 10], 7);
+
+    // text already there goes first
+    nout = 0;
+    log_write("ab", 2);
+    TRACE(TRACE_CLOCK, 2, 32000000);
+    tx(2 + 3);
+    CHECK(memcmp(out, "ab", 2) == 0);
+    CHECK_EQ(frame(out + 2, &ts), -1); // 3 bytes in
+    CHECK(trace_in_frame());
+    // a polled flush finishes the frame, then the text
+    log_write("cd", 2);
+    log_flush();
+    CHECK(!trace_in_frame());
+    CHECK_EQ(log_space(), LOG_BUFFER_SIZE);
+    nout = 0;
+    TRACE(TRACE_IDLE_EXIT, 0, 5);
+    tx(1000);
+    CHECK_EQ(nout, 15);
+    CHECK_EQ(frame(out, &ts), TRACE_IDLE_EXIT);
+
+    CHECK_EQ(trace_get_dropped(), 0);
+
+    TEST_END();
+}
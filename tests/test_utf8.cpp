@@ -0,0 +1,159 @@
+// Utf8Text onto the RA8875 model: UTF-8 decoded with invalid sequences
+// replaced, code points encoded into the ISO 8859-1...4 codings, the coding
+// register written only when the text needs another coding than the display
+// has, and characters no coding has printed from CGRAM
+
+#include "ra8875_model.h"
+#include "test.h"
+#include "Utf8Text.h"
+
+typedef RA8875T<Panel800x480> Display;
+
+static SPI_HandleTypeDef hspi;
+static Display d(&hspi, GPIOA, GPIO_PIN_4);
+
+// glyph of code point cp: rows cp, cp+1...
+static const uint8_t *source(uint16_t cp)
+{
+	static uint8_t bits[16];
+	for (int r = 0; r < 16; r++) bits[r] = cp + r;
+	return bits;
+}
+
+static uint32_t first(const char *s)
+{
+	return Utf8Text<Display, 4>::decode(s);
+}
+
+static uint8_t encode(uint32_t cp, uint8_t coding)
+{
+	return Utf8Text<Display, 4>::encode(cp, coding);
+}
+
+// text shown on 8x16 cell row r from column c
+static bool shows(int r, int c, const char *s)
+{
+	return memcmp(&ra.text[r][c], s, strlen(s)) == 0;
+}
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+
+	// decode: one to four bytes, anything else U+FFFD
+	CHECK_EQ(first("A"), 'A');
+	CHECK_EQ(first("\xC3\xA9"), 0xE9);
+	CHECK_EQ(first("\xC5\x81"), 0x141);
+	CHECK_EQ(first("\xE2\x82\xAC"), 0x20AC);
+	CHECK_EQ(first("\xF0\x9F\x98\x80"), 0x1F600);
+	CHECK_EQ(first("\x80"), UTF8_INVALID);				// continuation alone
+	CHECK_EQ(first("\xC0\x80"), UTF8_INVALID);			// overlong
+	CHECK_EQ(first("\xED\xA0\x80"), UTF8_INVALID);		// surrogate
+	CHECK_EQ(first("\xF4\x90\x80\x80"), UTF8_INVALID);	// past U+10FFFF
+	CHECK_EQ(first("\xFF"), UTF8_INVALID);
+	// cut short: the next character is not swallowed
+	const char *s = "\xE2\x82" "A";
+	CHECK_EQ((Utf8Text<Display, 4>::decode(s)), UTF8_INVALID);
+	CHECK_EQ(*s, 'A');
+	s = "\xC3\xA9x";
+	Utf8Text<Display, 4>::decode(s);
+	CHECK_EQ(*s, 'x');
+
+	// encode: 8859-1 is the code point, 8859-2...4 through their tables
+	CHECK_EQ(encode(0xE9, 0), 0xE9);
+	CHECK_EQ(encode(0xFF, 0), 0xFF);
+	CHECK_EQ(encode(0x141, 0), 0);
+	CHECK_EQ(encode(0x141, 1), 0xA3);		// L stroke
+	CHECK_EQ(encode(0x17A, 1), 0xBC);		// z acute
+	CHECK_EQ(encode(0x126, 2), 0xA1);		// H stroke
+	CHECK_EQ(encode(0x126, 1), 0);
+	CHECK_EQ(encode(0x14A, 3), 0xBD);		// eng
+	CHECK_EQ(encode(0xF1, 1), 0);			// n tilde not in 8859-2
+	CHECK_EQ(encode(0xF1, 2), 0xF1);
+	CHECK_EQ(encode(0xF1, 3), 0);
+	CHECK_EQ(encode(0x9F, 0), 0);			// C1 controls aren't printable
+	CHECK_EQ(encode(0x20AC, 0) | encode(0x20AC, 1) | encode(0x20AC, 2) | encode(0x20AC, 3), 0);
+	// no two code points share a byte; 8859-3 leaves 7 bytes out
+	static const int defined[4] = {96, 96, 89, 96};
+	for (uint8_t k = 0; k < 4; k++) {
+		uint8_t seen[96] = {0};
+		int n = 0, twice = 0;
+		for (uint32_t cp = 0xA0; cp <= 0x2DD; cp++) {
+			uint8_t b = encode(cp, k);
+			if (!b) continue;
+			n++;
+			twice += seen[b - 0xA0]++ > 0;
+		}
+		CHECK_EQ(n, defined[k]);
+		CHECK_EQ(twice, 0);
+	}
+
+	Utf8Text<Display, 4> u(source, 200);
+
+	// the display already in 8859-2: Polish prints without a register write
+	d.setIntFontCoding(ISO_IEC_8859_2);
+	CHECK_EQ(d.getIntFontCoding(), ISO_IEC_8859_2);
+	d.setCursor(0, 0);
+	ra_count();
+	u.print(&d, "\xC5\x81\xC3\xB3" "d\xC5\xBA");	// Lodz, Polish letters
+	CHECK_EQ(ra.writes[RA8875_FNCR0], 0);
+	CHECK_EQ(u.switches(), 0);
+	CHECK(shows(0, 0, "\xA3\xF3" "d\xBC"));
+
+	// ASCII prints in whatever coding is set
+	d.setCursor(0, 16);
+	ra_count();
+	u.print(&d, "plain ascii");
+	CHECK_EQ(ra.writes[RA8875_FNCR0], 0);
+	CHECK(shows(1, 0, "plain ascii"));
+
+	// a character the coding lacks: one switch, kept for what follows
+	d.setCursor(0, 32);
+	ra_count();
+	u.print(&d, "a\xC3\xB1o \xC3\xB1" "a");	// a n-tilde o, n-tilde a
+	CHECK_EQ(ra.writes[RA8875_FNCR0], 1);
+	CHECK_EQ(u.switches(), 1);
+	CHECK_EQ(d.getIntFontCoding(), ISO_IEC_8859_1);
+	CHECK(shows(2, 0, "a\xF1o \xF1" "a"));
+
+	// set behind its back, the coding is read from the display again
+	d.setIntFontCoding(ISO_IEC_8859_4);
+	d.setCursor(0, 48);
+	ra_count();
+	u.print(&d, "\xC4\x85");	// a ogonek, 8859-4 has it too
+	CHECK_EQ(ra.writes[RA8875_FNCR0], 0);
+	CHECK(shows(3, 0, "\xB1"));
+
+	// mixed text: a switch where the coding changes, not per character
+	d.setCursor(0, 64);
+	ra_count();
+	u.print(&d, "\xC4\xA6\xC4\xA7 \xC5\x81\xC5\x82 \xC4\xA6");	// H h stroke, L l stroke, H stroke
+	printf("mixed text: %lu coding writes in %lu bytes\n", (unsigned long)ra.writes[RA8875_FNCR0],
+		(unsigned long)ra.bytes);
+	CHECK_EQ(ra.writes[RA8875_FNCR0], 3);
+	CHECK_EQ(u.switches(), 4);
+	CHECK(shows(4, 0, "\xA1\xB1 \xA3\xB3 \xA1"));
+
+	// no coding has it: from CGRAM, keyed by code point, then CGROM again
+	d.setCursor(0, 80);
+	ra_count();
+	u.print(&d, "\xE2\x82\xAC" "5");	// euro 5
+	CHECK_EQ(u.cache().uploads(), 1);
+	CHECK(u.cache().resident(0x20AC));
+	uint8_t a = ra.text[5][0];
+	CHECK(a >= 200);
+	for (int r = 0; r < 16; r++) CHECK_EQ(ra.cgram[a][r], (uint8_t)(0x20AC + r));
+	CHECK_EQ(ra.reg[RA8875_FNCR0] & 0x80, 0);
+	CHECK_EQ(ra.text[5][1], '5');
+	// again, from the cache
+	u.print(&d, "\xE2\x82\xAC");
+	CHECK_EQ(u.cache().uploads(), 1);
+	CHECK_EQ((uint8_t)ra.text[5][2], a);
+	// invalid bytes are U+FFFD, from CGRAM too
+	u.print(&d, "\xFF");
+	CHECK(u.cache().resident(UTF8_INVALID));
+
+	TEST_END();
+}
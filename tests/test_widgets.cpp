@@ -0,0 +1,161 @@
+// WidgetSet onto the RA8875 model: a change repaints only what it damaged,
+// nothing is sent when nothing changed, and the merge waste trades clip
+// rectangles for overdraw. Prints the SPI cost of typical updates
+
+#include "ra8875_model.h"
+#include "test.h"
+#include "Widgets.h"
+
+typedef RA8875T<Panel800x480> Display;
+
+static SPI_HandleTypeDef hspi;
+static Display d(&hspi, GPIOA, GPIO_PIN_4);
+
+// text shown on 8x16 cell row r from column c
+static bool shows(int r, int c, const char *s)
+{
+	return memcmp(&ra.text[r][c], s, strlen(s)) == 0;
+}
+
+static int pixels(int x, int y, int w, int h, uint16_t color)
+{
+	int n = 0;
+	for (int j = y; j < y + h; j++) for (int i = x; i < x + w; i++) n += ra_fb[j][i] == color;
+	return n;
+}
+
+// clip rects set by a paint, the last window write puts back the screen
+static uint32_t clips(void)
+{
+	return ra.writes[RA8875_HSAW0] ? ra.writes[RA8875_HSAW0] - 1 : 0;
+}
+
+static void cost(const char *what)
+{
+	printf("%-26s %5lu bytes %4lu transactions, %2lu clip rects\n", what, (unsigned long)ra.bytes,
+		(unsigned long)ra.transactions, (unsigned long)clips());
+}
+
+int main(void)
+{
+	host_reset();
+	ra_reset();
+	d.begin();
+
+	// a status screen: title, two buttons, a slider, a progress bar and a readout
+	WidgetSet<Display, 16> ui;
+	int8_t title = ui.addLabel(0, 0, 800, 32, "status", RA8875_WHITE, RA8875_BLUE);
+	int8_t start = ui.addButton(16, 48, 160, 48, "start", RA8875_WHITE, RA8875_BLACK);
+	int8_t stop = ui.addButton(192, 48, 160, 48, "stop", RA8875_WHITE, RA8875_BLACK);
+	int8_t level = ui.addSlider(16, 112, 400, 32, 0, 100, RA8875_GREEN, RA8875_BLACK);
+	int8_t bar = ui.addProgress(16, 160, 400, 16, 100, RA8875_YELLOW, RA8875_BLACK);
+	int8_t count = ui.addNumber(432, 160, 80, 16, "%5ld", RA8875_WHITE, RA8875_BLACK);
+	CHECK_EQ(ui.count(), 6);
+	CHECK(ui.dirty());
+
+	ra_count();
+	ui.paint(&d);
+	cost("first paint");
+	CHECK(!ui.dirty());
+	CHECK(pixels(16, 160, 400, 16, RA8875_BLACK) == 400 * 16);
+
+	// nothing changed, nothing sent
+	ra_count();
+	ui.setValue(bar, 0);
+	ui.setText(title, "status");
+	ui.paint(&d);
+	CHECK_EQ(ra.bytes, 0);
+
+	// the bar grows: only the strip between the old and the new end
+	ra_count();
+	ui.setValue(bar, 40);
+	ui.paint(&d);
+	cost("progress 0 -> 40");
+	CHECK_EQ(clips(), 1);
+	CHECK_EQ(pixels(16, 160, 160, 16, RA8875_YELLOW), 160 * 16);
+	CHECK_EQ(pixels(176, 160, 240, 16, RA8875_BLACK), 240 * 16);
+	uint32_t grow = ra.bytes;
+	ra_count();
+	ui.setValue(bar, 41);
+	ui.paint(&d);
+	cost("progress 40 -> 41");
+	CHECK(ra.bytes <= grow);
+	CHECK_EQ(pixels(16, 160, 164, 16, RA8875_YELLOW), 164 * 16);
+	// clamped
+	ui.setValue(bar, 500);
+	CHECK_EQ(ui.value(bar), 100);
+	ui.paint(&d);
+
+	// the readout is repainted whole, text isn't clipped
+	ra_count();
+	ui.setValue(count, 12345);
+	ui.paint(&d);
+	cost("readout");
+	CHECK(shows(10, 432 / 8 + 2, "12345"));
+
+	// a press repaints the button, not its neighbour
+	ra_count();
+	ui.setPressed(start, true);
+	ui.paint(&d);
+	cost("button press");
+	CHECK_EQ(clips(), 1);
+	CHECK_EQ(ra_reg16(RA8875_HEAW0), 799);	// clip rect back to the screen
+	CHECK(ui.hit(100, 70) == start);
+	CHECK(ui.hit(200, 70) == stop);
+	CHECK(ui.hit(180, 70) == -1);
+
+	// a slider moves its knob: the old and the new place
+	ra_count();
+	ui.setValue(level, ui.sliderValue(level, 300));
+	ui.paint(&d);
+	cost("slider move");
+	CHECK(ui.value(level) > 0);
+	CHECK(clips() <= 2);
+
+	// a typical update, several small changes at once
+	ra_count();
+	ui.setValue(bar, 60);
+	ui.setValue(count, 7);
+	ui.setText(title, "running");
+	ui.paint(&d);
+	cost("typical update");
+	CHECK(shows(0, (800 - 7 * 8) / 2 / 8, "running"));
+
+	// a label longer than its widget is cut to what fits, nothing printed
+	// outside it
+	WidgetSet<Display, 16> narrow;
+	narrow.addLabel(400, 256, 80, 16, "a long caption", RA8875_WHITE, RA8875_BLACK);
+	ra_count();
+	narrow.paint(&d);
+	CHECK(shows(16, 50, "a long cap"));
+	CHECK_EQ(ra.text[16][49], 0);
+	CHECK_EQ(ra.text[16][60], 0);
+	CHECK_EQ(ra.pixelBytes, 10);
+
+	// merge waste: two far apart changes stay two clip rects at 0,
+	// one box that repaints everything between them when large
+	WidgetSet<Display, 16> apart(0), merged(1000000);
+	WidgetSet<Display, 16> *sets[2] = {&apart, &merged};
+	uint32_t bytes[2], rects[2];
+	for (int k = 0; k < 2; k++) {
+		WidgetSet<Display, 16> &s = *sets[k];
+		int8_t a = s.addProgress(0, 400, 100, 16, 100, RA8875_RED, RA8875_BLACK);
+		int8_t b = s.addProgress(700, 400, 100, 16, 100, RA8875_RED, RA8875_BLACK);
+		s.addLabel(300, 400, 200, 16, "middle", RA8875_WHITE, RA8875_BLACK);
+		s.paint(&d);
+		ra_count();
+		s.setValue(a, 50);
+		s.setValue(b, 50);
+		s.paint(&d);
+		bytes[k] = ra.bytes;
+		rects[k] = clips();
+	}
+	printf("two bars apart: merge waste 0 %lu bytes in %lu clip rects, merged %lu bytes in %lu\n",
+		(unsigned long)bytes[0], (unsigned long)rects[0], (unsigned long)bytes[1], (unsigned long)rects[1]);
+	CHECK_EQ(rects[0], 2);
+	CHECK_EQ(rects[1], 1);
+	// the merged box takes the label between them along
+	CHECK(bytes[1] > bytes[0]);
+
+	TEST_END();
+}
@@ -0,0 +1,149 @@
+#!/usr/bin/env ruby
+# Convert a BDF font into a 2 or 4 bit anti-aliased FontFace (see
+# Src/panel/Font.h), written as a C header.
+#
+#   ruby tools/font_convert.rb [--bpp 4] [--scale 4] [--first 32] [--last 126]
+#                              [--kern pairs.txt] font.bdf name > name.h
+#
+# --scale N takes a BDF drawn N times the wanted size and averages each
+# N x N block into one coverage value, e.g. a TTF rendered at 4x with
+# otf2bdf. Kerning pairs, if any, are lines "A V -1" (characters or
+# decimal codes, pixels at the final size).
+
+require 'optparse'
+
+opts = { bpp: 4, scale: 1, first: 32, last: 126, kern: nil }
+OptionParser.new do |o|
+  o.banner = "Usage: font_convert.rb [options] font.bdf name"
+  o.on('--bpp BITS', Integer, 'coverage bits per pixel, 2 or 4 (default 4)') { |v| opts[:bpp] = v }
+  o.on('--scale N', Integer, 'the BDF is N times the output size (default 1)') { |v| opts[:scale] = v }
+  o.on('--first CODE', Integer, 'first character (default 32)') { |v| opts[:first] = v }
+  o.on('--last CODE', Integer, 'last character (default 126)') { |v| opts[:last] = v }
+  o.on('--kern FILE', 'kerning pairs') { |v| opts[:kern] = v }
+end.parse!
+abort 'need font.bdf and a name' if ARGV.size != 2
+abort 'bpp is 2 or 4' unless [2, 4].include?(opts[:bpp])
+bdf, name = ARGV
+s = opts[:scale]
+levels = (1 << opts[:bpp]) - 1
+
+# glyphs by code: dwidth, bbx [w, h, xoff, yoff], rows of bits (y down)
+ascent = descent = 0
+glyphs = {}
+cur = nil
+File.foreach(bdf) do |line|
+  f = line.split
+  next if f.empty?
+  case f[0]
+  when 'FONT_ASCENT' then ascent = f[1].to_i
+  when 'FONT_DESCENT' then descent = f[1].to_i
+  when 'STARTCHAR' then cur = { rows: [] }
+  when 'ENCODING' then cur[:code] = f[1].to_i
+  when 'DWIDTH' then cur[:dwidth] = f[1].to_i
+  when 'BBX' then cur[:bbx] = f[1, 4].map(&:to_i)
+  when 'BITMAP' then cur[:bitmap] = true
+  when 'ENDCHAR'
+    glyphs[cur[:code]] = cur if cur[:code] && cur[:code] >= 0
+    cur = nil
+  else
+    if cur && cur[:bitmap]
+      bits = f[0].hex.to_s(2).rjust(f[0].size * 4, '0')
+      cur[:rows] << bits.chars.map(&:to_i)
+    end
+  end
+end
+
+# hi-res pixel (x right, y up from the baseline) to output cells of s x s,
+# y of the output grows down
+def cells(g, s)
+  w, h, xo, yo = g[:bbx]
+  cov = Hash.new(0)
+  h.times do |r|
+    y = yo + h - 1 - r
+    w.times do |c|
+      next if g[:rows][r][c] != 1
+      cov[[(xo + c).div(s), -(y.div(s)) - 1]] += 1
+    end
+  end
+  cov
+end
+
+bitmaps = []
+table = []
+(opts[:first]..opts[:last]).each do |code|
+  g = glyphs[code]
+  unless g
+    table << [bitmaps.size, 0, 0, 0, 0, 0, code]
+    next
+  end
+  advance = (g[:dwidth].to_f / s).round
+  cov = cells(g, s)
+  if cov.empty?
+    table << [bitmaps.size, 0, 0, 0, 0, advance, code]
+    next
+  end
+  x0, x1 = cov.keys.map(&:first).minmax
+  y0, y1 = cov.keys.map(&:last).minmax
+  w = x1 - x0 + 1
+  h = y1 - y0 + 1
+  px = []
+  (y0..y1).each do |y|
+    (x0..x1).each { |x| px << ((cov[[x, y]] * levels).to_f / (s * s)).round }
+  end
+  per = 8 / opts[:bpp]
+  offset = bitmaps.size
+  px.each_slice(per) do |sl|
+    b = 0
+    per.times { |i| b = (b << opts[:bpp]) | (sl[i] || 0) }
+    bitmaps << b
+  end
+  table << [offset, w, h, x0, y0, advance, code]
+end
+
+kerns = []
+if opts[:kern]
+  File.foreach(opts[:kern]) do |line|
+    f = line.split
+    next if f.size != 3 || f[0].start_with?('#')
+    l, r = f[0, 2].map { |c| c.size == 1 ? c.ord : c.to_i }
+    kerns << [l, r, f[2].to_i]
+  end
+  kerns.sort!
+end
+
+up = (ascent.to_f / s).ceil
+height = up + (descent.to_f / s).ceil
+
+def chr_comment(code)
+  code >= 32 && code < 127 && code != 92 ? " // '#{code.chr}'" : " // #{code}"
+end
+
+puts "// generated by tools/font_convert.rb from #{File.basename(bdf)}, #{opts[:bpp]} bpp"
+puts "// #{table.size} glyphs, #{bitmaps.size} bytes of bitmaps"
+puts
+puts "#ifndef _FONT_#{name.upcase}_H_"
+puts "#define _FONT_#{name.upcase}_H_"
+puts
+puts '#include "Font.h"'
+puts
+puts "static const uint8_t #{name}_bitmaps[] = {"
+bitmaps.each_slice(16) { |sl| puts "\t" + sl.map { |b| format('0x%02x', b) }.join(',') + ',' }
+puts '};'
+puts
+puts "static const FontGlyph #{name}_glyphs[] = {"
+table.each do |o, w, h, x, y, a, code|
+  puts "\t{#{o}, #{w}, #{h}, #{x}, #{y}, #{a}},#{chr_comment(code)}"
+end
+puts '};'
+puts
+unless kerns.empty?
+  puts "static const FontKern #{name}_kerns[] = {"
+  kerns.each { |l, r, dx| puts "\t{#{l}, #{r}, #{dx}}," }
+  puts '};'
+  puts
+end
+kref = kerns.empty? ? '0' : "#{name}_kerns"
+puts "static const FontFace #{name} = { #{opts[:bpp]}, #{opts[:first]}, #{opts[:last]}, #{height}, #{up}, " \
+     "#{name}_glyphs, #{name}_bitmaps, #{kref}, #{kerns.size} };"
+puts
+puts '#endif'
@@ -0,0 +1,106 @@
+#!/usr/bin/env ruby
+# Decode a raw USART1 capture of the binary trace (see Src/Trace.h) into a
+# timeline and latency histograms.
+#
+#   ruby tools/trace_decode.rb [--mhz 16] [--bucket 500] [--quiet] capture.bin
+#
+# Frames are 0xA5 0x5A ts(4) id(2) a(2) b(4) sum(1), anything else in the
+# capture (the text log) is skipped.
+
+require 'optparse'
+
+# keep in step with enum trace_event_id in Src/Trace.h
+EVENTS = %w(NONE TOUCH_IRQ TOUCH_DECODED I2C_START I2C_DONE SPI_START SPI_DONE
+            WAITPOLL FRAME_START FRAME_END PIXEL CLOCK IDLE_ENTER IDLE_EXIT)
+
+opts = { mhz: 16.0, bucket: 500, quiet: false }
+OptionParser.new do |o|
+  o.banner = "Usage: trace_decode.rb [options] capture.bin"
+  o.on('--mhz MHZ', Float, 'core clock until the first CLOCK event (default 16, the boot profile)') { |v| opts[:mhz] = v }
+  o.on('--bucket US', Integer, 'histogram bucket width in us (default 500)') { |v| opts[:bucket] = v }
+  o.on('--quiet', 'only print the histograms') { opts[:quiet] = true }
+end.parse!
+
+data = ARGF.binmode.read.bytes
+
+records = []
+bad = 0
+i = 0
+while i + 15 <= data.size
+  if data[i] == 0xA5 && data[i + 1] == 0x5A
+    payload = data[i + 2, 12]
+    if (payload.sum & 0xFF) == data[i + 14]
+      ts, id, a, b = payload.pack('C*').unpack('VvvV')
+      records << [ts, id, a, b]
+      i += 15
+      next
+    end
+    bad += 1
+  end
+  i += 1
+end
+
+# cycle stamps to us, the clock changes with the profile and the counter
+# pauses in Sleep/Stop, resync to the HAL tick when coming out of idle
+hz = opts[:mhz] * 1_000_000
+now_us = 0.0
+last_ts = nil
+timeline = []
+records.each do |ts, id, a, b|
+  if last_ts
+    d = (ts - last_ts) & 0xFFFFFFFF
+    d -= 0x1_0000_0000 if d >= 0x8000_0000 # slightly out of order when preempted
+    now_us += d * 1_000_000.0 / hz
+  end
+  last_ts = ts
+  name = EVENTS[id] || "EVENT_#{id}"
+  case name
+  when 'CLOCK' then hz = b.to_f
+  when 'IDLE_EXIT' then now_us = [now_us, b * 1000.0].max
+  end
+  timeline << [now_us, name, a, b]
+end
+
+unless opts[:quiet]
+  timeline.each do |t, name, a, b|
+    printf("%12.1f us  %-14s a=%-5d b=%d\n", t, name, a, b)
+  end
+  puts
+end
+
+# pair each touch IRQ with the decode and the first pixel that follow it
+lat = { 'irq->decode' => [], 'decode->pixel' => [], 'irq->pixel' => [] }
+irq = decoded = nil
+timeline.each do |t, name, _a, _b|
+  case name
+  when 'TOUCH_IRQ'
+    irq = t
+    decoded = nil
+  when 'TOUCH_DECODED'
+    if irq
+      decoded = t
+      lat['irq->decode'] << t - irq
+    end
+  when 'PIXEL'
+    if irq && decoded
+      lat['decode->pixel'] << t - decoded
+      lat['irq->pixel'] << t - irq
+      irq = decoded = nil
+    end
+  end
+end
+
+puts "#{records.size} records, #{bad} bad frames"
+lat.each do |label, v|
+  next if v.empty?
+  v.sort!
+  p99 = v[[(v.size * 0.99).ceil - 1, 0].max]
+  printf("\n%s: n=%d min=%.0f avg=%.0f p99=%.0f max=%.0f us\n", label, v.size, v.first, v.sum / v.size, p99, v.last)
+  hist = Hash.new(0)
+  v.each { |x| hist[(x / opts[:bucket]).floor] += 1 }
+  peak = hist.values.max
+  hist.keys.sort.each do |k|
+    bar = '#' * (hist[k] * 50.0 / peak).ceil
+    printf("  %7d-%-7d %6d %s\n", k * opts[:bucket], (k + 1) * opts[:bucket], hist[k], bar)
+  end
+end